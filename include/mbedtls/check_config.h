@@ -200,6 +200,21 @@
 #error "MBEDTLS_ECP_RESTARTABLE defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)           && \
+    ( !defined(MBEDTLS_ECP_C) || defined(MBEDTLS_ECP_ALT) )
+#error "MBEDTLS_ECP_GROUP_CACHE defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)          && \
+    ( !defined(MBEDTLS_ECP_C) || defined(MBEDTLS_ECP_ALT) )
+#error "MBEDTLS_ECP_PUBKEY_CACHE defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE) && defined(MBEDTLS_ECP_PUBKEY_CACHE_SIZE) && \
+    MBEDTLS_ECP_PUBKEY_CACHE_SIZE < 1
+#error "MBEDTLS_ECP_PUBKEY_CACHE_SIZE must be at least 1"
+#endif
+
 #if defined(MBEDTLS_ECDSA_DETERMINISTIC) && !defined(MBEDTLS_HMAC_DRBG_C)
 #error "MBEDTLS_ECDSA_DETERMINISTIC defined, but not all prerequisites"
 #endif
@@ -806,6 +821,24 @@
 #error "MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_ONLY defined on non-Armv8-A system"
 #endif
 
+#if defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
+#if !defined(MBEDTLS_SHA256_C)
+#error "MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT defined without MBEDTLS_SHA256_C"
+#endif
+#if defined(MBEDTLS_SHA256_ALT) || defined(MBEDTLS_SHA256_PROCESS_ALT)
+#error "MBEDTLS_SHA256_*ALT can't be used with MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT"
+#endif
+#endif
+
+#if defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+#if !defined(MBEDTLS_SHA1_C)
+#error "MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT defined without MBEDTLS_SHA1_C"
+#endif
+#if defined(MBEDTLS_SHA1_ALT) || defined(MBEDTLS_SHA1_PROCESS_ALT)
+#error "MBEDTLS_SHA1_*ALT can't be used with MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT"
+#endif
+#endif
+
 /* TLS 1.3 requires separate HKDF parts from PSA,
  * and at least one ciphersuite, so at least SHA-256 or SHA-384
  * from PSA to use with HKDF.
@@ -921,11 +954,20 @@
 #error "MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE  defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SSL_DEMUX_C) && !defined(MBEDTLS_SSL_PROTO_DTLS)
+#error "MBEDTLS_SSL_DEMUX_C defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY) &&                              \
     ( !defined(MBEDTLS_SSL_TLS_C) || !defined(MBEDTLS_SSL_PROTO_DTLS) )
 #error "MBEDTLS_SSL_DTLS_ANTI_REPLAY  defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SSL_DTLS_REPLAY_WINDOW) &&                            \
+    ( MBEDTLS_SSL_DTLS_REPLAY_WINDOW < 64 || MBEDTLS_SSL_DTLS_REPLAY_WINDOW % 64 != 0 )
+#error "MBEDTLS_SSL_DTLS_REPLAY_WINDOW must be a positive multiple of 64"
+#endif
+
 #if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID) &&                              \
     ( !defined(MBEDTLS_SSL_TLS_C) || !defined(MBEDTLS_SSL_PROTO_DTLS) )
 #error "MBEDTLS_SSL_DTLS_CONNECTION_ID  defined, but not all prerequisites"
@@ -987,6 +1029,10 @@
 #error "MBEDTLS_SSL_TLS1_3_TICKET_NONCE_LENGTH must be less than 256"
 #endif
 
+#if defined(MBEDTLS_SSL_CACHE_SHARDS) && MBEDTLS_SSL_CACHE_SHARDS < 1
+#error "MBEDTLS_SSL_CACHE_SHARDS must be at least 1"
+#endif
+
 #if defined(MBEDTLS_SSL_SERVER_NAME_INDICATION) && \
         !defined(MBEDTLS_X509_CRT_PARSE_C)
 #error "MBEDTLS_SSL_SERVER_NAME_INDICATION defined, but not all prerequisites"
@@ -1051,6 +1097,11 @@
 #error "MBEDTLS_X509_CSR_WRITE_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX) && \
+            ( !defined(MBEDTLS_X509_CRT_PARSE_C) )
+#error "MBEDTLS_X509_TRUSTED_CA_INDEX defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK) && \
             ( !defined(MBEDTLS_X509_CRT_PARSE_C) )
 #error "MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK defined, but not all prerequisites"
@@ -1073,6 +1124,16 @@
 #error "MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL) && !defined(MBEDTLS_SSL_TLS_C)
+#error "MBEDTLS_SSL_BUFFER_POOL defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL) &&                                  \
+    ( !defined(MBEDTLS_SSL_TLS_C) ||                                        \
+      ( !defined(MBEDTLS_USE_PSA_CRYPTO) && !defined(MBEDTLS_SSL_PROTO_TLS1_3) ) )
+#error "MBEDTLS_SSL_KEY_SHARE_POOL defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_SSL_RECORD_SIZE_LIMIT) && ( !defined(MBEDTLS_SSL_PROTO_TLS1_3) )
 #error "MBEDTLS_SSL_RECORD_SIZE_LIMIT defined, but not all prerequisites"
 #endif
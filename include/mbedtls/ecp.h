@@ -307,6 +307,17 @@ mbedtls_ecp_group;
 #define MBEDTLS_ECP_FIXED_POINT_OPTIM  1   /**< Enable fixed-point speed-up. */
 #endif /* MBEDTLS_ECP_FIXED_POINT_OPTIM */
 
+#if !defined(MBEDTLS_ECP_PUBKEY_CACHE_SIZE)
+/*
+ * Number of public keys whose comb tables MBEDTLS_ECP_PUBKEY_CACHE keeps,
+ * at least 1.
+ *
+ * Each table holds 2^(w - 1) points, with w at most MBEDTLS_ECP_WINDOW_SIZE:
+ * with the default window size, about 1 kB for a 256-bit curve.
+ */
+#define MBEDTLS_ECP_PUBKEY_CACHE_SIZE  8   /**< Number of cached public keys. */
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE_SIZE */
+
 /** \} name SECTION: Module settings */
 
 #else  /* MBEDTLS_ECP_ALT */
@@ -872,6 +883,34 @@ int mbedtls_ecp_tls_write_point(const mbedtls_ecp_group *grp,
  */
 int mbedtls_ecp_group_load(mbedtls_ecp_group *grp, mbedtls_ecp_group_id id);
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+/**
+ * \brief           This function frees the cached comb tables.
+ *
+ *                  With #MBEDTLS_ECP_GROUP_CACHE, the table of multiples of
+ *                  the generator that a group loaded with
+ *                  mbedtls_ecp_group_load() computes is kept for all the
+ *                  groups of the same curve, including those loaded later,
+ *                  until this function is called. Call it at shutdown to
+ *                  release that memory. The tables that other threads are
+ *                  using at the time stay cached.
+ */
+void mbedtls_ecp_group_cache_flush(void);
+#endif /* MBEDTLS_ECP_GROUP_CACHE */
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+/**
+ * \brief           This function empties the cache of public key tables.
+ *
+ *                  With #MBEDTLS_ECP_PUBKEY_CACHE, mbedtls_ecp_muladd()
+ *                  keeps comb tables for the most recently used public keys
+ *                  until they are evicted by other keys, or until this
+ *                  function is called. Call it at shutdown to release that
+ *                  memory, or when the keys in use change for good.
+ */
+void mbedtls_ecp_pubkey_cache_flush(void);
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE */
+
 /**
  * \brief           This function sets up an ECP group context from a TLS
  *                  ECParameters record as defined in RFC 4492, Section 5.4.
@@ -838,6 +838,60 @@
  */
 //#define MBEDTLS_ECP_RESTARTABLE
 
+/**
+ * \def MBEDTLS_ECP_GROUP_CACHE
+ *
+ * Share the table of precomputed multiples of the generator between all the
+ * groups loaded with mbedtls_ecp_group_load(), process-wide.
+ *
+ * Groups loaded from the built-in curves keep their domain parameters in
+ * static constants, and with MBEDTLS_ECP_FIXED_POINT_OPTIM set to 1 their
+ * comb tables are static too. When MBEDTLS_ECP_FIXED_POINT_OPTIM is set
+ * to 0 to save code size, every multiplication of the generator computes a
+ * fresh table on the heap. With this option, the first such multiplication
+ * on each curve keeps its table in a cache that later multiplications use,
+ * so that ECDSA signatures, ECDH key generation and the generator half of
+ * ECDSA verification get the fixed-point speed-up at the cost of one table
+ * per curve in RAM. Groups are not modified, so a group can still be shared
+ * between threads. mbedtls_ecp_group_cache_flush() frees the tables.
+ *
+ * The cache is thread-safe when MBEDTLS_THREADING_C is enabled.
+ *
+ * Requires: MBEDTLS_ECP_C
+ * Module:   library/ecp.c
+ *
+ * Uncomment this macro to share comb tables between groups.
+ */
+//#define MBEDTLS_ECP_GROUP_CACHE
+
+/**
+ * \def MBEDTLS_ECP_PUBKEY_CACHE
+ *
+ * Keep comb tables for the public keys that mbedtls_ecp_muladd() is called
+ * with, in a process-wide cache of the MBEDTLS_ECP_PUBKEY_CACHE_SIZE most
+ * recently used keys.
+ *
+ * ECDSA verification computes u1 * G + u2 * Q, and normally precomputes
+ * multiples of Q for every signature. With this option, a key gets a table
+ * the second time it is used, and later verifications against that key use
+ * the comb method for both G and Q, which shares far fewer doublings between
+ * the two scalars. Keys that are only used once cost a lookup in the cache.
+ * This applies to the legacy ECDSA API as well as to PSA.
+ *
+ * The comb table of the generator must be available too: this has no effect
+ * when MBEDTLS_ECP_FIXED_POINT_OPTIM is 0, unless MBEDTLS_ECP_GROUP_CACHE is
+ * enabled. Restartable operations (see MBEDTLS_ECP_RESTARTABLE) don't use the
+ * cache. mbedtls_ecp_pubkey_cache_flush() frees the cached tables.
+ *
+ * The cache is thread-safe when MBEDTLS_THREADING_C is enabled.
+ *
+ * Requires: MBEDTLS_ECP_C
+ * Module:   library/ecp.c
+ *
+ * Uncomment this macro to cache the comb tables of public keys.
+ */
+//#define MBEDTLS_ECP_PUBKEY_CACHE
+
 /**
  * Uncomment to enable using new bignum code in the ECC modules.
  *
@@ -1622,6 +1676,43 @@
  */
 //#define MBEDTLS_SSL_ASYNC_PRIVATE
 
+/**
+ * \def MBEDTLS_SSL_BUFFER_POOL
+ *
+ * Enable a pool of I/O buffers that can be shared between TLS connections,
+ * see mbedtls_ssl_conf_buffer_pool().
+ *
+ * When a pool is configured, a connection hands its input and output
+ * buffers back to the pool whenever no record is partially received, pending
+ * or partially sent, and takes buffers from the pool again on its next read
+ * or write. This lowers the memory used by a server with many idle
+ * connections. It has no effect on DTLS connections.
+ *
+ * Requires: MBEDTLS_SSL_TLS_C
+ *
+ * Uncomment this macro to enable shared I/O buffer pools.
+ */
+//#define MBEDTLS_SSL_BUFFER_POOL
+
+/**
+ * \def MBEDTLS_SSL_KEY_SHARE_POOL
+ *
+ * Enable a pool of ephemeral ECDH key pairs generated ahead of time, see
+ * mbedtls_ssl_conf_key_share_pool().
+ *
+ * The application keeps the pool filled with
+ * mbedtls_ssl_key_share_pool_refill(), from a background thread or when it
+ * is idle, and handshakes take their ECDHE keys from it instead of
+ * generating them. This takes key generation off the critical path of the
+ * handshake.
+ *
+ * Requires: MBEDTLS_SSL_TLS_C, and MBEDTLS_USE_PSA_CRYPTO or
+ *           MBEDTLS_SSL_PROTO_TLS1_3
+ *
+ * Uncomment this macro to enable ephemeral key pools.
+ */
+//#define MBEDTLS_SSL_KEY_SHARE_POOL
+
 /** \def MBEDTLS_SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME
  *
  * In TLS clients, when a client authenticates a server through its
@@ -2260,6 +2351,24 @@
  */
 #define MBEDTLS_VERSION_FEATURES
 
+/**
+ * \def MBEDTLS_X509_TRUSTED_CA_INDEX
+ *
+ * If set, this enables the X.509 API `mbedtls_x509_crt_build_ca_index()`,
+ * which indexes a list of trusted certificates by subject name. The
+ * certificate verification functions use the index automatically when the
+ * list of trusted certificates passed to them has one, so that looking up
+ * the issuer of a certificate does not scan the whole list.
+ *
+ * This is useful when a large number of trusted certificates is configured,
+ * for example a system-wide CA bundle.
+ *
+ * Requires: MBEDTLS_X509_CRT_PARSE_C
+ *
+ * Uncomment to enable indexing of trusted certificates.
+ */
+//#define MBEDTLS_X509_TRUSTED_CA_INDEX
+
 /**
  * \def MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK
  *
@@ -3424,6 +3533,28 @@
  */
 #define MBEDTLS_SHA1_C
 
+/**
+ * \def MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT
+ *
+ * Enable acceleration of the SHA-1 cryptographic hash algorithm with the x86
+ * SHA extensions (SHA-NI) if they are available at runtime. If not, the
+ * library will fall back to the C implementation.
+ *
+ * \note If MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT is defined when building
+ * for a non-x86 target it will be silently ignored.
+ *
+ * \note    Minimum compiler versions for this feature are Clang 5.0 or
+ * GCC 4.9. Visual Studio is also supported.
+ *
+ * Requires: MBEDTLS_SHA1_C.
+ *
+ * Module:  library/sha1.c
+ *
+ * Uncomment to have the library check for the x86 SHA extensions and use them
+ * if available.
+ */
+//#define MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT
+
 /**
  * \def MBEDTLS_SHA224_C
  *
@@ -3536,6 +3667,28 @@
  */
 //#define MBEDTLS_SHA256_USE_A64_CRYPTO_ONLY
 
+/**
+ * \def MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT
+ *
+ * Enable acceleration of the SHA-256 and SHA-224 cryptographic hash algorithms
+ * with the x86 SHA extensions (SHA-NI) if they are available at runtime.
+ * If not, the library will fall back to the C implementation.
+ *
+ * \note If MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT is defined when building
+ * for a non-x86 target it will be silently ignored.
+ *
+ * \note    Minimum compiler versions for this feature are Clang 5.0 or
+ * GCC 4.9. Visual Studio is also supported.
+ *
+ * Requires: MBEDTLS_SHA256_C.
+ *
+ * Module:  library/sha256.c
+ *
+ * Uncomment to have the library check for the x86 SHA extensions and use them
+ * if available.
+ */
+//#define MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT
+
 /**
  * \def MBEDTLS_SHA384_C
  *
@@ -3656,6 +3809,20 @@
  */
 #define MBEDTLS_SSL_COOKIE_C
 
+/**
+ * \def MBEDTLS_SSL_DEMUX_C
+ *
+ * Enable a DTLS server helper that routes the datagrams received on one
+ * socket to the SSL context of their peer, by connection ID when the peer
+ * uses one and by address otherwise.
+ *
+ * Module:  library/ssl_demux.c
+ * Caller:
+ *
+ * Requires: MBEDTLS_SSL_PROTO_DTLS
+ */
+#define MBEDTLS_SSL_DEMUX_C
+
 /**
  * \def MBEDTLS_SSL_TICKET_C
  *
@@ -4075,6 +4242,7 @@
 /* ECP options */
 //#define MBEDTLS_ECP_WINDOW_SIZE            4 /**< Maximum window size used */
 //#define MBEDTLS_ECP_FIXED_POINT_OPTIM      1 /**< Enable fixed-point speed-up */
+//#define MBEDTLS_ECP_PUBKEY_CACHE_SIZE      8 /**< Number of public keys in the cache of MBEDTLS_ECP_PUBKEY_CACHE */
 
 /* Entropy options */
 //#define MBEDTLS_ENTROPY_MAX_SOURCES                20 /**< Maximum number of sources supported */
@@ -4222,6 +4390,7 @@
 /* SSL Cache options */
 //#define MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT       86400 /**< 1 day  */
 //#define MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES      50 /**< Maximum entries in cache */
+//#define MBEDTLS_SSL_CACHE_SHARDS                    1 /**< Number of independently locked cache partitions */
 
 /* SSL options */
 
@@ -4296,6 +4465,27 @@
  */
 //#define MBEDTLS_SSL_OUT_CONTENT_LEN             16384
 
+/** \def MBEDTLS_SSL_OUT_BUFFER_RECORDS
+ *
+ * Number of full-size protected records the outgoing TLS I/O buffer can hold.
+ *
+ * With a value larger than 1, the outgoing buffer is made large enough for
+ * that many records of up to #MBEDTLS_SSL_OUT_CONTENT_LEN bytes of plaintext
+ * each. Connections which enable write batching with
+ * mbedtls_ssl_conf_write_batching() then encrypt up to that many records
+ * back to back in a single call to mbedtls_ssl_write() and hand them to the
+ * send callback together, which saves system calls on bulk transfers.
+ * TLS handshakes also keep the records of a flight in the outgoing buffer
+ * while there is room for another full record, and send the flight with as
+ * few calls to the send callback as possible.
+ *
+ * The outgoing buffer of every SSL context grows accordingly, so only raise
+ * this if the RAM is available.
+ *
+ * Uncomment to set the number of records the outgoing I/O buffer can hold.
+ */
+//#define MBEDTLS_SSL_OUT_BUFFER_RECORDS          1
+
 /** \def MBEDTLS_SSL_DTLS_MAX_BUFFERING
  *
  * Maximum number of heap-allocated bytes for the purpose of
@@ -4313,8 +4503,23 @@
  */
 //#define MBEDTLS_SSL_DTLS_MAX_BUFFERING             32768
 
+/** \def MBEDTLS_SSL_DTLS_REPLAY_WINDOW
+ *
+ * Size in bits of the DTLS anti-replay window: how far behind the most
+ * recent record a record may arrive and still be accepted.
+ *
+ * RFC 6347 asks for at least 32 and recommends 64, which is enough for
+ * most links. Links with a high packet rate and reordering, for example
+ * over several paths, may need 1024 bits or more. Each SSL context uses
+ * 8 bytes per 64 bits of window, plus 8 bytes.
+ *
+ * Must be a multiple of 64.
+ */
+//#define MBEDTLS_SSL_DTLS_REPLAY_WINDOW             64
+
 //#define MBEDTLS_PSK_MAX_LEN               32 /**< Max size of TLS pre-shared keys, in bytes (default 256 or 384 bits) */
 //#define MBEDTLS_SSL_COOKIE_TIMEOUT        60 /**< Default expiration delay of DTLS cookies, in seconds if HAVE_TIME, or in number of cookies issued */
+//#define MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN    128 /**< Maximum length of a peer address in the DTLS demultiplexer, e.g. a struct sockaddr */
 
 /**
  * Complete list of ciphersuites to use, in order of preference.
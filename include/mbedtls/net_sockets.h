@@ -69,6 +69,9 @@
 #define MBEDTLS_NET_POLL_READ  1 /**< Used in \c mbedtls_net_poll to check for pending data  */
 #define MBEDTLS_NET_POLL_WRITE 2 /**< Used in \c mbedtls_net_poll to check if write possible */
 
+#define MBEDTLS_NET_BATCH_MAX    64  /**< Maximum number of datagrams per batch. */
+#define MBEDTLS_NET_ADDR_MAX_LEN 128 /**< Room for any socket address. */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -91,6 +94,21 @@ typedef struct mbedtls_net_context {
 }
 mbedtls_net_context;
 
+/**
+ * A datagram for mbedtls_net_recv_batch() and mbedtls_net_send_batch().
+ */
+typedef struct mbedtls_net_datagram {
+    unsigned char *buf;     /*!< The payload buffer. */
+    size_t size;            /*!< The size of \c buf (receive only). */
+    size_t len;             /*!< The length of the payload. */
+    /** The peer address, as a \c struct \c sockaddr. Its offset is a
+     * multiple of the alignment of \c size_t, which suffices for socket
+     * addresses on supported platforms. */
+    unsigned char addr[MBEDTLS_NET_ADDR_MAX_LEN];
+    size_t addr_len;        /*!< The length of \c addr. */
+}
+mbedtls_net_datagram;
+
 /**
  * \brief          Initialize a context
  *                 Just makes the context ready to be used or freed safely.
@@ -136,6 +154,40 @@ int mbedtls_net_connect(mbedtls_net_context *ctx, const char *host, const char *
  */
 int mbedtls_net_bind(mbedtls_net_context *ctx, const char *bind_ip, const char *port, int proto);
 
+/**
+ * \brief          Create \p count receiving sockets sharing bind_ip:port,
+ *                 so that incoming connections (TCP) or datagrams (UDP)
+ *                 are spread among them by the operating system.
+ *
+ *                 This is meant for servers with several worker threads,
+ *                 each accepting connections on its own socket instead of
+ *                 contending for a single one. It relies on the
+ *                 \c SO_REUSEPORT socket option; on Linux, the kernel
+ *                 balances new connections across the sockets.
+ *
+ * \param ctx      Array of \p count sockets to use
+ * \param count    Number of sockets to create. This must be at least 1.
+ * \param bind_ip  IP to bind to, can be NULL
+ * \param port     Port number to use. If it is "0", all the sockets share
+ *                 the same ephemeral port.
+ * \param proto    Protocol: MBEDTLS_NET_PROTO_TCP or MBEDTLS_NET_PROTO_UDP
+ *
+ * \return         0 if successful, or one of:
+ *                      MBEDTLS_ERR_NET_BAD_INPUT_DATA,
+ *                      MBEDTLS_ERR_NET_SOCKET_FAILED,
+ *                      MBEDTLS_ERR_NET_UNKNOWN_HOST,
+ *                      MBEDTLS_ERR_NET_BIND_FAILED,
+ *                      MBEDTLS_ERR_NET_LISTEN_FAILED
+ *
+ * \note           On failure, none of the sockets is left open.
+ *
+ * \note           On platforms without \c SO_REUSEPORT, this function
+ *                 fails with MBEDTLS_ERR_NET_SOCKET_FAILED if \p count is
+ *                 larger than 1.
+ */
+int mbedtls_net_bind_reuseport(mbedtls_net_context *ctx, size_t count,
+                               const char *bind_ip, const char *port, int proto);
+
 /**
  * \brief           Accept a connection from a remote client
  *
@@ -158,6 +210,29 @@ int mbedtls_net_accept(mbedtls_net_context *bind_ctx,
                        mbedtls_net_context *client_ctx,
                        void *client_ip, size_t buf_size, size_t *cip_len);
 
+/**
+ * \brief           Accept a connection from a remote client and make the
+ *                  client socket non-blocking
+ *
+ *                  This is equivalent to mbedtls_net_accept() followed by
+ *                  mbedtls_net_set_nonblock() on \p client_ctx. On Linux,
+ *                  TCP connections are accepted with accept4(), which
+ *                  creates the socket non-blocking and close-on-exec in a
+ *                  single system call.
+ *
+ * \param bind_ctx  Relevant socket
+ * \param client_ctx Will contain the connected client socket
+ * \param client_ip Will contain the client IP address, can be NULL
+ * \param buf_size  Size of the client_ip buffer
+ * \param cip_len   Will receive the size of the client IP written,
+ *                  can be NULL if client_ip is null
+ *
+ * \return          The same values as mbedtls_net_accept().
+ */
+int mbedtls_net_accept_nonblock(mbedtls_net_context *bind_ctx,
+                                mbedtls_net_context *client_ctx,
+                                void *client_ip, size_t buf_size, size_t *cip_len);
+
 /**
  * \brief          Check and wait for the context to be ready for read/write
  *
@@ -270,6 +345,54 @@ int mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len);
 int mbedtls_net_recv_timeout(void *ctx, unsigned char *buf, size_t len,
                              uint32_t timeout);
 
+/**
+ * \brief          Receive several datagrams with as few system calls as
+ *                 possible.
+ *
+ *                 On Linux, this is a single call to recvmmsg(). Elsewhere,
+ *                 datagrams are received one at a time, stopping as soon as
+ *                 none is queued.
+ *
+ * \param ctx      UDP socket, usually unconnected
+ * \param dgrams   Array of \p count datagrams. The \c buf and \c size
+ *                 fields must be set on input. On output, \c len,
+ *                 \c addr and \c addr_len are set for each datagram
+ *                 received.
+ * \param count    Number of entries in \p dgrams, between 1 and
+ *                 #MBEDTLS_NET_BATCH_MAX
+ *
+ * \return         The number of datagrams received, which is at least 1,
+ *                 or a negative error code; with a non-blocking socket,
+ *                 MBEDTLS_ERR_SSL_WANT_READ indicates no datagram is queued.
+ *
+ * \note           On a blocking socket, this function waits for the first
+ *                 datagram only.
+ */
+int mbedtls_net_recv_batch(mbedtls_net_context *ctx,
+                           mbedtls_net_datagram *dgrams, size_t count);
+
+/**
+ * \brief          Send several datagrams with as few system calls as
+ *                 possible.
+ *
+ *                 On Linux, this is a single call to sendmmsg(). Elsewhere,
+ *                 datagrams are sent one at a time.
+ *
+ * \param ctx      UDP socket
+ * \param dgrams   Array of \p count datagrams, each with \c buf, \c len,
+ *                 \c addr and \c addr_len set. If \c addr_len is 0, the
+ *                 datagram goes to the peer of the connected socket.
+ * \param count    Number of entries in \p dgrams, between 1 and
+ *                 #MBEDTLS_NET_BATCH_MAX
+ *
+ * \return         The number of datagrams sent, which may be less than
+ *                 \p count, or a negative error code; with a non-blocking
+ *                 socket, MBEDTLS_ERR_SSL_WANT_WRITE indicates none could be
+ *                 sent without blocking.
+ */
+int mbedtls_net_send_batch(mbedtls_net_context *ctx,
+                           const mbedtls_net_datagram *dgrams, size_t count);
+
 /**
  * \brief          Closes down the connection and free associated data
  *
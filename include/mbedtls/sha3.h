@@ -40,6 +40,8 @@ typedef enum {
     MBEDTLS_SHA3_256, /*!< SHA3-256 */
     MBEDTLS_SHA3_384, /*!< SHA3-384 */
     MBEDTLS_SHA3_512, /*!< SHA3-512 */
+    MBEDTLS_SHA3_SHAKE128, /*!< SHAKE128 */
+    MBEDTLS_SHA3_SHAKE256, /*!< SHAKE256 */
 } mbedtls_sha3_id;
 
 /**
@@ -52,6 +54,7 @@ typedef struct {
     uint32_t MBEDTLS_PRIVATE(index);
     uint16_t MBEDTLS_PRIVATE(olen);
     uint16_t MBEDTLS_PRIVATE(max_block_size);
+    uint8_t MBEDTLS_PRIVATE(squeezing);
 }
 mbedtls_sha3_context;
 
@@ -119,7 +122,7 @@ int mbedtls_sha3_update(mbedtls_sha3_context *ctx,
  *                 This must be a writable buffer of length \c olen bytes.
  * \param olen     Defines the length of output buffer (in bytes). For SHA-3 224, SHA-3 256,
  *                 SHA-3 384 and SHA-3 512 \c olen must equal to 28, 32, 48 and 64,
- *                 respectively.
+ *                 respectively. For SHAKE128 and SHAKE256 it may be any length.
  *
  * \return         \c 0 on success.
  * \return         A negative error code on failure.
@@ -127,6 +130,30 @@ int mbedtls_sha3_update(mbedtls_sha3_context *ctx,
 int mbedtls_sha3_finish(mbedtls_sha3_context *ctx,
                         uint8_t *output, size_t olen);
 
+/**
+ * \brief          This function writes the next \p olen bytes of the output
+ *                 of a SHAKE128 or SHAKE256 operation.
+ *
+ *                 The first call ends the input. Each further call continues
+ *                 the output where the previous one stopped, so any sequence
+ *                 of calls produces the same bytes as a single call for the
+ *                 total length. Once output has started,
+ *                 mbedtls_sha3_update() fails. Call mbedtls_sha3_free() when
+ *                 no more output is needed.
+ *
+ * \param ctx      The SHA-3 context. This must be initialized and have a
+ *                 SHAKE128 or SHAKE256 operation started.
+ * \param output   The output buffer. This must be a writable buffer of
+ *                 length \p olen bytes.
+ * \param olen     The number of output bytes to write.
+ *
+ * \return         \c 0 on success.
+ * \return         #MBEDTLS_ERR_SHA3_BAD_INPUT_DATA if \p ctx is not a
+ *                 SHAKE operation.
+ */
+int mbedtls_sha3_squeeze(mbedtls_sha3_context *ctx,
+                         uint8_t *output, size_t olen);
+
 /**
  * \brief          This function calculates the SHA-3
  *                 checksum of a buffer.
@@ -145,7 +172,7 @@ int mbedtls_sha3_finish(mbedtls_sha3_context *ctx,
  *                 This must be a writable buffer of length \c olen bytes.
  * \param olen     Defines the length of output buffer (in bytes). For SHA-3 224, SHA-3 256,
  *                 SHA-3 384 and SHA-3 512 \c olen must equal to 28, 32, 48 and 64,
- *                 respectively.
+ *                 respectively. For SHAKE128 and SHAKE256 it may be any length.
  *
  * \return         \c 0 on success.
  * \return         A negative error code on failure.
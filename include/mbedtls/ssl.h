@@ -38,6 +38,10 @@
 #include "mbedtls/platform_time.h"
 #endif
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL) && defined(MBEDTLS_THREADING_C)
+#include "mbedtls/threading.h"
+#endif
+
 #include "mbedcrypto/psa/crypto.h"
 
 /*
@@ -99,7 +103,8 @@
 #define MBEDTLS_ERR_SSL_RECEIVED_EARLY_DATA               -0x7C00
 /** Not possible to write early data */
 #define MBEDTLS_ERR_SSL_CANNOT_WRITE_EARLY_DATA           -0x7C80
-/* Error space gap */
+/** No peer of the DTLS demultiplexer matches */
+#define MBEDTLS_ERR_SSL_DEMUX_ENTRY_NOT_FOUND             -0x7D00
 /* Error space gap */
 /* Error space gap */
 /* Error space gap */
@@ -375,6 +380,9 @@
 #define MBEDTLS_SSL_SRV_CIPHERSUITE_ORDER_CLIENT  1
 #define MBEDTLS_SSL_SRV_CIPHERSUITE_ORDER_SERVER  0
 
+#define MBEDTLS_SSL_WRITE_BATCHING_DISABLED     0
+#define MBEDTLS_SSL_WRITE_BATCHING_ENABLED      1
+
 #if defined(MBEDTLS_SSL_PROTO_TLS1_3) && defined(MBEDTLS_SSL_SESSION_TICKETS)
 #if defined(PSA_WANT_ALG_SHA_384)
 #define MBEDTLS_SSL_TLS1_3_TICKET_RESUMPTION_KEY_LEN        48
@@ -436,6 +444,10 @@
 #define MBEDTLS_SSL_OUT_CONTENT_LEN 16384
 #endif
 
+#if !defined(MBEDTLS_SSL_OUT_BUFFER_RECORDS)
+#define MBEDTLS_SSL_OUT_BUFFER_RECORDS 1
+#endif
+
 /*
  * Maximum number of heap-allocated bytes for the purpose of
  * DTLS handshake message reassembly and future message buffering.
@@ -444,6 +456,13 @@
 #define MBEDTLS_SSL_DTLS_MAX_BUFFERING 32768
 #endif
 
+/*
+ * Size in bits of the DTLS anti-replay window.
+ */
+#if !defined(MBEDTLS_SSL_DTLS_REPLAY_WINDOW)
+#define MBEDTLS_SSL_DTLS_REPLAY_WINDOW 64
+#endif
+
 /*
  * Maximum length of CIDs for incoming and outgoing messages.
  */
@@ -793,6 +812,14 @@ typedef enum {
 } mbedtls_ssl_early_data_status;
 #endif /* MBEDTLS_SSL_EARLY_DATA && MBEDTLS_SSL_CLI_C */
 
+/**
+ * \brief          A buffer of application data, for mbedtls_ssl_writev().
+ */
+typedef struct mbedtls_ssl_iovec {
+    const unsigned char *buf;   /*!< The data. */
+    size_t len;                 /*!< The length of the data in bytes. */
+} mbedtls_ssl_iovec;
+
 /**
  * \brief          Callback type: send data on the network.
  *
@@ -1449,6 +1476,44 @@ typedef union {
     void *p;                    /* typically a pointer to extra data */
 } mbedtls_ssl_user_data_t;
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+/**
+ * \brief          Pool of idle I/O buffers, to be shared between the
+ *                 mbedtls_ssl_context structures using the configurations
+ *                 it is attached to with mbedtls_ssl_conf_buffer_pool().
+ */
+typedef struct mbedtls_ssl_buffer_pool {
+    void *MBEDTLS_PRIVATE(in_free);      /*!< idle input buffers, linked
+                                              through their first bytes  */
+    void *MBEDTLS_PRIVATE(out_free);     /*!< idle output buffers        */
+    size_t MBEDTLS_PRIVATE(in_count);    /*!< number of idle input buffers  */
+    size_t MBEDTLS_PRIVATE(out_count);   /*!< number of idle output buffers */
+    size_t MBEDTLS_PRIVATE(max_idle);    /*!< maximum number of idle buffers
+                                              kept in each direction     */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex);    /*!< mutex      */
+#endif
+} mbedtls_ssl_buffer_pool;
+#endif /* MBEDTLS_SSL_BUFFER_POOL */
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+/**
+ * \brief          Pool of ephemeral ECDH key pairs generated ahead of time,
+ *                 to be shared between the mbedtls_ssl_context structures
+ *                 using the configurations it is attached to with
+ *                 mbedtls_ssl_conf_key_share_pool().
+ */
+typedef struct mbedtls_ssl_key_share_pool {
+    struct mbedtls_ssl_key_share_group *MBEDTLS_PRIVATE(groups); /*!< one queue
+                                                                      per group */
+    size_t MBEDTLS_PRIVATE(group_count); /*!< number of groups           */
+    size_t MBEDTLS_PRIVATE(depth);       /*!< keys kept ready per group  */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex);    /*!< mutex      */
+#endif
+} mbedtls_ssl_key_share_pool;
+#endif /* MBEDTLS_SSL_KEY_SHARE_POOL */
+
 /**
  * SSL/TLS configuration to be shared between mbedtls_ssl_context structures.
  */
@@ -1521,6 +1586,8 @@ struct mbedtls_ssl_config {
     uint8_t MBEDTLS_PRIVATE(dtls_srtp_mki_support); /* support having mki_value
                                                        in the use_srtp extension? */
 #endif
+    uint8_t MBEDTLS_PRIVATE(write_batching);    /*!< write several records per
+                                                     call to mbedtls_ssl_write()? */
 
     /*
      * Pointers
@@ -1548,6 +1615,14 @@ struct mbedtls_ssl_config {
     mbedtls_ssl_cache_set_t *MBEDTLS_PRIVATE(f_set_cache);
     void *MBEDTLS_PRIVATE(p_cache);                  /*!< context for cache callbacks        */
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_buffer_pool *MBEDTLS_PRIVATE(buffer_pool); /*!< pool for idle I/O buffers */
+#endif
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+    mbedtls_ssl_key_share_pool *MBEDTLS_PRIVATE(key_share_pool); /*!< ready ECDHE keys */
+#endif
+
 #if defined(MBEDTLS_SSL_SERVER_NAME_INDICATION)
     /** Callback for setting cert according to SNI extension                */
     int(*MBEDTLS_PRIVATE(f_sni))(void *, mbedtls_ssl_context *, const unsigned char *, size_t);
@@ -1708,6 +1783,14 @@ struct mbedtls_ssl_config {
 
     unsigned int MBEDTLS_PRIVATE(badmac_limit);      /*!< limit of records with a bad MAC    */
 
+    size_t MBEDTLS_PRIVATE(dyn_record_len);          /*!< initial application data record
+                                                        payload, 0 to always use the
+                                                        maximum                            */
+    size_t MBEDTLS_PRIVATE(dyn_record_threshold);    /*!< bytes sent before records grow
+                                                        to the maximum                     */
+    uint32_t MBEDTLS_PRIVATE(dyn_record_idle);       /*!< idle time after which records
+                                                        shrink again (ms)                  */
+
 #if defined(MBEDTLS_DHM_C) && defined(MBEDTLS_SSL_CLI_C)
     unsigned int MBEDTLS_PRIVATE(dhm_min_bitlen);    /*!< min. bit length of the DHM prime   */
 #endif
@@ -1865,7 +1948,9 @@ struct mbedtls_ssl_context {
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
     uint64_t MBEDTLS_PRIVATE(in_window_top);     /*!< last validated record seq_num    */
-    uint64_t MBEDTLS_PRIVATE(in_window);         /*!< bitmask for replay detection     */
+    uint64_t MBEDTLS_PRIVATE(in_window)[MBEDTLS_SSL_DTLS_REPLAY_WINDOW / 64 + 1];
+                                                 /*!< ring of bitmasks for replay
+                                                    detection                        */
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
 
     size_t MBEDTLS_PRIVATE(in_hslen);            /*!< current handshake message length,
@@ -1929,6 +2014,19 @@ struct mbedtls_ssl_context {
 
     unsigned char MBEDTLS_PRIVATE(cur_out_ctr)[MBEDTLS_SSL_SEQUENCE_NUMBER_LEN]; /*!<  Outgoing record sequence  number. */
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    unsigned char MBEDTLS_PRIVATE(idle_in_ctr)[MBEDTLS_SSL_SEQUENCE_NUMBER_LEN]; /*!< Incoming record
+                                                    sequence number while the
+                                                    I/O buffers are in the pool. */
+#endif
+
+    size_t MBEDTLS_PRIVATE(dyn_record_sent);     /*!< application data bytes sent since
+                                                    records were last shrunk       */
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_ms_time_t MBEDTLS_PRIVATE(dyn_record_last); /*!< time of the last application
+                                                           data write (ms)        */
+#endif
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     uint16_t MBEDTLS_PRIVATE(mtu);               /*!< path mtu, used to fragment outgoing messages */
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
@@ -3300,6 +3398,157 @@ void mbedtls_ssl_conf_session_cache(mbedtls_ssl_config *conf,
                                     mbedtls_ssl_cache_set_t *f_set_cache);
 #endif /* MBEDTLS_SSL_SRV_C */
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+/**
+ * \brief          Initialize a pool of idle I/O buffers.
+ *
+ *                 The pool starts empty and keeps any number of idle
+ *                 buffers, see mbedtls_ssl_buffer_pool_set_max_idle().
+ *
+ * \param pool     The buffer pool to initialize.
+ */
+void mbedtls_ssl_buffer_pool_init(mbedtls_ssl_buffer_pool *pool);
+
+/**
+ * \brief          Set the maximum number of idle buffers the pool keeps in
+ *                 each direction. Buffers released beyond this number are
+ *                 returned to the heap.
+ *
+ * \param pool     The buffer pool.
+ * \param max_idle The maximum number of idle input buffers, and of idle
+ *                 output buffers.
+ */
+void mbedtls_ssl_buffer_pool_set_max_idle(mbedtls_ssl_buffer_pool *pool,
+                                          size_t max_idle);
+
+/**
+ * \brief          Free the idle buffers of a pool and the pool itself.
+ *
+ * \note           This must only be called once no SSL context set up with
+ *                 a configuration that uses \p pool is left.
+ *
+ * \param pool     The buffer pool to free.
+ */
+void mbedtls_ssl_buffer_pool_free(mbedtls_ssl_buffer_pool *pool);
+
+/**
+ * \brief          Share the I/O buffers of idle connections through a pool.
+ *                 (Default: none, each context keeps its own buffers for
+ *                 its whole lifetime)
+ *
+ *                 With a pool, a TLS context hands its input and output
+ *                 buffers to the pool at the end of mbedtls_ssl_read(),
+ *                 mbedtls_ssl_write() and similar functions when no record
+ *                 is partially received or sent and no application data is
+ *                 pending, and takes buffers from the pool again (or from
+ *                 the heap if the pool is empty) on its next operation.
+ *                 A context also returns its buffers to the pool when it is
+ *                 freed. Buffers are zeroized before they enter the pool.
+ *
+ * \note           DTLS contexts keep their buffers.
+ *
+ * \note           The pool must outlive all contexts using \p conf.
+ *
+ * \param conf     SSL configuration
+ * \param pool     The buffer pool, or \c NULL to disable pooling.
+ */
+void mbedtls_ssl_conf_buffer_pool(mbedtls_ssl_config *conf,
+                                  mbedtls_ssl_buffer_pool *pool);
+#endif /* MBEDTLS_SSL_BUFFER_POOL */
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+/**
+ * \brief          Initialize a pool of ephemeral ECDH keys.
+ *
+ * \param pool     The key share pool to initialize.
+ */
+void mbedtls_ssl_key_share_pool_init(mbedtls_ssl_key_share_pool *pool);
+
+/**
+ * \brief          Choose the groups the pool keeps keys for.
+ *
+ * \param pool     The key share pool, freshly initialized.
+ * \param groups   The groups, as a list of TLS NamedGroup identifiers
+ *                 terminated by \c 0, as for mbedtls_ssl_conf_groups().
+ *                 Only elliptic curve groups are supported.
+ * \param depth    The number of keys mbedtls_ssl_key_share_pool_refill()
+ *                 keeps ready for each group.
+ *
+ * \return         \c 0 on success,
+ *                 #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if a group is not a
+ *                 supported elliptic curve or \p depth is \c 0, or
+ *                 #MBEDTLS_ERR_SSL_ALLOC_FAILED.
+ */
+int mbedtls_ssl_key_share_pool_setup(mbedtls_ssl_key_share_pool *pool,
+                                     const uint16_t *groups,
+                                     size_t depth);
+
+/**
+ * \brief          Generate keys for the groups that have fewer than the
+ *                 configured depth, starting with the emptiest.
+ *
+ *                 This is where the cost of key generation goes instead of
+ *                 the handshake. Call it from a background thread, or from
+ *                 the event loop when it is idle. Keys are generated without
+ *                 holding the lock of the pool, so handshakes can keep
+ *                 taking keys meanwhile.
+ *
+ * \param pool     The key share pool.
+ * \param max_keys The maximum number of keys to generate, to bound the
+ *                 time spent, or \c 0 to fill the pool completely.
+ *
+ * \return         The number of keys generated, or a negative error code
+ *                 from PSA key generation.
+ */
+int mbedtls_ssl_key_share_pool_refill(mbedtls_ssl_key_share_pool *pool,
+                                      size_t max_keys);
+
+/**
+ * \brief          Return the number of keys ready for a group.
+ *
+ * \param pool     The key share pool.
+ * \param group    The TLS NamedGroup identifier.
+ *
+ * \return         The number of keys ready, \c 0 if the pool does not
+ *                 keep keys for \p group.
+ */
+size_t mbedtls_ssl_key_share_pool_count(mbedtls_ssl_key_share_pool *pool,
+                                        uint16_t group);
+
+/**
+ * \brief          Destroy the keys of a pool and free the pool itself.
+ *
+ * \note           This must only be called once no handshake can take keys
+ *                 from \p pool any more.
+ *
+ * \param pool     The key share pool to free.
+ */
+void mbedtls_ssl_key_share_pool_free(mbedtls_ssl_key_share_pool *pool);
+
+/**
+ * \brief          Take the ephemeral ECDH keys of handshakes from a pool.
+ *                 (Default: none, each handshake generates its key)
+ *
+ *                 When the handshake needs an ephemeral key pair for an
+ *                 elliptic curve group, for the TLS 1.3 key_share extension
+ *                 or for the TLS 1.2 ServerKeyExchange or ClientKeyExchange
+ *                 messages, it takes a ready key pair from \p pool, together
+ *                 with its public key, and skips the scalar multiplications
+ *                 of key generation. When the pool has no key left for the
+ *                 group, the handshake generates one as usual. Each key is
+ *                 used by one handshake only.
+ *
+ * \note           In TLS 1.2, this requires #MBEDTLS_USE_PSA_CRYPTO.
+ *
+ * \note           The pool must outlive all contexts using \p conf.
+ *
+ * \param conf     SSL configuration
+ * \param pool     The key share pool, or \c NULL to disable it.
+ */
+void mbedtls_ssl_conf_key_share_pool(mbedtls_ssl_config *conf,
+                                     mbedtls_ssl_key_share_pool *pool);
+#endif /* MBEDTLS_SSL_KEY_SHARE_POOL */
+
 #if defined(MBEDTLS_SSL_CLI_C)
 /**
  * \brief          Load a session for session resumption.
@@ -4511,6 +4760,72 @@ void mbedtls_ssl_conf_encrypt_then_mac(mbedtls_ssl_config *conf, char etm);
 void mbedtls_ssl_conf_extended_master_secret(mbedtls_ssl_config *conf, char ems);
 #endif /* MBEDTLS_SSL_EXTENDED_MASTER_SECRET */
 
+/**
+ * \brief           Enable or disable write batching
+ *                  (Default: MBEDTLS_SSL_WRITE_BATCHING_DISABLED)
+ *
+ *                  By default, mbedtls_ssl_write() sends at most one record
+ *                  per call. With write batching enabled on a TLS connection,
+ *                  it encrypts as many records as fit in the outgoing buffer
+ *                  back to back and passes them to the send callback at once.
+ *                  This only makes a difference if the outgoing buffer can
+ *                  hold several records, see #MBEDTLS_SSL_OUT_BUFFER_RECORDS
+ *                  and mbedtls_ssl_conf_max_frag_len(). It has no effect on
+ *                  DTLS, where each call still writes a single record.
+ *
+ * \note            The return value of mbedtls_ssl_write() keeps its
+ *                  meaning: it is the number of bytes written, which may be
+ *                  larger than a single record with this option enabled.
+ *
+ * \param conf      SSL configuration
+ * \param batching  MBEDTLS_SSL_WRITE_BATCHING_ENABLED or
+ *                  MBEDTLS_SSL_WRITE_BATCHING_DISABLED
+ */
+void mbedtls_ssl_conf_write_batching(mbedtls_ssl_config *conf, char batching);
+
+/**
+ * \brief           Configure dynamic record sizing for application data
+ *                  (Default: disabled, records are always filled up to the
+ *                  maximum payload.)
+ *
+ *                  The peer can only decrypt and use the data of a record
+ *                  once the whole record has arrived. Filling a fresh TCP
+ *                  connection with 16 KB records therefore delays the first
+ *                  usable bytes by several round trips while the congestion
+ *                  window opens. With this policy, mbedtls_ssl_write() and
+ *                  mbedtls_ssl_writev() start with records of at most
+ *                  \p initial_len bytes, switch to full-size records once
+ *                  \p threshold bytes of application data have been sent,
+ *                  and go back to small records after the connection has
+ *                  not sent application data for \p idle_timeout
+ *                  milliseconds.
+ *
+ *                  A typical choice is an \p initial_len such that one
+ *                  record fits in a single TCP segment, e.g. 1400 bytes
+ *                  minus the value of mbedtls_ssl_get_record_expansion(),
+ *                  a \p threshold of about 1 MB and an \p idle_timeout of
+ *                  1000 ms.
+ *
+ * \note            This only applies to TLS. DTLS records are not affected.
+ *
+ * \note            The idle timeout requires #MBEDTLS_HAVE_TIME. Without it,
+ *                  records stay at full size once the threshold is reached.
+ *
+ * \param conf      SSL configuration
+ * \param initial_len   Maximum application data payload of a record until
+ *                  \p threshold is reached, or 0 to disable dynamic record
+ *                  sizing.
+ * \param threshold Number of application data bytes after which records
+ *                  grow to the maximum payload.
+ * \param idle_timeout  Time in milliseconds without application data
+ *                  writes after which records shrink back to
+ *                  \p initial_len, or 0 to never shrink them again.
+ */
+void mbedtls_ssl_conf_dynamic_record_sizing(mbedtls_ssl_config *conf,
+                                            size_t initial_len,
+                                            size_t threshold,
+                                            uint32_t idle_timeout);
+
 #if defined(MBEDTLS_SSL_SRV_C)
 /**
  * \brief          Whether to send a list of acceptable CAs in
@@ -5279,6 +5594,60 @@ int mbedtls_ssl_renegotiate(mbedtls_ssl_context *ssl);
  */
 int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len);
 
+/**
+ * \brief          Access decrypted application data in place, without
+ *                 copying it to a caller-supplied buffer.
+ *
+ *                 This function behaves like mbedtls_ssl_read(), but instead
+ *                 of copying the plaintext it lends the application data
+ *                 that is still pending in the current record. The data is
+ *                 released with mbedtls_ssl_read_consume().
+ *
+ * \param ssl      SSL context
+ * \param buf      On success, set to the start of the pending application
+ *                 data. This is a pointer into the internal input buffer of
+ *                 \p ssl and must not be written to.
+ * \param len      On success, set to the number of bytes available at
+ *                 \p *buf. This is at most the remaining plaintext of a
+ *                 single record.
+ *
+ * \return         \c 0 on success. If \p *len is \c 0, the connection
+ *                 was closed, with the same meaning as a \c 0 return value
+ *                 of mbedtls_ssl_read().
+ * \return         #MBEDTLS_ERR_SSL_WANT_READ if an empty record was
+ *                 received; it has been discarded and you can call this
+ *                 function again.
+ * \return         Any other error code that mbedtls_ssl_read() may return,
+ *                 with the same meaning and the same requirements on how the
+ *                 context must be used afterwards.
+ *
+ * \warning        The data at \p *buf is only valid until the next call to
+ *                 an SSL function on \p ssl other than this function and
+ *                 mbedtls_ssl_read_consume(). Data that is not consumed
+ *                 remains pending and is returned again by the next call to
+ *                 this function or to mbedtls_ssl_read().
+ */
+int mbedtls_ssl_read_peek(mbedtls_ssl_context *ssl,
+                          const unsigned char **buf, size_t *len);
+
+/**
+ * \brief          Release application data lent by mbedtls_ssl_read_peek().
+ *
+ *                 The first \p len bytes of the pending application data
+ *                 are zeroized and discarded, as if they had been read with
+ *                 mbedtls_ssl_read().
+ *
+ * \param ssl      SSL context
+ * \param len      Number of bytes to consume. This must not exceed the
+ *                 length returned by the last call to mbedtls_ssl_read_peek()
+ *                 minus the bytes consumed since then.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p len is larger than
+ *                 the pending application data.
+ */
+int mbedtls_ssl_read_consume(mbedtls_ssl_context *ssl, size_t len);
+
 /**
  * \brief          Try to write exactly 'len' application data bytes
  *
@@ -5354,6 +5723,51 @@ int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len);
  */
 int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len);
 
+/**
+ * \brief          Write application data gathered from several buffers.
+ *
+ *                 This behaves like mbedtls_ssl_write() called on the
+ *                 concatenation of the buffers, without the caller having
+ *                 to build that concatenation: the data is gathered
+ *                 directly into the record that is then encrypted in place.
+ *
+ *                 With TLS, if the output buffer is large enough for
+ *                 several records of the current maximum payload (after
+ *                 negotiating a maximum fragment length, or with
+ *                 #MBEDTLS_SSL_OUT_BUFFER_RECORDS greater than 1), this
+ *                 function writes as many records as fit and sends
+ *                 them with a single call to the send callback. Otherwise,
+ *                 and always with DTLS, it writes a single record, as
+ *                 mbedtls_ssl_write() does.
+ *
+ * \note           With #MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH, the output
+ *                 buffer is shrunk to a single record once a maximum
+ *                 fragment length is negotiated, so a negotiated maximum
+ *                 fragment length does not lead to several records per call.
+ *
+ * \warning        This function will do partial writes in some cases. If
+ *                 the return value is non-negative but less than the total
+ *                 length of the buffers, the function must be called again
+ *                 for the data from that offset onwards.
+ *
+ * \param ssl      SSL context
+ * \param iov      The buffers holding the data, in order.
+ * \param iovcnt   The number of buffers in \p iov.
+ *
+ * \return         The (non-negative) number of bytes actually written if
+ *                 successful (may be less than the total length of the
+ *                 buffers).
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p iov is \c NULL
+ *                 while \p iovcnt is not 0.
+ * \return         Any other error code of mbedtls_ssl_write(), with the
+ *                 same meaning. In particular, after
+ *                 #MBEDTLS_ERR_SSL_WANT_WRITE or #MBEDTLS_ERR_SSL_WANT_READ
+ *                 the function must be called again with the same
+ *                 arguments.
+ */
+int mbedtls_ssl_writev(mbedtls_ssl_context *ssl,
+                       const mbedtls_ssl_iovec *iov, size_t iovcnt);
+
 /**
  * \brief           Send an alert message
  *
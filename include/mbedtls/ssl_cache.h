@@ -35,6 +35,21 @@
 #define MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES      50   /*!< Maximum entries in cache */
 #endif
 
+/**
+ * Number of partitions of the cache. Each partition has its own hash table,
+ * eviction list and (if MBEDTLS_THREADING_C is enabled) its own mutex, so
+ * that threads looking up different sessions rarely contend on the same
+ * lock. Sessions are spread over the partitions by a hash of their ID, and
+ * each partition holds at most max_entries / MBEDTLS_SSL_CACHE_SHARDS
+ * entries (rounded up).
+ *
+ * A value larger than 1 is only useful for multi-threaded servers with
+ * large caches.
+ */
+#if !defined(MBEDTLS_SSL_CACHE_SHARDS)
+#define MBEDTLS_SSL_CACHE_SHARDS                    1   /*!< Independently locked partitions */
+#endif
+
 /** \} name SECTION: Module settings */
 
 #ifdef __cplusplus
@@ -58,19 +73,37 @@ struct mbedtls_ssl_cache_entry {
     unsigned char *MBEDTLS_PRIVATE(session);             /*!< serialized session */
     size_t MBEDTLS_PRIVATE(session_len);
 
-    mbedtls_ssl_cache_entry *MBEDTLS_PRIVATE(next);      /*!< chain pointer      */
+    mbedtls_ssl_cache_entry *MBEDTLS_PRIVATE(next);      /*!< hash bucket chain  */
+    mbedtls_ssl_cache_entry *MBEDTLS_PRIVATE(newer);     /*!< eviction list      */
+    mbedtls_ssl_cache_entry *MBEDTLS_PRIVATE(older);     /*!< eviction list      */
 };
 
+/**
+ * \brief   One partition of the cache
+ *
+ * Entries are indexed by a hash table on the session ID and are also kept
+ * in a list ordered by the time they were stored, newest first. Since that
+ * is also the order in which they expire, both timeout and capacity
+ * eviction take the oldest entry, which is at the tail of the list.
+ */
+typedef struct mbedtls_ssl_cache_shard {
+    mbedtls_ssl_cache_entry **MBEDTLS_PRIVATE(buckets);  /*!< hash table         */
+    size_t MBEDTLS_PRIVATE(bucket_count);        /*!< size of buckets (2^n)  */
+    int MBEDTLS_PRIVATE(entries);                /*!< number of entries      */
+    mbedtls_ssl_cache_entry *MBEDTLS_PRIVATE(newest);    /*!< last stored entry  */
+    mbedtls_ssl_cache_entry *MBEDTLS_PRIVATE(oldest);    /*!< next to evict      */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex);    /*!< mutex                  */
+#endif
+} mbedtls_ssl_cache_shard;
+
 /**
  * \brief Cache context
  */
 struct mbedtls_ssl_cache_context {
-    mbedtls_ssl_cache_entry *MBEDTLS_PRIVATE(chain);     /*!< start of the chain     */
+    mbedtls_ssl_cache_shard MBEDTLS_PRIVATE(shards)[MBEDTLS_SSL_CACHE_SHARDS]; /*!< partitions */
     int MBEDTLS_PRIVATE(timeout);                /*!< cache entry timeout    */
     int MBEDTLS_PRIVATE(max_entries);            /*!< maximum entries        */
-#if defined(MBEDTLS_THREADING_C)
-    mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex);    /*!< mutex                  */
-#endif
 };
 
 /**
@@ -0,0 +1,185 @@
+/**
+ * \file ssl_demux.h
+ *
+ * \brief DTLS server demultiplexer: route datagrams received on one socket
+ *        to the SSL context of their peer
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_SSL_DEMUX_H
+#define MBEDTLS_SSL_DEMUX_H
+#include "mbedtls/private_access.h"
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ssl.h"
+
+/**
+ * \name SECTION: Module settings
+ *
+ * The configuration options you can set for this module are in this section.
+ * Either change them in mbedtls_config.h or define them on the compiler command line.
+ * \{
+ */
+#if !defined(MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN)
+#define MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN  128 /**< Maximum length of a peer address, e.g. a struct sockaddr */
+#endif
+
+/** \} name SECTION: Module settings */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mbedtls_ssl_demux_entry mbedtls_ssl_demux_entry;
+
+/**
+ * \brief   One peer known to the demultiplexer
+ */
+struct mbedtls_ssl_demux_entry {
+    mbedtls_ssl_context *MBEDTLS_PRIVATE(ssl);       /*!< context of the peer      */
+    void *MBEDTLS_PRIVATE(p_user);                   /*!< application data         */
+
+    unsigned char MBEDTLS_PRIVATE(addr)[MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN]; /*!< peer address */
+    size_t MBEDTLS_PRIVATE(addr_len);                /*!< 0 if the address was taken
+                                                          over by another peer     */
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    unsigned char MBEDTLS_PRIVATE(cid)[MBEDTLS_SSL_CID_IN_LEN_MAX]; /*!< our CID for the peer */
+#endif
+
+    mbedtls_ssl_demux_entry *MBEDTLS_PRIVATE(next_addr); /*!< address bucket chain */
+    mbedtls_ssl_demux_entry *MBEDTLS_PRIVATE(next_cid);  /*!< CID bucket chain     */
+    mbedtls_ssl_demux_entry *MBEDTLS_PRIVATE(next_ssl);  /*!< context bucket chain */
+};
+
+/**
+ * \brief   Demultiplexer context
+ *
+ * Peers are indexed by three hash tables of the same size: by address, by
+ * the connection ID they put in their records, and by SSL context for
+ * removal.
+ */
+typedef struct mbedtls_ssl_demux_context {
+    mbedtls_ssl_demux_entry **MBEDTLS_PRIVATE(by_addr);
+    mbedtls_ssl_demux_entry **MBEDTLS_PRIVATE(by_cid);
+    mbedtls_ssl_demux_entry **MBEDTLS_PRIVATE(by_ssl);
+    size_t MBEDTLS_PRIVATE(bucket_count);   /*!< size of each table (2^n)   */
+    size_t MBEDTLS_PRIVATE(entries);        /*!< number of peers            */
+    size_t MBEDTLS_PRIVATE(cid_len);        /*!< length of our CIDs, or 0   */
+    uint32_t MBEDTLS_PRIVATE(key)[2];       /*!< secret hash key            */
+
+    mbedtls_f_rng_t *MBEDTLS_PRIVATE(f_rng);
+    void *MBEDTLS_PRIVATE(p_rng);
+} mbedtls_ssl_demux_context;
+
+/**
+ * \brief          Initialize a demultiplexer context
+ *
+ * \param ctx      Context to initialize
+ */
+void mbedtls_ssl_demux_init(mbedtls_ssl_demux_context *ctx);
+
+/**
+ * \brief          Set up a demultiplexer context
+ *
+ * \param ctx      Context to set up
+ * \param cid_len  Length of the connection IDs the server asks its peers
+ *                 to use, as passed to mbedtls_ssl_conf_cid(), or 0 to
+ *                 route by peer address only.
+ * \param f_rng    RNG function, used for the hash key and to draw the
+ *                 connection IDs
+ * \param p_rng    RNG parameter
+ *
+ * \return         0 if successful,
+ *                 #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p cid_len is not
+ *                 supported, or an error from \p f_rng.
+ */
+int mbedtls_ssl_demux_setup(mbedtls_ssl_demux_context *ctx,
+                            size_t cid_len,
+                            mbedtls_f_rng_t *f_rng,
+                            void *p_rng);
+
+/**
+ * \brief          Register the SSL context serving a new peer
+ *
+ *                 If the demultiplexer was set up with a non-zero CID
+ *                 length, this draws a connection ID that no other peer
+ *                 uses and enables it on \p ssl with mbedtls_ssl_set_cid().
+ *                 Call this before the handshake.
+ *
+ * \param ctx      Demultiplexer context
+ * \param ssl      SSL context, set up with the server configuration
+ * \param p_user   Application data returned by mbedtls_ssl_demux_lookup()
+ *                 for this peer, e.g. the structure holding \p ssl
+ * \param addr     Peer address, as given by the socket layer
+ * \param addr_len Length of \p addr
+ *
+ * \return         0 if successful,
+ *                 #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if the address is too
+ *                 long or already registered,
+ *                 #MBEDTLS_ERR_SSL_ALLOC_FAILED, or another error from the
+ *                 RNG or mbedtls_ssl_set_cid().
+ */
+int mbedtls_ssl_demux_add(mbedtls_ssl_demux_context *ctx,
+                          mbedtls_ssl_context *ssl,
+                          void *p_user,
+                          const unsigned char *addr, size_t addr_len);
+
+/**
+ * \brief          Find the peer a datagram belongs to
+ *
+ *                 A record carrying a connection ID is routed by that ID.
+ *                 If it comes from another address than the one known for
+ *                 the peer, for example after a NAT rebinding, it is first
+ *                 authenticated with mbedtls_ssl_check_record(), and only
+ *                 then does the peer's address change to \p addr. Other
+ *                 records are routed by address.
+ *
+ * \param ctx      Demultiplexer context
+ * \param buf      The datagram. It is not modified.
+ * \param len      Length of \p buf
+ * \param addr     Address the datagram came from
+ * \param addr_len Length of \p addr
+ * \param p_user   On success, receives the application data of the peer.
+ *                 Its current address is then \p addr.
+ *
+ * \return         0 if successful,
+ *                 #MBEDTLS_ERR_SSL_DEMUX_ENTRY_NOT_FOUND if no peer matches,
+ *                 in which case the datagram may start a new connection,
+ *                 #MBEDTLS_ERR_SSL_UNEXPECTED_RECORD or another error from
+ *                 mbedtls_ssl_check_record() if a record failed
+ *                 authentication, in which case the datagram must be
+ *                 dropped, or #MBEDTLS_ERR_SSL_ALLOC_FAILED.
+ */
+int mbedtls_ssl_demux_lookup(mbedtls_ssl_demux_context *ctx,
+                             const unsigned char *buf, size_t len,
+                             const unsigned char *addr, size_t addr_len,
+                             void **p_user);
+
+/**
+ * \brief          Forget a peer
+ *
+ * \param ctx      Demultiplexer context
+ * \param ssl      SSL context passed to mbedtls_ssl_demux_add()
+ *
+ * \return         0 if successful, or
+ *                 #MBEDTLS_ERR_SSL_DEMUX_ENTRY_NOT_FOUND.
+ */
+int mbedtls_ssl_demux_remove(mbedtls_ssl_demux_context *ctx,
+                             const mbedtls_ssl_context *ssl);
+
+/**
+ * \brief          Free the contents of a demultiplexer context. The SSL
+ *                 contexts it referred to are not freed.
+ *
+ * \param ctx      Context to free
+ */
+void mbedtls_ssl_demux_free(mbedtls_ssl_demux_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ssl_demux.h */
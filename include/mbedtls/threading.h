@@ -158,6 +158,18 @@ extern mbedtls_threading_mutex_t mbedtls_threading_psa_globaldata_mutex;
 extern mbedtls_threading_mutex_t mbedtls_threading_psa_rngdata_mutex;
 #endif
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+/*
+ * A mutex used to protect the process-wide cache of ECP comb tables. */
+extern mbedtls_threading_mutex_t mbedtls_threading_ecp_group_cache_mutex;
+#endif
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+/*
+ * A mutex used to protect the process-wide cache of ECP public key tables. */
+extern mbedtls_threading_mutex_t mbedtls_threading_ecp_pubkey_cache_mutex;
+#endif
+
 #endif /* MBEDTLS_THREADING_C */
 
 #ifdef __cplusplus
@@ -84,6 +84,13 @@ typedef struct mbedtls_x509_crt {
     mbedtls_pk_type_t MBEDTLS_PRIVATE(sig_pk);           /**< Internal representation of the Public Key algorithm of the signature algorithm, e.g. MBEDTLS_PK_RSA */
     void *MBEDTLS_PRIVATE(sig_opts);             /**< Signature options to be passed to mbedtls_pk_verify_ext(), e.g. for RSASSA-PSS */
 
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    struct mbedtls_x509_crt **MBEDTLS_PRIVATE(ca_index); /**< Hash table of the chain by subject name, only set in the first certificate of an indexed chain. See mbedtls_x509_crt_build_ca_index(). */
+    size_t MBEDTLS_PRIVATE(ca_index_size);               /**< Number of buckets in \c ca_index (a power of two) */
+    struct mbedtls_x509_crt *MBEDTLS_PRIVATE(ca_index_next); /**< Next certificate in the same \c ca_index bucket, in chain order */
+    uint32_t MBEDTLS_PRIVATE(subject_hash);              /**< Hash of the subject name, valid if the chain is indexed */
+#endif /* MBEDTLS_X509_TRUSTED_CA_INDEX */
+
     /** Next certificate in the linked list that constitutes the CA chain.
      * \p NULL indicates the end of the list.
      * Do not modify this field directly. */
@@ -886,6 +893,37 @@ void mbedtls_x509_crt_init(mbedtls_x509_crt *crt);
  */
 void mbedtls_x509_crt_free(mbedtls_x509_crt *crt);
 
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+/**
+ * \brief          Index a chain of trusted certificates by subject name.
+ *
+ *                 The verification functions that take a list of trusted
+ *                 certificates, such as mbedtls_x509_crt_verify_with_profile(),
+ *                 use the index automatically when \p chain is passed as
+ *                 \c trust_ca. Looking up the possible issuers of a
+ *                 certificate then takes constant time instead of being
+ *                 linear in the length of the list.
+ *
+ * \note           Call this function after all trusted certificates have
+ *                 been parsed into \p chain. Parsing another certificate
+ *                 into \p chain discards the index, which can then be
+ *                 built again.
+ *
+ * \note           The index is stored in \p chain and released by
+ *                 mbedtls_x509_crt_free(). Building the index is not
+ *                 thread-safe, but once it is built, the chain may be used
+ *                 for concurrent verifications as before.
+ *
+ * \param chain    The chain of trusted certificates to index.
+ *
+ * \return         \c 0 on success.
+ * \return         #MBEDTLS_ERR_X509_ALLOC_FAILED if the index could not
+ *                 be allocated. In this case \p chain is left without an
+ *                 index and can still be used for verification.
+ */
+int mbedtls_x509_crt_build_ca_index(mbedtls_x509_crt *chain);
+#endif /* MBEDTLS_X509_TRUSTED_CA_INDEX */
+
 #if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_RESTARTABLE)
 /**
  * \brief           Initialize a restart context
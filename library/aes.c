@@ -1064,6 +1064,54 @@ int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx,
 #endif /* !MBEDTLS_AES_USE_HARDWARE_ONLY */
 }
 
+#if defined(MBEDTLS_CIPHER_MODE_CBC) || defined(MBEDTLS_CIPHER_MODE_CTR) || \
+    defined(MBEDTLS_CIPHER_MODE_XTS)
+/* Number of blocks that the parallelizable modes (CBC decryption, CTR and
+ * XTS) hand to aes_crypt_ecb_blocks() at a time. */
+#define AES_BATCH_BLOCKS 8
+
+/*
+ * AES-ECB en(de)cryption of several independent blocks. The hardware
+ * implementations interleave the blocks, which is considerably faster
+ * than processing them one by one.
+ */
+static int aes_crypt_ecb_blocks(mbedtls_aes_context *ctx,
+                                int mode,
+                                size_t blocks,
+                                const unsigned char *input,
+                                unsigned char *output)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+#if defined(MBEDTLS_AESNI_HAVE_CODE)
+    if (mbedtls_aesni_has_support(MBEDTLS_AESNI_AES)) {
+#if defined(MAY_NEED_TO_ALIGN)
+        aes_maybe_realign(ctx);
+#endif
+        return mbedtls_aesni_crypt_ecb_blocks(ctx, mode, blocks, input, output);
+    }
+#endif
+
+#if defined(MBEDTLS_AESCE_HAVE_CODE)
+    if (MBEDTLS_AESCE_HAS_SUPPORT()) {
+        return mbedtls_aesce_crypt_ecb_blocks(ctx, mode, blocks, input, output);
+    }
+#endif
+
+    for (; blocks > 0; blocks--) {
+        ret = mbedtls_aes_crypt_ecb(ctx, mode, input, output);
+        if (ret != 0) {
+            return ret;
+        }
+
+        input  += 16;
+        output += 16;
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_CIPHER_MODE_CBC || MBEDTLS_CIPHER_MODE_CTR || MBEDTLS_CIPHER_MODE_XTS */
+
 #if defined(MBEDTLS_CIPHER_MODE_CBC)
 
 /*
@@ -1078,6 +1126,8 @@ int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     unsigned char temp[16];
+    unsigned char batch[AES_BATCH_BLOCKS * 16];
+    size_t i;
 
     if (mode != MBEDTLS_AES_ENCRYPT && mode != MBEDTLS_AES_DECRYPT) {
         return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
@@ -1107,6 +1157,30 @@ int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
     const unsigned char *ivp = iv;
 
     if (mode == MBEDTLS_AES_DECRYPT) {
+        /* The block decryptions are independent, so do several at once.
+         * Work from the last block of the batch to the first so that
+         * in-place operation only overwrites ciphertext that has already
+         * been used. */
+        while (length >= sizeof(batch)) {
+            ret = aes_crypt_ecb_blocks(ctx, mode, AES_BATCH_BLOCKS, input, batch);
+            if (ret != 0) {
+                goto exit;
+            }
+
+            memcpy(temp, input + sizeof(batch) - 16, 16);
+
+            for (i = sizeof(batch) - 16; i > 0; i -= 16) {
+                mbedtls_xor(output + i, batch + i, input + i - 16, 16);
+            }
+            mbedtls_xor(output, batch, iv, 16);
+
+            memcpy(iv, temp, 16);
+
+            input  += sizeof(batch);
+            output += sizeof(batch);
+            length -= sizeof(batch);
+        }
+
         while (length > 0) {
             memcpy(temp, input, 16);
             ret = mbedtls_aes_crypt_ecb(ctx, mode, input, output);
@@ -1143,6 +1217,7 @@ int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
     ret = 0;
 
 exit:
+    mbedtls_platform_zeroize(batch, sizeof(batch));
     return ret;
 }
 #endif /* MBEDTLS_CIPHER_MODE_CBC */
@@ -1199,6 +1274,9 @@ int mbedtls_aes_crypt_xts(mbedtls_aes_xts_context *ctx,
     unsigned char tweak[16];
     unsigned char prev_tweak[16];
     unsigned char tmp[16];
+    unsigned char tweaks[AES_BATCH_BLOCKS * 16];
+    unsigned char batch[AES_BATCH_BLOCKS * 16];
+    size_t j;
 
     if (mode != MBEDTLS_AES_ENCRYPT && mode != MBEDTLS_AES_DECRYPT) {
         return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
@@ -1221,6 +1299,29 @@ int mbedtls_aes_crypt_xts(mbedtls_aes_xts_context *ctx,
         return ret;
     }
 
+    /* Process full batches of blocks with the tweaks computed ahead. Leave
+     * at least one block to the loop below, which handles the special
+     * case of the last block before ciphertext stealing. */
+    while (blocks > AES_BATCH_BLOCKS) {
+        for (j = 0; j < sizeof(tweaks); j += 16) {
+            memcpy(tweaks + j, tweak, 16);
+            mbedtls_gf128mul_x_ble(tweak, tweak);
+        }
+
+        mbedtls_xor(batch, input, tweaks, sizeof(batch));
+
+        ret = aes_crypt_ecb_blocks(&ctx->crypt, mode, AES_BATCH_BLOCKS, batch, batch);
+        if (ret != 0) {
+            goto exit;
+        }
+
+        mbedtls_xor(output, batch, tweaks, sizeof(batch));
+
+        output += sizeof(batch);
+        input += sizeof(batch);
+        blocks -= AES_BATCH_BLOCKS;
+    }
+
     while (blocks--) {
         if (MBEDTLS_UNLIKELY(leftover && (mode == MBEDTLS_AES_DECRYPT) && blocks == 0)) {
             /* We are on the last block in a decrypt operation that has
@@ -1236,7 +1337,7 @@ int mbedtls_aes_crypt_xts(mbedtls_aes_xts_context *ctx,
 
         ret = mbedtls_aes_crypt_ecb(&ctx->crypt, mode, tmp, tmp);
         if (ret != 0) {
-            return ret;
+            goto exit;
         }
 
         mbedtls_xor(output, tmp, tweak, 16);
@@ -1273,7 +1374,7 @@ int mbedtls_aes_crypt_xts(mbedtls_aes_xts_context *ctx,
 
         ret = mbedtls_aes_crypt_ecb(&ctx->crypt, mode, tmp, tmp);
         if (ret != 0) {
-            return ret;
+            goto exit;
         }
 
         /* Write the result back to the previous block, overriding the previous
@@ -1281,7 +1382,11 @@ int mbedtls_aes_crypt_xts(mbedtls_aes_xts_context *ctx,
         mbedtls_xor(prev_output, tmp, t, 16);
     }
 
-    return 0;
+    ret = 0;
+
+exit:
+    mbedtls_platform_zeroize(batch, sizeof(batch));
+    return ret;
 }
 #endif /* MBEDTLS_CIPHER_MODE_XTS */
 
@@ -1445,6 +1550,7 @@ int mbedtls_aes_crypt_ctr(mbedtls_aes_context *ctx,
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
 
     size_t offset = *nc_off;
+    unsigned char keystream[AES_BATCH_BLOCKS * 16];
 
     if (offset > 0x0F) {
         return MBEDTLS_ERR_AES_BAD_INPUT_DATA;
@@ -1452,6 +1558,25 @@ int mbedtls_aes_crypt_ctr(mbedtls_aes_context *ctx,
 
     for (size_t i = 0; i < length;) {
         size_t n = 16;
+        if (offset == 0 && length - i >= sizeof(keystream)) {
+            /* Generate several blocks of keystream at once. */
+            for (size_t j = 0; j < sizeof(keystream); j += 16) {
+                memcpy(keystream + j, nonce_counter, 16);
+                mbedtls_ctr_increment_counter(nonce_counter);
+            }
+
+            ret = aes_crypt_ecb_blocks(ctx, MBEDTLS_AES_ENCRYPT, AES_BATCH_BLOCKS,
+                                       keystream, keystream);
+            if (ret != 0) {
+                goto exit;
+            }
+
+            mbedtls_xor(&output[i], &input[i], keystream, sizeof(keystream));
+            memcpy(stream_block, keystream + sizeof(keystream) - 16, 16);
+            i += sizeof(keystream);
+            continue;
+        }
+
         if (offset == 0) {
             ret = mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, nonce_counter, stream_block);
             if (ret != 0) {
@@ -1477,6 +1602,7 @@ int mbedtls_aes_crypt_ctr(mbedtls_aes_context *ctx,
     ret = 0;
 
 exit:
+    mbedtls_platform_zeroize(keystream, sizeof(keystream));
     return ret;
 }
 #endif /* MBEDTLS_CIPHER_MODE_CTR */
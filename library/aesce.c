@@ -285,6 +285,124 @@ int mbedtls_aesce_crypt_ecb(mbedtls_aes_context *ctx,
     return 0;
 }
 
+/* Four interleaved blocks of AESCE encryption. The loop is not unrolled
+ * by hand: with four independent blocks per round there is enough work
+ * in flight to hide the latency of AESE/AESMC. */
+MBEDTLS_OPTIMIZE_FOR_PERFORMANCE
+static void aesce_encrypt_block_x4(uint8x16_t *b0, uint8x16_t *b1,
+                                   uint8x16_t *b2, uint8x16_t *b3,
+                                   const unsigned char *keys,
+                                   int rounds)
+{
+    uint8x16_t k;
+    int i;
+
+    for (i = 0; i < rounds - 1; i++) {
+        k = vld1q_u8(keys);
+        *b0 = vaesmcq_u8(vaeseq_u8(*b0, k));
+        *b1 = vaesmcq_u8(vaeseq_u8(*b1, k));
+        *b2 = vaesmcq_u8(vaeseq_u8(*b2, k));
+        *b3 = vaesmcq_u8(vaeseq_u8(*b3, k));
+        keys += 16;
+    }
+
+    /* Final round: no MixColumns */
+    k = vld1q_u8(keys);
+    *b0 = vaeseq_u8(*b0, k);
+    *b1 = vaeseq_u8(*b1, k);
+    *b2 = vaeseq_u8(*b2, k);
+    *b3 = vaeseq_u8(*b3, k);
+    keys += 16;
+
+    /* Final AddRoundKey */
+    k = vld1q_u8(keys);
+    *b0 = veorq_u8(*b0, k);
+    *b1 = veorq_u8(*b1, k);
+    *b2 = veorq_u8(*b2, k);
+    *b3 = veorq_u8(*b3, k);
+}
+
+#if !defined(MBEDTLS_BLOCK_CIPHER_NO_DECRYPT)
+/* Four interleaved blocks of AESCE decryption, see aesce_decrypt_block()
+ * for the order of the operations. */
+MBEDTLS_OPTIMIZE_FOR_PERFORMANCE
+static void aesce_decrypt_block_x4(uint8x16_t *b0, uint8x16_t *b1,
+                                   uint8x16_t *b2, uint8x16_t *b3,
+                                   const unsigned char *keys,
+                                   int rounds)
+{
+    uint8x16_t k;
+    int i;
+
+    for (i = 0; i < rounds - 1; i++) {
+        k = vld1q_u8(keys);
+        *b0 = vaesimcq_u8(vaesdq_u8(*b0, k));
+        *b1 = vaesimcq_u8(vaesdq_u8(*b1, k));
+        *b2 = vaesimcq_u8(vaesdq_u8(*b2, k));
+        *b3 = vaesimcq_u8(vaesdq_u8(*b3, k));
+        keys += 16;
+    }
+
+    k = vld1q_u8(keys);
+    *b0 = vaesdq_u8(*b0, k);
+    *b1 = vaesdq_u8(*b1, k);
+    *b2 = vaesdq_u8(*b2, k);
+    *b3 = vaesdq_u8(*b3, k);
+    keys += 16;
+
+    k = vld1q_u8(keys);
+    *b0 = veorq_u8(*b0, k);
+    *b1 = veorq_u8(*b1, k);
+    *b2 = veorq_u8(*b2, k);
+    *b3 = veorq_u8(*b3, k);
+}
+#endif
+
+/*
+ * AES-ECB en(de)cryption of several blocks, four at a time
+ */
+int mbedtls_aesce_crypt_ecb_blocks(mbedtls_aes_context *ctx,
+                                   int mode,
+                                   size_t blocks,
+                                   const unsigned char *input,
+                                   unsigned char *output)
+{
+    const unsigned char *keys = (const unsigned char *) (ctx->buf + ctx->rk_offset);
+    uint8x16_t b0, b1, b2, b3;
+
+    for (; blocks >= 4; blocks -= 4) {
+        b0 = vld1q_u8(input);
+        b1 = vld1q_u8(input + 16);
+        b2 = vld1q_u8(input + 32);
+        b3 = vld1q_u8(input + 48);
+
+#if !defined(MBEDTLS_BLOCK_CIPHER_NO_DECRYPT)
+        if (mode == MBEDTLS_AES_DECRYPT) {
+            aesce_decrypt_block_x4(&b0, &b1, &b2, &b3, keys, ctx->nr);
+        } else
+#endif
+        {
+            aesce_encrypt_block_x4(&b0, &b1, &b2, &b3, keys, ctx->nr);
+        }
+
+        vst1q_u8(output, b0);
+        vst1q_u8(output + 16, b1);
+        vst1q_u8(output + 32, b2);
+        vst1q_u8(output + 48, b3);
+
+        input += 64;
+        output += 64;
+    }
+
+    for (; blocks > 0; blocks--) {
+        mbedtls_aesce_crypt_ecb(ctx, mode, input, output);
+        input += 16;
+        output += 16;
+    }
+
+    return 0;
+}
+
 /*
  * Compute decryption round keys from encryption round keys
  */
@@ -602,6 +720,96 @@ void mbedtls_aesce_gcm_mult(unsigned char c[16],
     vst1q_u8(&c[0], vc);
 }
 
+/*
+ * GHASH of four blocks with a single reduction:
+ * returns (x + c0) * H^4 + c1 * H^3 + c2 * H^2 + c3 * H,
+ * where h = { H^4, H^3, H^2, H }. x, h and the result are bit-reflected,
+ * c is in GCM order.
+ */
+static inline uint8x16_t aesce_gcm_ghash4(uint8x16_t x,
+                                          const unsigned char *c,
+                                          const uint8x16_t h[4])
+{
+    uint8x16x3_t sum, prod;
+    int i;
+
+    sum = poly_mult_128(veorq_u8(vrbitq_u8(vld1q_u8(c)), x), h[0]);
+    for (i = 1; i < 4; i++) {
+        prod = poly_mult_128(vrbitq_u8(vld1q_u8(c + 16 * i)), h[i]);
+        sum.val[0] = veorq_u8(sum.val[0], prod.val[0]);
+        sum.val[1] = veorq_u8(sum.val[1], prod.val[1]);
+        sum.val[2] = veorq_u8(sum.val[2], prod.val[2]);
+    }
+
+    /* The reduction is linear, so reduce the sum of the products once */
+    return poly_mult_reduce(sum);
+}
+
+/*
+ * GCM bulk encryption/decryption: AES-CTR stitched with GHASH, four blocks
+ * at a time. The ciphertext hashed in each iteration (the input when
+ * decrypting, the previous output when encrypting) does not depend on the
+ * counter blocks being encrypted, so PMULL and AESE can run in parallel.
+ */
+int mbedtls_aesce_gcm_crypt_blocks(mbedtls_aes_context *ctx,
+                                   int mode,
+                                   const unsigned char *hpow,
+                                   unsigned char y[16],
+                                   unsigned char x[16],
+                                   size_t blocks,
+                                   const unsigned char *input,
+                                   unsigned char *output)
+{
+    const unsigned char *keys = (const unsigned char *) (ctx->buf + ctx->rk_offset);
+    const unsigned char *pending = NULL;
+    unsigned char ctr[64];
+    uint32_t counter = MBEDTLS_GET_UINT32_BE(y, 12);
+    uint8x16_t h[4], vx, b0, b1, b2, b3;
+    size_t i;
+
+    for (i = 0; i < 4; i++) {
+        h[i] = vrbitq_u8(vld1q_u8(hpow + 16 * i));
+        memcpy(ctr + 16 * i, y, 12);
+    }
+    vx = vrbitq_u8(vld1q_u8(x));
+
+    for (; blocks >= 4; blocks -= 4) {
+        for (i = 0; i < 4; i++) {
+            MBEDTLS_PUT_UINT32_BE(++counter, ctr + 16 * i, 12);
+        }
+        b0 = vld1q_u8(ctr);
+        b1 = vld1q_u8(ctr + 16);
+        b2 = vld1q_u8(ctr + 32);
+        b3 = vld1q_u8(ctr + 48);
+
+        if (mode == MBEDTLS_AES_DECRYPT) {
+            vx = aesce_gcm_ghash4(vx, input, h);
+        } else if (pending != NULL) {
+            vx = aesce_gcm_ghash4(vx, pending, h);
+        }
+
+        aesce_encrypt_block_x4(&b0, &b1, &b2, &b3, keys, ctx->nr);
+
+        vst1q_u8(output, veorq_u8(b0, vld1q_u8(input)));
+        vst1q_u8(output + 16, veorq_u8(b1, vld1q_u8(input + 16)));
+        vst1q_u8(output + 32, veorq_u8(b2, vld1q_u8(input + 32)));
+        vst1q_u8(output + 48, veorq_u8(b3, vld1q_u8(input + 48)));
+
+        pending = output;
+        input += 64;
+        output += 64;
+    }
+
+    if (mode != MBEDTLS_AES_DECRYPT && pending != NULL) {
+        vx = aesce_gcm_ghash4(vx, pending, h);
+    }
+
+    vst1q_u8(x, vrbitq_u8(vx));
+    MBEDTLS_PUT_UINT32_BE(counter, y, 12);
+
+    return 0;
+}
+
 #endif /* MBEDTLS_GCM_C */
 
 #if defined(MBEDTLS_POP_TARGET_PRAGMA)
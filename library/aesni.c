@@ -15,6 +15,7 @@
 #if defined(MBEDTLS_AESNI_C)
 
 #include "aesni.h"
+#include "mbedtls/platform_util.h"
 
 #include <string.h>
 
@@ -130,6 +131,76 @@ int mbedtls_aesni_crypt_ecb(mbedtls_aes_context *ctx,
     return 0;
 }
 
+/*
+ * AES-NI AES-ECB en(de)cryption of several blocks, four at a time
+ */
+int mbedtls_aesni_crypt_ecb_blocks(mbedtls_aes_context *ctx,
+                                   int mode,
+                                   size_t blocks,
+                                   const unsigned char *input,
+                                   unsigned char *output)
+{
+    const __m128i *rk = (const __m128i *) (ctx->buf + ctx->rk_offset);
+    unsigned nr = ctx->nr;
+    __m128i s0, s1, s2, s3, k;
+    unsigned i;
+
+    for (; blocks >= 4; blocks -= 4) {
+        k = rk[0];
+        s0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) input), k);
+        s1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) input + 1), k);
+        s2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) input + 2), k);
+        s3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) input + 3), k);
+
+#if !defined(MBEDTLS_BLOCK_CIPHER_NO_DECRYPT)
+        if (mode == MBEDTLS_AES_DECRYPT) {
+            for (i = 1; i < nr; i++) {
+                k = rk[i];
+                s0 = _mm_aesdec_si128(s0, k);
+                s1 = _mm_aesdec_si128(s1, k);
+                s2 = _mm_aesdec_si128(s2, k);
+                s3 = _mm_aesdec_si128(s3, k);
+            }
+            k = rk[nr];
+            s0 = _mm_aesdeclast_si128(s0, k);
+            s1 = _mm_aesdeclast_si128(s1, k);
+            s2 = _mm_aesdeclast_si128(s2, k);
+            s3 = _mm_aesdeclast_si128(s3, k);
+        } else
+#endif
+        {
+            for (i = 1; i < nr; i++) {
+                k = rk[i];
+                s0 = _mm_aesenc_si128(s0, k);
+                s1 = _mm_aesenc_si128(s1, k);
+                s2 = _mm_aesenc_si128(s2, k);
+                s3 = _mm_aesenc_si128(s3, k);
+            }
+            k = rk[nr];
+            s0 = _mm_aesenclast_si128(s0, k);
+            s1 = _mm_aesenclast_si128(s1, k);
+            s2 = _mm_aesenclast_si128(s2, k);
+            s3 = _mm_aesenclast_si128(s3, k);
+        }
+
+        _mm_storeu_si128((__m128i *) output, s0);
+        _mm_storeu_si128((__m128i *) output + 1, s1);
+        _mm_storeu_si128((__m128i *) output + 2, s2);
+        _mm_storeu_si128((__m128i *) output + 3, s3);
+
+        input += 64;
+        output += 64;
+    }
+
+    for (; blocks > 0; blocks--) {
+        mbedtls_aesni_crypt_ecb(ctx, mode, input, output);
+        input += 16;
+        output += 16;
+    }
+
+    return 0;
+}
+
 /*
  * GCM multiplication: c = a times b in GF(2^128)
  * Based on [CLMUL-WP] algorithms 1 (with equation 27) and 5.
@@ -231,6 +302,133 @@ void mbedtls_aesni_gcm_mult(unsigned char c[16],
     return;
 }
 
+/*
+ * Byte-reverse a 128-bit value with SSE2 only (PSHUFB needs SSSE3,
+ * which is not implied by the AES-NI target options).
+ */
+static __m128i gcm_bswap(__m128i xx)
+{
+    xx = _mm_shuffle_epi32(xx, 0x4E);             // swap 64-bit halves
+    xx = _mm_shufflelo_epi16(xx, 0x1B);           // reverse 16-bit words
+    xx = _mm_shufflehi_epi16(xx, 0x1B);
+    return _mm_or_si128(_mm_slli_epi16(xx, 8),    // swap bytes in words
+                        _mm_srli_epi16(xx, 8));
+}
+
+/*
+ * GHASH of four blocks with a single reduction:
+ * returns (xx + c0) * H^4 + c1 * H^3 + c2 * H^2 + c3 * H
+ * where hh = { H^4, H^3, H^2, H }. xx, hh and the result are byte-reversed,
+ * c is in GCM order.
+ */
+static __m128i gcm_ghash4(__m128i xx, const unsigned char *c,
+                          const __m128i hh[4])
+{
+    __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128(), cc, dd;
+
+    for (int i = 0; i < 4; i++) {
+        __m128i aa = gcm_bswap(_mm_loadu_si128((const __m128i *) c + i));
+        if (i == 0) {
+            aa = _mm_xor_si128(aa, xx);
+        }
+        gcm_clmul(aa, hh[i], &cc, &dd);
+        lo = _mm_xor_si128(lo, cc);
+        hi = _mm_xor_si128(hi, dd);
+    }
+
+    /* The reduction is linear, so reduce the sum of the products once */
+    gcm_shift(&lo, &hi);
+    __m128i dx = gcm_reduce(lo);
+    __m128i xh = gcm_mix(dx);
+    return _mm_xor_si128(xh, hi);
+}
+
+/*
+ * GCM bulk encryption/decryption: AES-CTR stitched with GHASH.
+ * When decrypting, the GHASH input is the ciphertext that is about to be
+ * decrypted; when encrypting, it is the ciphertext produced by the previous
+ * iteration. Either way the multiplications do not depend on the AES rounds
+ * running alongside them, so the processor can overlap the two.
+ */
+int mbedtls_aesni_gcm_crypt_blocks(mbedtls_aes_context *ctx,
+                                   int mode,
+                                   const unsigned char *hpow,
+                                   unsigned char y[16],
+                                   unsigned char x[16],
+                                   size_t blocks,
+                                   const unsigned char *input,
+                                   unsigned char *output)
+{
+    const __m128i *rk = (const __m128i *) (ctx->buf + ctx->rk_offset);
+    unsigned nr = ctx->nr;
+    const unsigned char *pending = NULL;
+    __m128i hh[4], xx, yy, s0, s1, s2, s3, k;
+    unsigned i;
+
+    /* The round keys are aligned by mbedtls_aes_crypt_ecb(), but the
+     * context may have moved since. Let the caller go the slow way. */
+    if (((uintptr_t) rk & 15) != 0) {
+        return 1;
+    }
+
+    for (i = 0; i < 4; i++) {
+        hh[i] = gcm_bswap(_mm_loadu_si128((const __m128i *) hpow + i));
+    }
+    xx = gcm_bswap(_mm_loadu_si128((const __m128i *) x));
+    /* Byte-reversed, the 32-bit big-endian counter is the low lane */
+    yy = gcm_bswap(_mm_loadu_si128((const __m128i *) y));
+
+    for (; blocks >= 4; blocks -= 4) {
+        k = rk[0];
+        s0 = _mm_xor_si128(gcm_bswap(_mm_add_epi32(yy, _mm_set_epi32(0, 0, 0, 1))), k);
+        s1 = _mm_xor_si128(gcm_bswap(_mm_add_epi32(yy, _mm_set_epi32(0, 0, 0, 2))), k);
+        s2 = _mm_xor_si128(gcm_bswap(_mm_add_epi32(yy, _mm_set_epi32(0, 0, 0, 3))), k);
+        s3 = _mm_xor_si128(gcm_bswap(_mm_add_epi32(yy, _mm_set_epi32(0, 0, 0, 4))), k);
+        yy = _mm_add_epi32(yy, _mm_set_epi32(0, 0, 0, 4));
+
+        if (mode == MBEDTLS_AES_DECRYPT) {
+            xx = gcm_ghash4(xx, input, hh);
+        } else if (pending != NULL) {
+            xx = gcm_ghash4(xx, pending, hh);
+        }
+
+        for (i = 1; i < nr; i++) {
+            k = rk[i];
+            s0 = _mm_aesenc_si128(s0, k);
+            s1 = _mm_aesenc_si128(s1, k);
+            s2 = _mm_aesenc_si128(s2, k);
+            s3 = _mm_aesenc_si128(s3, k);
+        }
+        k = rk[nr];
+        s0 = _mm_aesenclast_si128(s0, k);
+        s1 = _mm_aesenclast_si128(s1, k);
+        s2 = _mm_aesenclast_si128(s2, k);
+        s3 = _mm_aesenclast_si128(s3, k);
+
+        s0 = _mm_xor_si128(s0, _mm_loadu_si128((const __m128i *) input));
+        s1 = _mm_xor_si128(s1, _mm_loadu_si128((const __m128i *) input + 1));
+        s2 = _mm_xor_si128(s2, _mm_loadu_si128((const __m128i *) input + 2));
+        s3 = _mm_xor_si128(s3, _mm_loadu_si128((const __m128i *) input + 3));
+        _mm_storeu_si128((__m128i *) output, s0);
+        _mm_storeu_si128((__m128i *) output + 1, s1);
+        _mm_storeu_si128((__m128i *) output + 2, s2);
+        _mm_storeu_si128((__m128i *) output + 3, s3);
+
+        pending = output;
+        input += 64;
+        output += 64;
+    }
+
+    if (mode != MBEDTLS_AES_DECRYPT && pending != NULL) {
+        xx = gcm_ghash4(xx, pending, hh);
+    }
+
+    _mm_storeu_si128((__m128i *) x, gcm_bswap(xx));
+    _mm_storeu_si128((__m128i *) y, gcm_bswap(yy));
+
+    return 0;
+}
+
 /*
  * Compute decryption round keys from encryption round keys
  */
@@ -458,6 +656,10 @@ static void aesni_setkey_enc_256(unsigned char *rk_bytes,
 #define xmm0_xmm4   "0xE0"
 #define xmm1_xmm0   "0xC1"
 #define xmm1_xmm2   "0xD1"
+#define xmm4_xmm0   "0xC4"
+#define xmm4_xmm1   "0xCC"
+#define xmm4_xmm2   "0xD4"
+#define xmm4_xmm3   "0xDC"
 
 /*
  * AES-NI AES-ECB block en(de)cryption
@@ -506,6 +708,90 @@ int mbedtls_aesni_crypt_ecb(mbedtls_aes_context *ctx,
     return 0;
 }
 
+/*
+ * AES-NI AES-ECB en(de)cryption of several blocks, four at a time
+ */
+int mbedtls_aesni_crypt_ecb_blocks(mbedtls_aes_context *ctx,
+                                   int mode,
+                                   size_t blocks,
+                                   const unsigned char *input,
+                                   unsigned char *output)
+{
+    for (; blocks >= 4; blocks -= 4) {
+        unsigned nr = ctx->nr;
+        const uint32_t *rk = ctx->buf + ctx->rk_offset;
+
+        /* volatile: the only outputs are the clobbered counters, the
+         * actual result is written to memory */
+        asm volatile ("movdqu    (%3), %%xmm0    \n\t" // load input
+                      "movdqu  16(%3), %%xmm1    \n\t"
+                      "movdqu  32(%3), %%xmm2    \n\t"
+                      "movdqu  48(%3), %%xmm3    \n\t"
+                      "movdqu    (%1), %%xmm4    \n\t" // load round key 0
+                      "pxor      %%xmm4, %%xmm0  \n\t" // round 0
+                      "pxor      %%xmm4, %%xmm1  \n\t"
+                      "pxor      %%xmm4, %%xmm2  \n\t"
+                      "pxor      %%xmm4, %%xmm3  \n\t"
+                      "add       $16, %1         \n\t" // point to next round key
+                      "subl      $1, %0          \n\t" // normal rounds = nr - 1
+                      "test      %2, %2          \n\t" // mode?
+                      "jz        2f              \n\t" // 0 = decrypt
+
+                      "1:                        \n\t" // encryption loop
+                      "movdqu    (%1), %%xmm4    \n\t" // load round key
+                      AESENC(xmm4_xmm0)                // do round
+                      AESENC(xmm4_xmm1)
+                      AESENC(xmm4_xmm2)
+                      AESENC(xmm4_xmm3)
+                      "add       $16, %1         \n\t" // point to next round key
+                      "subl      $1, %0          \n\t" // loop
+                      "jnz       1b              \n\t"
+                      "movdqu    (%1), %%xmm4    \n\t" // load round key
+                      AESENCLAST(xmm4_xmm0)            // last round
+                      AESENCLAST(xmm4_xmm1)
+                      AESENCLAST(xmm4_xmm2)
+                      AESENCLAST(xmm4_xmm3)
+#if !defined(MBEDTLS_BLOCK_CIPHER_NO_DECRYPT)
+                      "jmp       3f              \n\t"
+
+                      "2:                        \n\t" // decryption loop
+                      "movdqu    (%1), %%xmm4    \n\t"
+                      AESDEC(xmm4_xmm0)                // do round
+                      AESDEC(xmm4_xmm1)
+                      AESDEC(xmm4_xmm2)
+                      AESDEC(xmm4_xmm3)
+                      "add       $16, %1         \n\t"
+                      "subl      $1, %0          \n\t"
+                      "jnz       2b              \n\t"
+                      "movdqu    (%1), %%xmm4    \n\t" // load round key
+                      AESDECLAST(xmm4_xmm0)            // last round
+                      AESDECLAST(xmm4_xmm1)
+                      AESDECLAST(xmm4_xmm2)
+                      AESDECLAST(xmm4_xmm3)
+#endif
+
+                      "3:                        \n\t"
+                      "movdqu    %%xmm0,   (%4)  \n\t" // export output
+                      "movdqu    %%xmm1, 16(%4)  \n\t"
+                      "movdqu    %%xmm2, 32(%4)  \n\t"
+                      "movdqu    %%xmm3, 48(%4)  \n\t"
+                      : "+r" (nr), "+r" (rk)
+                      : "r" (mode), "r" (input), "r" (output)
+                      : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4");
+
+        input += 64;
+        output += 64;
+    }
+
+    for (; blocks > 0; blocks--) {
+        mbedtls_aesni_crypt_ecb(ctx, mode, input, output);
+        input += 16;
+        output += 16;
+    }
+
+    return 0;
+}
+
 /*
  * GCM multiplication: c = a times b in GF(2^128)
  * Based on [CLMUL-WP] algorithms 1 (with equation 27) and 5.
@@ -618,6 +904,191 @@ void mbedtls_aesni_gcm_mult(unsigned char c[16],
     return;
 }
 
+/*
+ * Byte-reverse an XMM register in place, using xmm7 as scratch.
+ * SSE2 only: PSHUFB needs SSSE3, which we do not otherwise require.
+ */
+#define GCM_BSWAP(reg)                                                  \
+    "pshufd $0x4E, %%" reg ", %%" reg "   \n\t" /* swap 64-bit halves */ \
+    "pshuflw $0x1B, %%" reg ", %%" reg "  \n\t" /* reverse 16-bit words */ \
+    "pshufhw $0x1B, %%" reg ", %%" reg "  \n\t"                         \
+    "movdqa %%" reg ", %%xmm7             \n\t" /* swap bytes in words */ \
+    "psllw $8, %%" reg "                  \n\t"                         \
+    "psrlw $8, %%xmm7                     \n\t"                         \
+    "por %%xmm7, %%" reg "                \n\t"
+
+/*
+ * GHASH of four blocks with a single reduction:
+ * x = (x + c0) * H^4 + c1 * H^3 + c2 * H^2 + c3 * H
+ * where hpow = H^4 || H^3 || H^2 || H, everything in GCM order.
+ */
+static void aesni_gcm_ghash4(unsigned char x[16],
+                             const unsigned char *c,
+                             const unsigned char *hpow)
+{
+    unsigned n = 4;
+
+    asm volatile ("movdqu (%3), %%xmm6               \n\t" // x
+                  "pxor %%xmm1, %%xmm1               \n\t" // sum of low products
+                  "pxor %%xmm2, %%xmm2               \n\t" // sum of high products
+                  "pxor %%xmm5, %%xmm5               \n\t" // sum of middle products
+
+                  "1:                                \n\t"
+                  "movdqu (%0), %%xmm0               \n\t" // next block
+                  "pxor %%xmm6, %%xmm0               \n\t" // add x (first block only)
+                  "pxor %%xmm6, %%xmm6               \n\t"
+                  GCM_BSWAP("xmm0")                        // a1:a0
+                  "movdqu (%1), %%xmm3               \n\t" // next power of H
+                  GCM_BSWAP("xmm3")                        // b1:b0
+
+                  /*
+                   * Caryless multiplication using [CLMUL-WP] algorithm 1
+                   * (p. 12), accumulating the partial products.
+                   */
+                  "movdqa %%xmm3, %%xmm4             \n\t"
+                  PCLMULQDQ(xmm0_xmm4, "0x00")             // a0*b0 = c1:c0
+                  "pxor %%xmm4, %%xmm1               \n\t"
+                  "movdqa %%xmm3, %%xmm4             \n\t"
+                  PCLMULQDQ(xmm0_xmm4, "0x11")             // a1*b1 = d1:d0
+                  "pxor %%xmm4, %%xmm2               \n\t"
+                  "movdqa %%xmm3, %%xmm4             \n\t"
+                  PCLMULQDQ(xmm0_xmm4, "0x10")             // a0*b1 = e1:e0
+                  "pxor %%xmm4, %%xmm5               \n\t"
+                  PCLMULQDQ(xmm0_xmm3, "0x01")             // a1*b0 = f1:f0
+                  "pxor %%xmm3, %%xmm5               \n\t"
+
+                  "add $16, %0                       \n\t"
+                  "add $16, %1                       \n\t"
+                  "subl $1, %2                       \n\t"
+                  "jnz 1b                            \n\t"
+
+                  "movdqa %%xmm5, %%xmm3             \n\t" // sum of e+f
+                  "psrldq $8, %%xmm5                 \n\t" // 0:e1+f1
+                  "pslldq $8, %%xmm3                 \n\t" // e0+f0:0
+                  "pxor %%xmm5, %%xmm2               \n\t" // d1:d0+e1+f1
+                  "pxor %%xmm3, %%xmm1               \n\t" // c1+e0+f1:c0
+
+                  /*
+                   * Now shift the result one bit to the left,
+                   * taking advantage of [CLMUL-WP] eq 27 (p. 18)
+                   */
+                  "movdqa %%xmm1, %%xmm3             \n\t" // r1:r0
+                  "movdqa %%xmm2, %%xmm4             \n\t" // r3:r2
+                  "psllq $1, %%xmm1                  \n\t" // r1<<1:r0<<1
+                  "psllq $1, %%xmm2                  \n\t" // r3<<1:r2<<1
+                  "psrlq $63, %%xmm3                 \n\t" // r1>>63:r0>>63
+                  "psrlq $63, %%xmm4                 \n\t" // r3>>63:r2>>63
+                  "movdqa %%xmm3, %%xmm5             \n\t" // r1>>63:r0>>63
+                  "pslldq $8, %%xmm3                 \n\t" // r0>>63:0
+                  "pslldq $8, %%xmm4                 \n\t" // r2>>63:0
+                  "psrldq $8, %%xmm5                 \n\t" // 0:r1>>63
+                  "por %%xmm3, %%xmm1                \n\t" // r1<<1|r0>>63:r0<<1
+                  "por %%xmm4, %%xmm2                \n\t" // r3<<1|r2>>62:r2<<1
+                  "por %%xmm5, %%xmm2                \n\t" // r3<<1|r2>>62:r2<<1|r1>>63
+
+                  /*
+                   * Now reduce modulo the GCM polynomial x^128 + x^7 + x^2 + x + 1
+                   * using [CLMUL-WP] algorithm 5 (p. 18).
+                   * Currently xmm2:xmm1 holds x3:x2:x1:x0 (already shifted).
+                   */
+                  /* Step 2 (1) */
+                  "movdqa %%xmm1, %%xmm3             \n\t" // x1:x0
+                  "movdqa %%xmm1, %%xmm4             \n\t" // same
+                  "movdqa %%xmm1, %%xmm5             \n\t" // same
+                  "psllq $63, %%xmm3                 \n\t" // x1<<63:x0<<63 = stuff:a
+                  "psllq $62, %%xmm4                 \n\t" // x1<<62:x0<<62 = stuff:b
+                  "psllq $57, %%xmm5                 \n\t" // x1<<57:x0<<57 = stuff:c
+
+                  /* Step 2 (2) */
+                  "pxor %%xmm4, %%xmm3               \n\t" // stuff:a+b
+                  "pxor %%xmm5, %%xmm3               \n\t" // stuff:a+b+c
+                  "pslldq $8, %%xmm3                 \n\t" // a+b+c:0
+                  "pxor %%xmm3, %%xmm1               \n\t" // x1+a+b+c:x0 = d:x0
+
+                  /* Steps 3 and 4 */
+                  "movdqa %%xmm1,%%xmm0              \n\t" // d:x0
+                  "movdqa %%xmm1,%%xmm4              \n\t" // same
+                  "movdqa %%xmm1,%%xmm5              \n\t" // same
+                  "psrlq $1, %%xmm0                  \n\t" // e1:x0>>1 = e1:e0'
+                  "psrlq $2, %%xmm4                  \n\t" // f1:x0>>2 = f1:f0'
+                  "psrlq $7, %%xmm5                  \n\t" // g1:x0>>7 = g1:g0'
+                  "pxor %%xmm4, %%xmm0               \n\t" // e1+f1:e0'+f0'
+                  "pxor %%xmm5, %%xmm0               \n\t" // e1+f1+g1:e0'+f0'+g0'
+                  // e0'+f0'+g0' is almost e0+f0+g0, except for some missing
+                  // bits carried from d. Now get those bits back in.
+                  "movdqa %%xmm1,%%xmm3              \n\t" // d:x0
+                  "movdqa %%xmm1,%%xmm4              \n\t" // same
+                  "movdqa %%xmm1,%%xmm5              \n\t" // same
+                  "psllq $63, %%xmm3                 \n\t" // d<<63:stuff
+                  "psllq $62, %%xmm4                 \n\t" // d<<62:stuff
+                  "psllq $57, %%xmm5                 \n\t" // d<<57:stuff
+                  "pxor %%xmm4, %%xmm3               \n\t" // d<<63+d<<62:stuff
+                  "pxor %%xmm5, %%xmm3               \n\t" // missing bits of d:stuff
+                  "psrldq $8, %%xmm3                 \n\t" // 0:missing bits of d
+                  "pxor %%xmm3, %%xmm0               \n\t" // e1+f1+g1:e0+f0+g0
+                  "pxor %%xmm1, %%xmm0               \n\t" // h1:h0
+                  "pxor %%xmm2, %%xmm0               \n\t" // x3+h1:x2+h0
+
+                  GCM_BSWAP("xmm0")
+                  "movdqu %%xmm0, (%3)               \n\t" // done
+                  : "+r" (c), "+r" (hpow), "+r" (n)
+                  : "r" (x)
+                  : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4",
+                  "xmm5", "xmm6", "xmm7");
+}
+
+/*
+ * GCM bulk encryption/decryption, see the intrinsics version above.
+ * The two asm blocks are independent, so they overlap in the pipeline.
+ */
+int mbedtls_aesni_gcm_crypt_blocks(mbedtls_aes_context *ctx,
+                                   int mode,
+                                   const unsigned char *hpow,
+                                   unsigned char y[16],
+                                   unsigned char x[16],
+                                   size_t blocks,
+                                   const unsigned char *input,
+                                   unsigned char *output)
+{
+    unsigned char ctr[64];
+    unsigned char ectr[64];
+    const unsigned char *pending = NULL;
+    uint32_t counter = MBEDTLS_GET_UINT32_BE(y, 12);
+    size_t i;
+
+    for (i = 0; i < 4; i++) {
+        memcpy(ctr + 16 * i, y, 12);
+    }
+
+    for (; blocks >= 4; blocks -= 4) {
+        for (i = 0; i < 4; i++) {
+            MBEDTLS_PUT_UINT32_BE(++counter, ctr + 16 * i, 12);
+        }
+
+        if (mode == MBEDTLS_AES_DECRYPT) {
+            aesni_gcm_ghash4(x, input, hpow);
+        } else if (pending != NULL) {
+            aesni_gcm_ghash4(x, pending, hpow);
+        }
+
+        mbedtls_aesni_crypt_ecb_blocks(ctx, MBEDTLS_AES_ENCRYPT, 4, ctr, ectr);
+        mbedtls_xor(output, input, ectr, 64);
+
+        pending = output;
+        input += 64;
+        output += 64;
+    }
+
+    if (mode != MBEDTLS_AES_DECRYPT && pending != NULL) {
+        aesni_gcm_ghash4(x, pending, hpow);
+    }
+
+    MBEDTLS_PUT_UINT32_BE(counter, y, 12);
+    mbedtls_platform_zeroize(ectr, sizeof(ectr));
+
+    return 0;
+}
+
 /*
  * Compute decryption round keys from encryption round keys
  */
@@ -102,6 +102,34 @@ int mbedtls_aesni_crypt_ecb(mbedtls_aes_context *ctx,
                             const unsigned char input[16],
                             unsigned char output[16]);
 
+/**
+ * \brief          Internal AES-NI AES-ECB encryption and decryption of
+ *                 several independent blocks
+ *
+ * \note           This function is only for internal use by other library
+ *                 functions; you must not call it directly.
+ *
+ * \note           Blocks are processed four at a time, with the rounds of
+ *                 the four blocks interleaved to keep the AES unit busy.
+ *                 This is what makes the parallelizable modes (CTR,
+ *                 CBC decryption, XTS) faster than one call to
+ *                 mbedtls_aesni_crypt_ecb() per block.
+ *
+ * \param ctx      AES context
+ * \param mode     MBEDTLS_AES_ENCRYPT or MBEDTLS_AES_DECRYPT
+ * \param blocks   Number of 16-byte blocks to process
+ * \param input    Input blocks (\p blocks * 16 bytes)
+ * \param output   Output blocks (\p blocks * 16 bytes). This may be
+ *                 the same buffer as \p input.
+ *
+ * \return         0 on success (cannot fail)
+ */
+int mbedtls_aesni_crypt_ecb_blocks(mbedtls_aes_context *ctx,
+                                   int mode,
+                                   size_t blocks,
+                                   const unsigned char *input,
+                                   unsigned char *output);
+
 /**
  * \brief          Internal GCM multiplication: c = a * b in GF(2^128)
  *
@@ -119,6 +147,45 @@ void mbedtls_aesni_gcm_mult(unsigned char c[16],
                             const unsigned char a[16],
                             const unsigned char b[16]);
 
+/**
+ * \brief          Internal GCM bulk function: encrypt successive counter
+ *                 blocks, XOR them with the input and fold the ciphertext
+ *                 into the GHASH state, four blocks at a time. The AES
+ *                 rounds of four counter blocks are interleaved with the
+ *                 carry-less multiplications of four ciphertext blocks,
+ *                 which share a single reduction.
+ *
+ * \note           This function is only for internal use by other library
+ *                 functions; you must not call it directly.
+ *
+ * \param ctx      AES context set up for encryption
+ * \param mode     MBEDTLS_AES_ENCRYPT for GCM encryption or
+ *                 MBEDTLS_AES_DECRYPT for GCM decryption
+ * \param hpow     H^4, H^3, H^2 and H, in this order (64 bytes)
+ * \param y        Counter block. It is incremented before each block,
+ *                 so on exit it holds the last counter value used.
+ * \param x        GHASH state, updated in place
+ * \param blocks   Number of 16-byte blocks to process (multiple of 4)
+ * \param input    Input data (\p blocks * 16 bytes)
+ * \param output   Output data (\p blocks * 16 bytes). This may be
+ *                 the same buffer as \p input.
+ *
+ * \note           \p hpow, \p y and \p x are bit strings interpreted as
+ *                 elements of GF(2^128) as per the GCM spec.
+ *
+ * \return         0 on success, or 1 if the round keys in \p ctx are not
+ *                 aligned as this implementation requires, in which case
+ *                 nothing was processed.
+ */
+int mbedtls_aesni_gcm_crypt_blocks(mbedtls_aes_context *ctx,
+                                   int mode,
+                                   const unsigned char *hpow,
+                                   unsigned char y[16],
+                                   unsigned char x[16],
+                                   size_t blocks,
+                                   const unsigned char *input,
+                                   unsigned char *output);
+
 #if !defined(MBEDTLS_BLOCK_CIPHER_NO_DECRYPT)
 /**
  * \brief           Internal round key inversion. This function computes
@@ -14,6 +14,7 @@
 #if defined(MBEDTLS_CHACHA20_C)
 
 #include "mbedtls/chacha20.h"
+#include "cpu_features.h"
 #include "mbedtls/platform_util.h"
 #include "mbedtls/error.h"
 
@@ -24,6 +25,28 @@
 
 #if !defined(MBEDTLS_CHACHA20_ALT)
 
+/*
+ * SIMD implementations generating several keystream blocks at once.
+ *
+ * SSE2 is always available on x86-64, and so is Neon when the compiler
+ * targets it (the same condition as the Neon path of mbedtls_xor()), so
+ * the four-block kernels need no runtime detection. The eight-block AVX2
+ * kernel is compiled with a target pragma and only used if the CPU and the
+ * operating system support AVX2.
+ */
+#if defined(MBEDTLS_ARCH_IS_X64) || \
+    (defined(MBEDTLS_ARCH_IS_X86) && (defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+#define CHACHA20_SIMD_X4_SSE2
+#include <emmintrin.h>
+#elif defined(MBEDTLS_HAVE_NEON_INTRINSICS) && !defined(__ARM_BIG_ENDIAN)
+#define CHACHA20_SIMD_X4_NEON
+#endif
+
+#if defined(MBEDTLS_CPU_HAVE_AVX2_DETECTION)
+#define CHACHA20_SIMD_X8_AVX2
+#include <immintrin.h>
+#endif
+
 #define ROTL32(value, amount) \
     ((uint32_t) ((value) << (amount)) | ((value) >> (32 - (amount))))
 
@@ -140,6 +163,272 @@ static void chacha20_block(const uint32_t initial_state[16],
     mbedtls_platform_zeroize(working_state, sizeof(working_state));
 }
 
+#if defined(CHACHA20_SIMD_X4_SSE2) || defined(CHACHA20_SIMD_X4_NEON)
+/*
+ * The multi-block kernels keep the state "vertically": vector i holds word i
+ * of the state of each of the blocks, so that a quarter round on vectors
+ * runs the same quarter round on all blocks at once. The words are
+ * transposed back to block order when the keystream is written out.
+ */
+#define CHACHA20_VQUARTER_ROUND(x, a, b, c, d)                            \
+    do {                                                                  \
+        x[a] = VADD(x[a], x[b]); x[d] = VROTL(VXOR(x[d], x[a]), 16);      \
+        x[c] = VADD(x[c], x[d]); x[b] = VROTL(VXOR(x[b], x[c]), 12);      \
+        x[a] = VADD(x[a], x[b]); x[d] = VROTL(VXOR(x[d], x[a]), 8);       \
+        x[c] = VADD(x[c], x[d]); x[b] = VROTL(VXOR(x[b], x[c]), 7);       \
+    } while (0)
+
+#define CHACHA20_VDOUBLE_ROUND(x)                                         \
+    do {                                                                  \
+        CHACHA20_VQUARTER_ROUND(x, 0, 4, 8,  12);                         \
+        CHACHA20_VQUARTER_ROUND(x, 1, 5, 9,  13);                         \
+        CHACHA20_VQUARTER_ROUND(x, 2, 6, 10, 14);                         \
+        CHACHA20_VQUARTER_ROUND(x, 3, 7, 11, 15);                         \
+        CHACHA20_VQUARTER_ROUND(x, 0, 5, 10, 15);                         \
+        CHACHA20_VQUARTER_ROUND(x, 1, 6, 11, 12);                         \
+        CHACHA20_VQUARTER_ROUND(x, 2, 7, 8,  13);                         \
+        CHACHA20_VQUARTER_ROUND(x, 3, 4, 9,  14);                         \
+    } while (0)
+#endif
+
+#if defined(CHACHA20_SIMD_X4_SSE2)
+#define VADD(a, b)      _mm_add_epi32(a, b)
+#define VXOR(a, b)      _mm_xor_si128(a, b)
+#define VROTL(v, n)     _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+
+/**
+ * \brief               Generates four consecutive keystream blocks (SSE2).
+ *
+ * \param initial_state The initial ChaCha20 state of the first block.
+ * \param keystream     Generated keystream bytes are written to this buffer.
+ */
+static void chacha20_blocks_x4(const uint32_t initial_state[16],
+                               unsigned char keystream[4 * 64])
+{
+    __m128i x[16], orig[16];
+    __m128i t0, t1, t2, t3;
+    size_t i;
+
+    for (i = 0U; i < 16U; i++) {
+        orig[i] = _mm_set1_epi32((int) initial_state[i]);
+    }
+    orig[CHACHA20_CTR_INDEX] = _mm_add_epi32(orig[CHACHA20_CTR_INDEX],
+                                             _mm_set_epi32(3, 2, 1, 0));
+    memcpy(x, orig, sizeof(x));
+
+    for (i = 0U; i < 10U; i++) {
+        CHACHA20_VDOUBLE_ROUND(x);
+    }
+
+    /* Add the initial state and transpose each group of four words */
+    for (i = 0U; i < 16U; i += 4U) {
+        t0 = _mm_add_epi32(x[i], orig[i]);
+        t1 = _mm_add_epi32(x[i + 1], orig[i + 1]);
+        t2 = _mm_add_epi32(x[i + 2], orig[i + 2]);
+        t3 = _mm_add_epi32(x[i + 3], orig[i + 3]);
+
+        x[i]     = _mm_unpacklo_epi32(t0, t1);
+        x[i + 1] = _mm_unpacklo_epi32(t2, t3);
+        x[i + 2] = _mm_unpackhi_epi32(t0, t1);
+        x[i + 3] = _mm_unpackhi_epi32(t2, t3);
+
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i),
+                         _mm_unpacklo_epi64(x[i], x[i + 1]));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 64U),
+                         _mm_unpackhi_epi64(x[i], x[i + 1]));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 128U),
+                         _mm_unpacklo_epi64(x[i + 2], x[i + 3]));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 192U),
+                         _mm_unpackhi_epi64(x[i + 2], x[i + 3]));
+    }
+
+    mbedtls_platform_zeroize(x, sizeof(x));
+    mbedtls_platform_zeroize(orig, sizeof(orig));
+    mbedtls_platform_zeroize(&t0, sizeof(t0));
+    mbedtls_platform_zeroize(&t1, sizeof(t1));
+    mbedtls_platform_zeroize(&t2, sizeof(t2));
+    mbedtls_platform_zeroize(&t3, sizeof(t3));
+}
+
+#undef VADD
+#undef VXOR
+#undef VROTL
+#endif /* CHACHA20_SIMD_X4_SSE2 */
+
+#if defined(CHACHA20_SIMD_X4_NEON)
+#define VADD(a, b)      vaddq_u32(a, b)
+#define VXOR(a, b)      veorq_u32(a, b)
+#define VROTL(v, n)     vsriq_n_u32(vshlq_n_u32(v, n), v, 32 - (n))
+
+/**
+ * \brief               Generates four consecutive keystream blocks (Neon).
+ *
+ * \param initial_state The initial ChaCha20 state of the first block.
+ * \param keystream     Generated keystream bytes are written to this buffer.
+ */
+static void chacha20_blocks_x4(const uint32_t initial_state[16],
+                               unsigned char keystream[4 * 64])
+{
+    static const uint32_t ctr_offsets[4] = { 0, 1, 2, 3 };
+    uint32x4_t x[16], orig[16];
+    uint32x4_t t0, t1, t2, t3;
+    uint32x4x2_t p, q;
+    size_t i;
+
+    for (i = 0U; i < 16U; i++) {
+        orig[i] = vdupq_n_u32(initial_state[i]);
+    }
+    orig[CHACHA20_CTR_INDEX] = vaddq_u32(orig[CHACHA20_CTR_INDEX],
+                                         vld1q_u32(ctr_offsets));
+    memcpy(x, orig, sizeof(x));
+
+    for (i = 0U; i < 10U; i++) {
+        CHACHA20_VDOUBLE_ROUND(x);
+    }
+
+    /* Add the initial state and transpose each group of four words */
+    for (i = 0U; i < 16U; i += 4U) {
+        t0 = vaddq_u32(x[i], orig[i]);
+        t1 = vaddq_u32(x[i + 1], orig[i + 1]);
+        t2 = vaddq_u32(x[i + 2], orig[i + 2]);
+        t3 = vaddq_u32(x[i + 3], orig[i + 3]);
+
+        p = vtrnq_u32(t0, t1);
+        q = vtrnq_u32(t2, t3);
+
+        vst1q_u32((uint32_t *) (keystream + 4U * i),
+                  vcombine_u32(vget_low_u32(p.val[0]), vget_low_u32(q.val[0])));
+        vst1q_u32((uint32_t *) (keystream + 4U * i + 64U),
+                  vcombine_u32(vget_low_u32(p.val[1]), vget_low_u32(q.val[1])));
+        vst1q_u32((uint32_t *) (keystream + 4U * i + 128U),
+                  vcombine_u32(vget_high_u32(p.val[0]), vget_high_u32(q.val[0])));
+        vst1q_u32((uint32_t *) (keystream + 4U * i + 192U),
+                  vcombine_u32(vget_high_u32(p.val[1]), vget_high_u32(q.val[1])));
+    }
+
+    mbedtls_platform_zeroize(x, sizeof(x));
+    mbedtls_platform_zeroize(orig, sizeof(orig));
+    mbedtls_platform_zeroize(&t0, sizeof(t0));
+    mbedtls_platform_zeroize(&t1, sizeof(t1));
+    mbedtls_platform_zeroize(&t2, sizeof(t2));
+    mbedtls_platform_zeroize(&t3, sizeof(t3));
+    mbedtls_platform_zeroize(&p, sizeof(p));
+    mbedtls_platform_zeroize(&q, sizeof(q));
+}
+
+#undef VADD
+#undef VXOR
+#undef VROTL
+#endif /* CHACHA20_SIMD_X4_NEON */
+
+#if defined(CHACHA20_SIMD_X8_AVX2)
+#if defined(MBEDTLS_COMPILER_IS_GCC)
+#pragma GCC push_options
+#pragma GCC target ("avx2")
+#define MBEDTLS_POP_TARGET_PRAGMA
+#elif defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#define MBEDTLS_POP_TARGET_PRAGMA
+#endif
+
+#define VADD(a, b)      _mm256_add_epi32(a, b)
+#define VXOR(a, b)      _mm256_xor_si256(a, b)
+#define VROTL(v, n)                                                      \
+    ((n) == 16 ? _mm256_shuffle_epi8(v, rot16) :                         \
+     (n) == 8 ? _mm256_shuffle_epi8(v, rot8) :                           \
+     _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n))))
+
+/**
+ * \brief               Generates eight consecutive keystream blocks (AVX2).
+ *
+ * \param initial_state The initial ChaCha20 state of the first block.
+ * \param keystream     Generated keystream bytes are written to this buffer.
+ */
+static void chacha20_blocks_x8(const uint32_t initial_state[16],
+                               unsigned char keystream[8 * 64])
+{
+    const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10,
+                                          5, 4, 7, 6, 1, 0, 3, 2,
+                                          13, 12, 15, 14, 9, 8, 11, 10,
+                                          5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11,
+                                         6, 5, 4, 7, 2, 1, 0, 3,
+                                         14, 13, 12, 15, 10, 9, 8, 11,
+                                         6, 5, 4, 7, 2, 1, 0, 3);
+    __m256i x[16], orig[16];
+    __m256i t0, t1, t2, t3;
+    size_t i;
+
+    for (i = 0U; i < 16U; i++) {
+        orig[i] = _mm256_set1_epi32((int) initial_state[i]);
+    }
+    orig[CHACHA20_CTR_INDEX] = _mm256_add_epi32(orig[CHACHA20_CTR_INDEX],
+                                                _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    memcpy(x, orig, sizeof(x));
+
+    for (i = 0U; i < 10U; i++) {
+        CHACHA20_VDOUBLE_ROUND(x);
+    }
+
+    /* Add the initial state and transpose each group of four words within
+     * the 128-bit lanes: the low lane then holds blocks 0-3 and the high
+     * lane blocks 4-7. */
+    for (i = 0U; i < 16U; i += 4U) {
+        t0 = _mm256_add_epi32(x[i], orig[i]);
+        t1 = _mm256_add_epi32(x[i + 1], orig[i + 1]);
+        t2 = _mm256_add_epi32(x[i + 2], orig[i + 2]);
+        t3 = _mm256_add_epi32(x[i + 3], orig[i + 3]);
+
+        x[i]     = _mm256_unpacklo_epi32(t0, t1);
+        x[i + 1] = _mm256_unpacklo_epi32(t2, t3);
+        x[i + 2] = _mm256_unpackhi_epi32(t0, t1);
+        x[i + 3] = _mm256_unpackhi_epi32(t2, t3);
+
+        t0 = _mm256_unpacklo_epi64(x[i], x[i + 1]);
+        t1 = _mm256_unpackhi_epi64(x[i], x[i + 1]);
+        t2 = _mm256_unpacklo_epi64(x[i + 2], x[i + 3]);
+        t3 = _mm256_unpackhi_epi64(x[i + 2], x[i + 3]);
+
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i),
+                         _mm256_castsi256_si128(t0));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 64U),
+                         _mm256_castsi256_si128(t1));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 128U),
+                         _mm256_castsi256_si128(t2));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 192U),
+                         _mm256_castsi256_si128(t3));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 256U),
+                         _mm256_extracti128_si256(t0, 1));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 320U),
+                         _mm256_extracti128_si256(t1, 1));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 384U),
+                         _mm256_extracti128_si256(t2, 1));
+        _mm_storeu_si128((__m128i *) (keystream + 4U * i + 448U),
+                         _mm256_extracti128_si256(t3, 1));
+    }
+
+    mbedtls_platform_zeroize(x, sizeof(x));
+    mbedtls_platform_zeroize(orig, sizeof(orig));
+    mbedtls_platform_zeroize(&t0, sizeof(t0));
+    mbedtls_platform_zeroize(&t1, sizeof(t1));
+    mbedtls_platform_zeroize(&t2, sizeof(t2));
+    mbedtls_platform_zeroize(&t3, sizeof(t3));
+}
+
+#undef VADD
+#undef VXOR
+#undef VROTL
+
+#if defined(MBEDTLS_POP_TARGET_PRAGMA)
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#undef MBEDTLS_POP_TARGET_PRAGMA
+#endif
+#endif /* CHACHA20_SIMD_X8_AVX2 */
+
 void mbedtls_chacha20_init(mbedtls_chacha20_context *ctx)
 {
     mbedtls_platform_zeroize(ctx->state, sizeof(ctx->state));
@@ -215,6 +504,42 @@ int mbedtls_chacha20_update(mbedtls_chacha20_context *ctx,
         size--;
     }
 
+#if defined(CHACHA20_SIMD_X8_AVX2)
+    if (size >= 8U * CHACHA20_BLOCK_SIZE_BYTES && mbedtls_cpu_has_avx2()) {
+        unsigned char keystream[8U * CHACHA20_BLOCK_SIZE_BYTES];
+
+        do {
+            chacha20_blocks_x8(ctx->state, keystream);
+            ctx->state[CHACHA20_CTR_INDEX] += 8U;
+
+            mbedtls_xor(output + offset, input + offset, keystream, sizeof(keystream));
+
+            offset += sizeof(keystream);
+            size   -= sizeof(keystream);
+        } while (size >= sizeof(keystream));
+
+        mbedtls_platform_zeroize(keystream, sizeof(keystream));
+    }
+#endif
+
+#if defined(CHACHA20_SIMD_X4_SSE2) || defined(CHACHA20_SIMD_X4_NEON)
+    if (size >= 4U * CHACHA20_BLOCK_SIZE_BYTES) {
+        unsigned char keystream[4U * CHACHA20_BLOCK_SIZE_BYTES];
+
+        do {
+            chacha20_blocks_x4(ctx->state, keystream);
+            ctx->state[CHACHA20_CTR_INDEX] += 4U;
+
+            mbedtls_xor(output + offset, input + offset, keystream, sizeof(keystream));
+
+            offset += sizeof(keystream);
+            size   -= sizeof(keystream);
+        } while (size >= sizeof(keystream));
+
+        mbedtls_platform_zeroize(keystream, sizeof(keystream));
+    }
+#endif
+
     /* Process full blocks */
     while (size >= CHACHA20_BLOCK_SIZE_BYTES) {
         /* Generate new keystream block and increment counter */
@@ -0,0 +1,88 @@
+/*
+ *  Runtime detection of x86 instruction set extensions
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+
+#include "common.h"
+
+#include "cpu_features.h"
+
+#if defined(MBEDTLS_CPU_HAVE_AVX2_DETECTION) || defined(MBEDTLS_CPU_HAVE_SHA_NI_DETECTION)
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(MBEDTLS_CPU_HAVE_AVX2_DETECTION)
+/*
+ * AVX2 support detection: the CPU must support AVX2, and the OS must save
+ * the YMM registers on context switches (OSXSAVE, XCR0 bits 1 and 2).
+ */
+int mbedtls_cpu_has_avx2(void)
+{
+    /* See mbedtls_aesni_has_support() about the use of volatile */
+    static volatile int done = 0;
+    static volatile int avx2 = 0;
+    unsigned int eax, ebx, ecx, edx;
+    uint32_t xcr0 = 0, xcr0_hi;
+
+    if (!done) {
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1U << 27)) != 0) {
+            /* xgetbv, as bytes for assemblers that do not know it */
+            asm volatile (".byte 0x0f, 0x01, 0xd0" : "=a" (xcr0), "=d" (xcr0_hi) : "c" (0));
+            (void) xcr0_hi;
+        }
+        if ((xcr0 & 6U) == 6U && __get_cpuid_max(0, NULL) >= 7) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            avx2 = (ebx & (1U << 5)) != 0;
+        }
+        done = 1;
+    }
+
+    return avx2;
+}
+#endif /* MBEDTLS_CPU_HAVE_AVX2_DETECTION */
+
+#if defined(MBEDTLS_CPU_HAVE_SHA_NI_DETECTION)
+/*
+ * SHA-NI support detection: the SHA extensions (CPUID.(EAX=7,ECX=0):EBX[29])
+ * plus SSSE3 and SSE4.1, which the kernels also use.
+ */
+int mbedtls_cpu_has_sha_ni(void)
+{
+    /* See mbedtls_aesni_has_support() about the use of volatile */
+    static volatile int done = 0;
+    static volatile int supported = 0;
+    unsigned int ecx1, ebx7;
+
+    if (!done) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+
+        __cpuid(info, 0);
+        if (info[0] >= 7) {
+            __cpuid(info, 1);
+            ecx1 = (unsigned int) info[2];
+            __cpuidex(info, 7, 0);
+            ebx7 = (unsigned int) info[1];
+#else
+        unsigned int eax, ebx, ecx, edx;
+
+        if (__get_cpuid_max(0, NULL) >= 7) {
+            __cpuid(1, eax, ebx, ecx1, edx);
+            __cpuid_count(7, 0, eax, ebx7, ecx, edx);
+#endif
+            supported = (ecx1 & (1U << 9)) != 0 &&      /* SSSE3 */
+                        (ecx1 & (1U << 19)) != 0 &&     /* SSE4.1 */
+                        (ebx7 & (1U << 29)) != 0;       /* SHA */
+        }
+        done = 1;
+    }
+
+    return supported;
+}
+#endif /* MBEDTLS_CPU_HAVE_SHA_NI_DETECTION */
@@ -0,0 +1,71 @@
+/**
+ * \file cpu_features.h
+ *
+ * \brief Runtime detection of x86 instruction set extensions
+ *
+ * \warning These functions are only for internal use by other library
+ *          functions; you must not call them directly.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_CPU_FEATURES_H
+#define MBEDTLS_CPU_FEATURES_H
+
+#include "mbedtls/build_info.h"
+
+/* Can we detect AVX2 at runtime? The AVX2 kernels are compiled with a
+ * target pragma, which needs GCC 4.9 or Clang 5, and reading XCR0 needs
+ * inline assembly. */
+#if defined(MBEDTLS_ARCH_IS_X64) && defined(MBEDTLS_HAVE_ASM) && \
+    ((defined(MBEDTLS_COMPILER_IS_GCC) && MBEDTLS_GCC_VERSION >= 40900) || \
+    (defined(__clang__) && (__clang_major__ >= 5)))
+#define MBEDTLS_CPU_HAVE_AVX2_DETECTION
+#endif
+
+/* Can we detect the SHA extensions at runtime? The SHA-NI kernels are
+ * compiled with a target pragma, or with plain intrinsics with MSVC. */
+#if (defined(MBEDTLS_ARCH_IS_X64) || defined(MBEDTLS_ARCH_IS_X86)) && \
+    ((defined(_MSC_VER) && !defined(__clang__)) || \
+    (defined(MBEDTLS_COMPILER_IS_GCC) && MBEDTLS_GCC_VERSION >= 40900) || \
+    (defined(__clang__) && (__clang_major__ >= 5)))
+#define MBEDTLS_CPU_HAVE_SHA_NI_DETECTION
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(MBEDTLS_CPU_HAVE_AVX2_DETECTION)
+/**
+ * \brief          Internal function to detect AVX2 support.
+ *
+ * \note           This function is only for internal use by other library
+ *                 functions; you must not call it directly.
+ *
+ * \return         1 if the CPU supports AVX2 and the OS saves the YMM
+ *                 registers on context switches, 0 otherwise
+ */
+int mbedtls_cpu_has_avx2(void);
+#endif /* MBEDTLS_CPU_HAVE_AVX2_DETECTION */
+
+#if defined(MBEDTLS_CPU_HAVE_SHA_NI_DETECTION)
+/**
+ * \brief          Internal function to detect the SHA extensions.
+ *
+ * \note           This function is only for internal use by other library
+ *                 functions; you must not call it directly.
+ *
+ * \return         1 if the CPU supports the SHA extensions, and the SSSE3
+ *                 and SSE4.1 instructions the SHA-NI kernels also use,
+ *                 0 otherwise
+ */
+int mbedtls_cpu_has_sha_ni(void);
+#endif /* MBEDTLS_CPU_HAVE_SHA_NI_DETECTION */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_CPU_FEATURES_H */
@@ -179,10 +179,18 @@ static void ecp_restart_rsm_free(mbedtls_ecp_restart_mul_ctx *ctx)
 struct mbedtls_ecp_restart_muladd {
     mbedtls_ecp_point mP;       /* mP value                             */
     mbedtls_ecp_point R;        /* R intermediate result                */
+    mbedtls_ecp_point *T;       /* odd multiples of P, then of Q        */
+    unsigned char T_size;       /* number of points in table T          */
+    signed char *naf;           /* wNAF digits of m, then of n          */
+    size_t i;                   /* number of digits left to process     */
     enum {                      /* what should we do next?              */
         ecp_rsma_mul1 = 0,      /* first multiplication                 */
         ecp_rsma_mul2,          /* second multiplication                */
         ecp_rsma_add,           /* addition                             */
+        ecp_rsma_wnaf_pre_dbl,  /* wNAF: compute 2P and 2Q              */
+        ecp_rsma_wnaf_pre_add,  /* wNAF: compute the odd multiples      */
+        ecp_rsma_wnaf_pre_norm, /* wNAF: normalize the odd multiples    */
+        ecp_rsma_wnaf_core,     /* wNAF: doublings and additions        */
         ecp_rsma_norm,          /* normalization                        */
     } state;
 };
@@ -194,6 +202,10 @@ static void ecp_restart_ma_init(mbedtls_ecp_restart_muladd_ctx *ctx)
 {
     mbedtls_ecp_point_init(&ctx->mP);
     mbedtls_ecp_point_init(&ctx->R);
+    ctx->T = NULL;
+    ctx->T_size = 0;
+    ctx->naf = NULL;
+    ctx->i = 0;
     ctx->state = ecp_rsma_mul1;
 }
 
@@ -202,6 +214,8 @@ static void ecp_restart_ma_init(mbedtls_ecp_restart_muladd_ctx *ctx)
  */
 static void ecp_restart_ma_free(mbedtls_ecp_restart_muladd_ctx *ctx)
 {
+    unsigned char i;
+
     if (ctx == NULL) {
         return;
     }
@@ -209,6 +223,14 @@ static void ecp_restart_ma_free(mbedtls_ecp_restart_muladd_ctx *ctx)
     mbedtls_ecp_point_free(&ctx->mP);
     mbedtls_ecp_point_free(&ctx->R);
 
+    if (ctx->T != NULL) {
+        for (i = 0; i < ctx->T_size; i++) {
+            mbedtls_ecp_point_free(ctx->T + i);
+        }
+        mbedtls_free(ctx->T);
+    }
+    mbedtls_free(ctx->naf);
+
     ecp_restart_ma_init(ctx);
 }
 
@@ -566,6 +588,402 @@ static int ecp_group_is_static_comb_table(const mbedtls_ecp_group *grp)
 #endif
 }
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+/*
+ * Process-wide comb tables for the generators of the built-in curves,
+ * indexed by group id. A table stays once computed, until
+ * mbedtls_ecp_group_cache_flush() finds that no operation uses it. Groups
+ * never point to these tables: each multiplication takes a reference for its
+ * own duration, so that it leaves grp untouched, as it does without the
+ * cache, and a group can still be shared between threads.
+ */
+typedef struct {
+    mbedtls_ecp_point *T;   /* the table, or NULL                       */
+    size_t T_size;          /* number of points in T                    */
+    size_t refs;            /* number of operations using this table    */
+} ecp_group_cache_entry;
+
+static ecp_group_cache_entry ecp_group_cache[MBEDTLS_ECP_DP_MAX];
+
+static int ecp_group_cache_lock(void)
+{
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_lock(&mbedtls_threading_ecp_group_cache_mutex) != 0) {
+        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+    return 0;
+}
+
+static void ecp_group_cache_unlock(void)
+{
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock(&mbedtls_threading_ecp_group_cache_mutex);
+#endif
+}
+
+#if defined(MBEDTLS_ECP_SHORT_WEIERSTRASS_ENABLED)
+static ecp_group_cache_entry *ecp_group_cache_entry_of(const mbedtls_ecp_group *grp)
+{
+    if (grp->id <= MBEDTLS_ECP_DP_NONE || (int) grp->id >= MBEDTLS_ECP_DP_MAX) {
+        return NULL;
+    }
+
+    return &ecp_group_cache[grp->id];
+}
+
+/*
+ * Take a reference to the cached table of the curve of grp, if there is one
+ * with T_size points, and point *T to it. Return 0 on success.
+ */
+static int ecp_group_cache_get(const mbedtls_ecp_group *grp, size_t T_size,
+                               mbedtls_ecp_point **T)
+{
+    ecp_group_cache_entry *entry = ecp_group_cache_entry_of(grp);
+    int ret = -1;
+
+    if (entry == NULL || ecp_group_cache_lock() != 0) {
+        return -1;
+    }
+
+    if (entry->T != NULL && entry->T_size == T_size) {
+        entry->refs++;
+        *T = entry->T;
+        ret = 0;
+    }
+
+    ecp_group_cache_unlock();
+
+    return ret;
+}
+
+/*
+ * Give the table *T that was just computed for grp to the cache, or drop it
+ * if another operation got there first and point *T to the cached table,
+ * and take a reference to it. Return non-zero if the cache can't take the
+ * table: the caller then keeps *T.
+ */
+static int ecp_group_cache_publish(const mbedtls_ecp_group *grp,
+                                   mbedtls_ecp_point **T, size_t T_size)
+{
+    ecp_group_cache_entry *entry = ecp_group_cache_entry_of(grp);
+    mbedtls_ecp_point *cached = NULL;
+    size_t i;
+
+    if (entry == NULL || ecp_group_cache_lock() != 0) {
+        return -1;
+    }
+
+    if (entry->T == NULL) {
+        entry->T = *T;
+        entry->T_size = T_size;
+    }
+    if (entry->T_size == T_size) {
+        entry->refs++;
+        cached = entry->T;
+    }
+
+    ecp_group_cache_unlock();
+
+    if (cached == NULL) {
+        return -1;
+    }
+
+    if (cached != *T) {
+        for (i = 0; i < T_size; i++) {
+            mbedtls_ecp_point_free(&(*T)[i]);
+        }
+        mbedtls_free(*T);
+        *T = cached;
+    }
+
+    return 0;
+}
+
+/*
+ * Drop a reference returned by ecp_group_cache_get() or
+ * ecp_group_cache_publish()
+ */
+static void ecp_group_cache_put(const mbedtls_ecp_group *grp,
+                                const mbedtls_ecp_point *T)
+{
+    ecp_group_cache_entry *entry = ecp_group_cache_entry_of(grp);
+
+    if (ecp_group_cache_lock() != 0) {
+        /* Leaking the reference only keeps the table cached. */
+        return;
+    }
+
+    if (entry->T == T) {
+        entry->refs--;
+    }
+
+    ecp_group_cache_unlock();
+}
+#endif /* MBEDTLS_ECP_SHORT_WEIERSTRASS_ENABLED */
+
+#if defined(MBEDTLS_TEST_HOOKS)
+const mbedtls_ecp_point *mbedtls_ecp_group_cache_table(mbedtls_ecp_group_id id)
+{
+    const mbedtls_ecp_point *T = NULL;
+
+    if (id <= MBEDTLS_ECP_DP_NONE || (int) id >= MBEDTLS_ECP_DP_MAX ||
+        ecp_group_cache_lock() != 0) {
+        return NULL;
+    }
+
+    T = ecp_group_cache[id].T;
+
+    ecp_group_cache_unlock();
+
+    return T;
+}
+#endif /* MBEDTLS_TEST_HOOKS */
+
+/*
+ * Free the cached tables that no operation uses
+ */
+void mbedtls_ecp_group_cache_flush(void)
+{
+    ecp_group_cache_entry *entry;
+    size_t i, j;
+
+    if (ecp_group_cache_lock() != 0) {
+        return;
+    }
+
+    for (i = 0; i < MBEDTLS_ECP_DP_MAX; i++) {
+        entry = &ecp_group_cache[i];
+        if (entry->T == NULL || entry->refs != 0) {
+            continue;
+        }
+
+        for (j = 0; j < entry->T_size; j++) {
+            mbedtls_ecp_point_free(&entry->T[j]);
+        }
+        mbedtls_free(entry->T);
+        entry->T = NULL;
+        entry->T_size = 0;
+    }
+
+    ecp_group_cache_unlock();
+}
+#endif /* MBEDTLS_ECP_GROUP_CACHE */
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+/*
+ * Process-wide cache of comb tables for the public keys passed to
+ * mbedtls_ecp_muladd(), most recently used first. A key gets an entry the
+ * first time it is seen, and a table the second time, so that keys which are
+ * only used once cost no precomputation. Each entry counts the slot of the
+ * cache that holds it and the operations that use its table.
+ */
+typedef struct {
+    mbedtls_ecp_group_id id;    /* curve of Q                           */
+    mbedtls_ecp_point Q;        /* the public key                       */
+    mbedtls_ecp_point *T;       /* comb table of Q, or NULL             */
+    unsigned char T_size;       /* number of points in T                */
+    size_t refs;                /* number of references to the entry    */
+} ecp_pubkey_cache_entry;
+
+static ecp_pubkey_cache_entry *ecp_pubkey_cache[MBEDTLS_ECP_PUBKEY_CACHE_SIZE];
+
+static int ecp_pubkey_cache_lock(void)
+{
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_lock(&mbedtls_threading_ecp_pubkey_cache_mutex) != 0) {
+        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+    return 0;
+}
+
+static void ecp_pubkey_cache_unlock(void)
+{
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock(&mbedtls_threading_ecp_pubkey_cache_mutex);
+#endif
+}
+
+/*
+ * Drop a reference to entry, and free it if it was the last one.
+ * Must be called with the lock held.
+ */
+static void ecp_pubkey_cache_entry_put(ecp_pubkey_cache_entry *entry)
+{
+    unsigned char i;
+
+    if (--entry->refs != 0) {
+        return;
+    }
+
+    mbedtls_ecp_point_free(&entry->Q);
+    if (entry->T != NULL) {
+        for (i = 0; i < entry->T_size; i++) {
+            mbedtls_ecp_point_free(&entry->T[i]);
+        }
+        mbedtls_free(entry->T);
+    }
+    mbedtls_free(entry);
+}
+
+#if defined(MBEDTLS_ECP_SHORT_WEIERSTRASS_ENABLED)
+/*
+ * Look Q up and make it the most recently used key, adding it in place of
+ * the least recently used one if it is new. Return a reference to its entry
+ * if that has a table of T_size points, or NULL, with *hot set if Q was
+ * already in the cache.
+ */
+static ecp_pubkey_cache_entry *ecp_pubkey_cache_get(const mbedtls_ecp_group *grp,
+                                                    const mbedtls_ecp_point *Q,
+                                                    unsigned char T_size,
+                                                    int *hot)
+{
+    ecp_pubkey_cache_entry *entry = NULL, *ret = NULL;
+    size_t i;
+
+    *hot = 0;
+
+    if (ecp_pubkey_cache_lock() != 0) {
+        return NULL;
+    }
+
+    for (i = 0; i < MBEDTLS_ECP_PUBKEY_CACHE_SIZE - 1; i++) {
+        entry = ecp_pubkey_cache[i];
+        if (entry == NULL ||
+            (entry->id == grp->id && mbedtls_ecp_point_cmp(&entry->Q, Q) == 0)) {
+            break;
+        }
+    }
+    entry = ecp_pubkey_cache[i];
+
+    if (entry != NULL &&
+        entry->id == grp->id && mbedtls_ecp_point_cmp(&entry->Q, Q) == 0) {
+        *hot = 1;
+        if (entry->T != NULL && entry->T_size == T_size) {
+            entry->refs++;
+            ret = entry;
+        }
+    } else {
+        /* Not found: i is a free slot or the least recently used key */
+        if (entry != NULL) {
+            ecp_pubkey_cache_entry_put(entry);
+            ecp_pubkey_cache[i] = NULL;
+        }
+
+        entry = mbedtls_calloc(1, sizeof(ecp_pubkey_cache_entry));
+        if (entry == NULL) {
+            goto cleanup;
+        }
+        entry->id = grp->id;
+        entry->refs = 1;
+        mbedtls_ecp_point_init(&entry->Q);
+        if (mbedtls_ecp_copy(&entry->Q, Q) != 0) {
+            ecp_pubkey_cache_entry_put(entry);
+            goto cleanup;
+        }
+    }
+
+    /* Move the entry to the front */
+    for (; i > 0; i--) {
+        ecp_pubkey_cache[i] = ecp_pubkey_cache[i - 1];
+    }
+    ecp_pubkey_cache[0] = entry;
+
+cleanup:
+    ecp_pubkey_cache_unlock();
+
+    return ret;
+}
+
+/*
+ * Give the table T that was just computed for Q to its entry, or drop it if
+ * another thread got there first, and return a reference to the entry.
+ * Return NULL if Q was evicted meanwhile: the caller then keeps T.
+ */
+static ecp_pubkey_cache_entry *ecp_pubkey_cache_publish(const mbedtls_ecp_group *grp,
+                                                        const mbedtls_ecp_point *Q,
+                                                        mbedtls_ecp_point *T,
+                                                        unsigned char T_size)
+{
+    ecp_pubkey_cache_entry *entry, *ret = NULL;
+    size_t i;
+
+    if (ecp_pubkey_cache_lock() != 0) {
+        return NULL;
+    }
+
+    for (i = 0; i < MBEDTLS_ECP_PUBKEY_CACHE_SIZE; i++) {
+        entry = ecp_pubkey_cache[i];
+        if (entry == NULL) {
+            break;
+        }
+        if (entry->id != grp->id || mbedtls_ecp_point_cmp(&entry->Q, Q) != 0) {
+            continue;
+        }
+
+        if (entry->T == NULL) {
+            entry->T = T;
+            entry->T_size = T_size;
+        }
+        if (entry->T_size == T_size) {
+            entry->refs++;
+            ret = entry;
+        }
+        break;
+    }
+
+    ecp_pubkey_cache_unlock();
+
+    if (ret != NULL && ret->T != T) {
+        for (i = 0; i < T_size; i++) {
+            mbedtls_ecp_point_free(&T[i]);
+        }
+        mbedtls_free(T);
+    }
+
+    return ret;
+}
+
+/*
+ * Drop a reference returned by ecp_pubkey_cache_get() or
+ * ecp_pubkey_cache_publish()
+ */
+static void ecp_pubkey_cache_release(ecp_pubkey_cache_entry *entry)
+{
+    if (ecp_pubkey_cache_lock() != 0) {
+        /* Leaking the reference only keeps the entry allocated. */
+        return;
+    }
+
+    ecp_pubkey_cache_entry_put(entry);
+
+    ecp_pubkey_cache_unlock();
+}
+#endif /* MBEDTLS_ECP_SHORT_WEIERSTRASS_ENABLED */
+
+/*
+ * Evict all keys; tables in use are freed by their last user
+ */
+void mbedtls_ecp_pubkey_cache_flush(void)
+{
+    size_t i;
+
+    if (ecp_pubkey_cache_lock() != 0) {
+        return;
+    }
+
+    for (i = 0; i < MBEDTLS_ECP_PUBKEY_CACHE_SIZE; i++) {
+        if (ecp_pubkey_cache[i] != NULL) {
+            ecp_pubkey_cache_entry_put(ecp_pubkey_cache[i]);
+            ecp_pubkey_cache[i] = NULL;
+        }
+    }
+
+    ecp_pubkey_cache_unlock();
+}
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE */
+
 /*
  * Unallocate (the components of) a group
  */
@@ -2283,6 +2701,9 @@ static int ecp_mul_comb(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     size_t d;
     unsigned char T_size = 0, T_ok = 0;
     mbedtls_ecp_point *T = NULL;
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    unsigned char use_cache, T_cached = 0;
+#endif
 
     ECP_RS_ENTER(rsm);
 
@@ -2290,10 +2711,30 @@ static int ecp_mul_comb(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
 #if MBEDTLS_ECP_FIXED_POINT_OPTIM == 1
     p_eq_g = (MPI_ECP_CMP(&P->Y, &grp->G.Y) == 0 &&
               MPI_ECP_CMP(&P->X, &grp->G.X) == 0);
+#elif defined(MBEDTLS_ECP_GROUP_CACHE)
+    /* Without static tables, only keep the tables that can be shared */
+    p_eq_g = (grp->id != MBEDTLS_ECP_DP_NONE &&
+              MPI_ECP_CMP(&P->Y, &grp->G.Y) == 0 &&
+              MPI_ECP_CMP(&P->X, &grp->G.X) == 0);
 #else
     p_eq_g = 0;
 #endif
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    /* A cached table is only referenced for the duration of one call, so
+     * restartable operations don't use it */
+    use_cache = p_eq_g && grp->T == NULL;
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    if (rs_ctx != NULL && rs_ctx->rsm != NULL) {
+        use_cache = 0;
+    }
+#endif
+#if MBEDTLS_ECP_FIXED_POINT_OPTIM == 0
+    /* and without static tables, the group never keeps one */
+    p_eq_g = use_cache;
+#endif
+#endif
+
     /* Pick window size and deduce related sizes */
     w = ecp_pick_window_size(grp, p_eq_g);
     T_size = 1U << (w - 1);
@@ -2316,6 +2757,13 @@ static int ecp_mul_comb(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
         /* This effectively jumps to the call to mul_comb_after_precomp() */
         T_ok = rs_ctx->rsm->state >= ecp_rsm_comb_core;
     } else
+#endif
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    /* Pre-computed table: has another group of the same curve computed it? */
+    if (use_cache && ecp_group_cache_get(grp, T_size, &T) == 0) {
+        T_cached = 1;
+        T_ok = 1;
+    } else
 #endif
     /* Allocate table if we didn't have any */
     {
@@ -2336,6 +2784,12 @@ static int ecp_mul_comb(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     if (!T_ok) {
         MBEDTLS_MPI_CHK(ecp_precompute_comb(grp, T, P, w, d, rs_ctx));
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+        if (use_cache) {
+            /* share T with the other groups of the same curve */
+            T_cached = ecp_group_cache_publish(grp, &T, T_size) == 0;
+        } else
+#endif
         if (p_eq_g) {
             /* almost transfer ownership of T to the group, but keep a copy of
              * the pointer to use for calling the next function more easily */
@@ -2351,6 +2805,14 @@ static int ecp_mul_comb(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
 
 cleanup:
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    /* does T belong to the cache? */
+    if (T_cached) {
+        ecp_group_cache_put(grp, T);
+        T = NULL;
+    }
+#endif
+
     /* does T belong to the group? */
     if (T == grp->T) {
         T = NULL;
@@ -2767,6 +3229,525 @@ cleanup:
     return ret;
 }
 
+/*
+ * Width of the signed windows used by ecp_muladd_wnaf(): each of its two
+ * tables then holds 2^(w-2) points, like a comb table with a window of w - 1.
+ */
+static unsigned char ecp_wnaf_window_size(const mbedtls_ecp_group *grp)
+{
+    unsigned char w = grp->nbits >= 384 ? 6 : 5;
+
+    if (w > MBEDTLS_ECP_WINDOW_SIZE + 1) {
+        w = MBEDTLS_ECP_WINDOW_SIZE + 1;
+    }
+    if (w >= grp->nbits) {
+        w = 2;
+    }
+
+    return w;
+}
+
+/*
+ * Width-w non-adjacent form of 0 < k < 2^len: k = sum_i naf[i] * 2^i, where
+ * every non-zero digit is odd with |naf[i]| < 2^(w-1) and is followed by at
+ * least w - 1 zero digits.
+ * NOT constant-time - ONLY for public scalars!
+ */
+static int ecp_wnaf_recode(signed char naf[], size_t len,
+                           const mbedtls_mpi *k, unsigned char w)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_mpi r;
+    size_t i, j;
+    int d;
+
+    mbedtls_mpi_init(&r);
+    memset(naf, 0, len);
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&r, k));
+
+    for (i = 0; mbedtls_mpi_cmp_int(&r, 0) != 0; i++) {
+        if (i == len) {
+            ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+            goto cleanup;
+        }
+
+        if (mbedtls_mpi_get_bit(&r, 0) == 1) {
+            /* d = r mod 2^w, as a signed residue */
+            for (d = 0, j = 0; j < w; j++) {
+                d |= mbedtls_mpi_get_bit(&r, j) << j;
+            }
+            if (d >= 1 << (w - 1)) {
+                d -= 1 << w;
+            }
+
+            MBEDTLS_MPI_CHK(mbedtls_mpi_sub_int(&r, &r, d));
+            naf[i] = (signed char) d;
+        }
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_shift_r(&r, 1));
+    }
+
+cleanup:
+    mbedtls_mpi_free(&r);
+
+    return ret;
+}
+
+/*
+ * R = R + d * T[(|d| - 1) / 2] for an odd digit d, where T holds the points
+ * for the digits 1, 3, 5... in affine coordinates: the odd multiples of a
+ * point for wNAF, or the comb values S[1], S[3]... for the comb method.
+ * S is a scratch point for the table entry, as static comb tables leave Z
+ * unset (see ecp_select_comb()).
+ */
+static int ecp_add_wnaf_digit(const mbedtls_ecp_group *grp,
+                              mbedtls_ecp_point *R,
+                              const mbedtls_ecp_point T[], int d,
+                              mbedtls_ecp_point *S, mbedtls_mpi tmp[4])
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const mbedtls_ecp_point *Td = &T[((d > 0 ? d : -d) - 1) / 2];
+
+    MPI_ECP_MOV(&S->X, &Td->X);
+    MPI_ECP_MOV(&S->Y, &Td->Y);
+    MPI_ECP_LSET(&S->Z, 1);
+    if (d < 0 && MPI_ECP_CMP_INT(&S->Y, 0) != 0) {
+        MPI_ECP_SUB(&S->Y, &grp->P, &S->Y);
+    }
+    MBEDTLS_MPI_CHK(ecp_add_mixed(grp, R, R, S, tmp));
+
+cleanup:
+    return ret;
+}
+
+/*
+ * Interleaved wNAF linear combination: R = m * P + n * Q, where both scalars
+ * are recoded in width-w NAF and share a single chain of doublings. This costs
+ * about nbits doublings plus nbits / (w + 1) additions per scalar, instead of
+ * two full multiplications.
+ *
+ * Tables: T[0..h-1] = P, 3P, ..., T[h..2h-1] = Q, 3Q, ..., with h = 2^(w-2),
+ * followed by 2P and 2Q which are only used to build them.
+ *
+ * Requires 0 < m, n < N and valid points P and Q. R may alias P or Q, and is
+ * left in Jacobian coordinates.
+ * NOT constant-time - ONLY for public scalars!
+ */
+static int ecp_muladd_wnaf(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                           const mbedtls_mpi *m, const mbedtls_ecp_point *P,
+                           const mbedtls_mpi *n, const mbedtls_ecp_point *Q,
+                           mbedtls_ecp_restart_ctx *rs_ctx)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const unsigned char w = ecp_wnaf_window_size(grp);
+    const unsigned char h = 1U << (w - 2);
+    const unsigned char T_size = 2 * h + 2;
+    const size_t len = grp->nbits + 1;
+    mbedtls_ecp_point *T = NULL;
+    mbedtls_ecp_point *TT[1U << MBEDTLS_ECP_WINDOW_SIZE];
+    signed char *naf = NULL;
+    mbedtls_ecp_point S;
+    mbedtls_mpi tmp[4];
+    size_t i = 0, j;
+
+    mbedtls_ecp_point_init(&S);
+    mpi_init_many(tmp, sizeof(tmp) / sizeof(mbedtls_mpi));
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    if (rs_ctx != NULL && rs_ctx->ma != NULL && rs_ctx->ma->T != NULL) {
+        /* transfer ownership of T and naf from rs_ctx to local */
+        T = rs_ctx->ma->T;
+        naf = rs_ctx->ma->naf;
+        i = rs_ctx->ma->i;
+        rs_ctx->ma->T = NULL;
+        rs_ctx->ma->T_size = 0;
+        rs_ctx->ma->naf = NULL;
+
+        /* jump to next operation */
+        if (rs_ctx->ma->state == ecp_rsma_wnaf_pre_add) {
+            goto pre_add;
+        }
+        if (rs_ctx->ma->state == ecp_rsma_wnaf_pre_norm) {
+            goto pre_norm;
+        }
+        if (rs_ctx->ma->state == ecp_rsma_wnaf_core) {
+            goto core;
+        }
+    }
+#else
+    (void) rs_ctx;
+#endif
+
+    /* Nothing is allocated until this first budget check has passed */
+    MBEDTLS_ECP_BUDGET(2 * MBEDTLS_ECP_OPS_DBL + MBEDTLS_ECP_OPS_INV);
+
+    T = mbedtls_calloc(T_size, sizeof(mbedtls_ecp_point));
+    naf = mbedtls_calloc(2, len);
+    if (T == NULL || naf == NULL) {
+        ret = MBEDTLS_ERR_ECP_ALLOC_FAILED;
+        goto cleanup;
+    }
+    for (j = 0; j < T_size; j++) {
+        mbedtls_ecp_point_init(&T[j]);
+    }
+
+    MBEDTLS_MPI_CHK(ecp_wnaf_recode(naf, len, m, w));
+    MBEDTLS_MPI_CHK(ecp_wnaf_recode(naf + len, len, n, w));
+
+    /* Skip the leading zero digits of both scalars */
+    for (i = len; i > 0 && naf[i - 1] == 0 && naf[len + i - 1] == 0; i--) {
+        ;
+    }
+
+    MBEDTLS_MPI_CHK(mbedtls_ecp_copy(&T[0], P));
+    MBEDTLS_MPI_CHK(mbedtls_ecp_copy(&T[h], Q));
+
+    if (h > 1) {
+        MBEDTLS_MPI_CHK(ecp_double_jac(grp, &T[2 * h], &T[0], tmp));
+        MBEDTLS_MPI_CHK(ecp_double_jac(grp, &T[2 * h + 1], &T[h], tmp));
+        TT[0] = &T[2 * h];
+        TT[1] = &T[2 * h + 1];
+        MBEDTLS_MPI_CHK(ecp_normalize_jac_many(grp, TT, 2));
+    }
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    if (rs_ctx != NULL && rs_ctx->ma != NULL) {
+        rs_ctx->ma->state = ecp_rsma_wnaf_pre_add;
+    }
+
+pre_add:
+#endif
+    MBEDTLS_ECP_BUDGET((T_size - 4) * MBEDTLS_ECP_OPS_ADD);
+
+    for (j = 1; j < h; j++) {
+        MBEDTLS_MPI_CHK(ecp_add_mixed(grp, &T[j], &T[j - 1], &T[2 * h], tmp));
+        MBEDTLS_MPI_CHK(ecp_add_mixed(grp, &T[h + j], &T[h + j - 1], &T[2 * h + 1], tmp));
+    }
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    if (rs_ctx != NULL && rs_ctx->ma != NULL) {
+        rs_ctx->ma->state = ecp_rsma_wnaf_pre_norm;
+    }
+
+pre_norm:
+#endif
+    MBEDTLS_ECP_BUDGET(MBEDTLS_ECP_OPS_INV);
+
+    if (h > 1) {
+        for (j = 1; j < h; j++) {
+            TT[2 * j - 2] = &T[j];
+            TT[2 * j - 1] = &T[h + j];
+        }
+        MBEDTLS_MPI_CHK(ecp_normalize_jac_many(grp, TT, 2 * h - 2));
+    }
+
+    /* P and Q are no longer needed, R may overwrite them from here on */
+    MBEDTLS_MPI_CHK(mbedtls_ecp_set_zero(R));
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    if (rs_ctx != NULL && rs_ctx->ma != NULL) {
+        rs_ctx->ma->state = ecp_rsma_wnaf_core;
+    }
+
+core:
+#endif
+    while (i > 0) {
+        MBEDTLS_ECP_BUDGET(MBEDTLS_ECP_OPS_DBL +
+                           ((naf[i - 1] != 0) + (naf[len + i - 1] != 0)) *
+                           MBEDTLS_ECP_OPS_ADD);
+        i--;
+
+        if (mbedtls_ecp_is_zero(R) == 0) {
+            MBEDTLS_MPI_CHK(ecp_double_jac(grp, R, R, tmp));
+        }
+        if (naf[i] != 0) {
+            MBEDTLS_MPI_CHK(ecp_add_wnaf_digit(grp, R, T, naf[i], &S, tmp));
+        }
+        if (naf[len + i] != 0) {
+            MBEDTLS_MPI_CHK(ecp_add_wnaf_digit(grp, R, T + h, naf[len + i], &S, tmp));
+        }
+    }
+
+cleanup:
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    if (rs_ctx != NULL && rs_ctx->ma != NULL &&
+        ret == MBEDTLS_ERR_ECP_IN_PROGRESS && T != NULL) {
+        /* transfer ownership of T and naf from local to rs_ctx */
+        rs_ctx->ma->T = T;
+        rs_ctx->ma->T_size = T_size;
+        rs_ctx->ma->naf = naf;
+        rs_ctx->ma->i = i;
+        T = NULL;
+        naf = NULL;
+    }
+#endif
+
+    if (T != NULL) {
+        for (j = 0; j < T_size; j++) {
+            mbedtls_ecp_point_free(&T[j]);
+        }
+        mbedtls_free(T);
+    }
+    mbedtls_free(naf);
+
+    mbedtls_ecp_point_free(&S);
+    mpi_free_many(tmp, sizeof(tmp) / sizeof(mbedtls_mpi));
+
+    return ret;
+}
+
+/*
+ * Whether R = m * P is computed by mbedtls_ecp_mul_shortcuts() without any
+ * multiplication.
+ */
+static int ecp_mul_is_shortcut(const mbedtls_mpi *m)
+{
+    return mbedtls_mpi_cmp_int(m, 0) == 0 ||
+           mbedtls_mpi_cmp_int(m, 1) == 0 ||
+           mbedtls_mpi_cmp_int(m, -1) == 0;
+}
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+/*
+ * Window size for the comb tables of cached public keys: one more than for
+ * a single multiplication, since they are reused, up to the maximum.
+ */
+static unsigned char ecp_pubkey_cache_window_size(const mbedtls_ecp_group *grp)
+{
+    unsigned char w = ecp_pick_window_size(grp, 0) + 1;
+
+    if (w > MBEDTLS_ECP_WINDOW_SIZE) {
+        w = MBEDTLS_ECP_WINDOW_SIZE;
+    }
+    if (w >= grp->nbits) {
+        w = 2;
+    }
+
+    return w;
+}
+
+/*
+ * Get the comb table of the generator, as ecp_mul_comb() would use it: the
+ * table of grp, or with MBEDTLS_ECP_GROUP_CACHE a reference to the cached
+ * one, which *cached is set for. Compute it if this build keeps such tables.
+ */
+static int ecp_muladd_get_g_table(mbedtls_ecp_group *grp, unsigned char w,
+                                  const mbedtls_ecp_point **TG, int *cached)
+{
+#if MBEDTLS_ECP_FIXED_POINT_OPTIM == 1 || defined(MBEDTLS_ECP_GROUP_CACHE)
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const unsigned char T_size = 1U << (w - 1);
+    mbedtls_ecp_point *T;
+    unsigned char i;
+
+    *cached = 0;
+
+    if (grp->T != NULL) {
+        *TG = grp->T;
+        return 0;
+    }
+
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    if (ecp_group_cache_get(grp, T_size, &T) == 0) {
+        *TG = T;
+        *cached = 1;
+        return 0;
+    }
+#endif
+
+    T = mbedtls_calloc(T_size, sizeof(mbedtls_ecp_point));
+    if (T == NULL) {
+        return MBEDTLS_ERR_ECP_ALLOC_FAILED;
+    }
+    for (i = 0; i < T_size; i++) {
+        mbedtls_ecp_point_init(&T[i]);
+    }
+
+    ret = ecp_precompute_comb(grp, T, &grp->G, w,
+                              (grp->nbits + w - 1) / w, NULL);
+
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    if (ret == 0 && ecp_group_cache_publish(grp, &T, T_size) == 0) {
+        *TG = T;
+        *cached = 1;
+        return 0;
+    }
+    /* The group doesn't keep the table: let the caller use
+     * ecp_muladd_wnaf() rather than compute it for one operation */
+    if (ret == 0) {
+        ret = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+    }
+#else
+    if (ret == 0) {
+        grp->T = T;
+        grp->T_size = T_size;
+        *TG = T;
+        return 0;
+    }
+#endif
+
+    for (i = 0; i < T_size; i++) {
+        mbedtls_ecp_point_free(&T[i]);
+    }
+    mbedtls_free(T);
+
+    return ret;
+#else
+    (void) grp;
+    (void) w;
+    (void) TG;
+    (void) cached;
+    return MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+#endif
+}
+
+/*
+ * Signed value of a digit from ecp_comb_recode_scalar(), negated if neg
+ */
+static int ecp_comb_digit(unsigned char x, unsigned char neg)
+{
+    return ((x >> 7) ^ neg) ? -(int) (x & 0x7F) : (int) (x & 0x7F);
+}
+
+/*
+ * Linear combination with a cached public key: R = m * G + n * Q (or
+ * m * P + n * G), with comb tables for both G and Q. The recoded scalars
+ * share the d = nbits / w doublings of the comb method, instead of the
+ * nbits doublings of ecp_muladd_wnaf().
+ *
+ * Return MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE, leaving R untouched, if grp is
+ * not a built-in curve, if neither point is G, if restarting is enabled, if
+ * this build keeps no table for G, or if Q has no table yet: the caller then
+ * uses ecp_muladd_wnaf(). Requires valid scalars and points; R may alias
+ * P or Q, and is left in Jacobian coordinates.
+ * NOT constant-time - ONLY for public scalars!
+ */
+static int ecp_muladd_cached(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                             const mbedtls_mpi *m, const mbedtls_ecp_point *P,
+                             const mbedtls_mpi *n, const mbedtls_ecp_point *Q,
+                             mbedtls_ecp_restart_ctx *rs_ctx)
+{
+    int ret = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+    const unsigned char wG = ecp_pick_window_size(grp, 1);
+    const unsigned char wQ = ecp_pubkey_cache_window_size(grp);
+    const unsigned char T_size = 1U << (wQ - 1);
+    const size_t dG = (grp->nbits + wG - 1) / wG;
+    const size_t dQ = (grp->nbits + wQ - 1) / wQ;
+    ecp_pubkey_cache_entry *entry = NULL;
+    mbedtls_ecp_point *T = NULL;
+    const mbedtls_ecp_point *TG = NULL, *TQ;
+    const mbedtls_mpi *k;
+    unsigned char kG[COMB_MAX_D + 1], kQ[COMB_MAX_D + 1];
+    unsigned char negG, negQ;
+    mbedtls_ecp_point S;
+    mbedtls_mpi tmp[4];
+    size_t i;
+    int hot, TG_cached = 0;
+
+    mbedtls_ecp_point_init(&S);
+    mpi_init_many(tmp, sizeof(tmp) / sizeof(mbedtls_mpi));
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    if (rs_ctx != NULL && rs_ctx->ma != NULL) {
+        goto cleanup;
+    }
+#else
+    (void) rs_ctx;
+#endif
+
+    /* Keys are cached by curve id, which custom groups don't have */
+    if (grp->id == MBEDTLS_ECP_DP_NONE) {
+        goto cleanup;
+    }
+
+    /* Let m go with G and n with Q */
+    if (MPI_ECP_CMP(&Q->Y, &grp->G.Y) == 0 &&
+        MPI_ECP_CMP(&Q->X, &grp->G.X) == 0) {
+        k = m;
+        m = n;
+        n = k;
+        Q = P;
+    } else if (MPI_ECP_CMP(&P->Y, &grp->G.Y) != 0 ||
+               MPI_ECP_CMP(&P->X, &grp->G.X) != 0) {
+        goto cleanup;
+    }
+
+    entry = ecp_pubkey_cache_get(grp, Q, T_size, &hot);
+    if (entry == NULL && !hot) {
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK(ecp_muladd_get_g_table(grp, wG, &TG, &TG_cached));
+
+    if (entry == NULL) {
+        /* Second use of Q: compute its table and give it to the cache */
+        T = mbedtls_calloc(T_size, sizeof(mbedtls_ecp_point));
+        if (T == NULL) {
+            ret = MBEDTLS_ERR_ECP_ALLOC_FAILED;
+            goto cleanup;
+        }
+        for (i = 0; i < T_size; i++) {
+            mbedtls_ecp_point_init(&T[i]);
+        }
+
+        MBEDTLS_MPI_CHK(ecp_precompute_comb(grp, T, Q, wQ, dQ, NULL));
+
+        entry = ecp_pubkey_cache_publish(grp, Q, T, T_size);
+        if (entry != NULL) {
+            T = NULL;
+        }
+    }
+    TQ = entry != NULL ? entry->T : T;
+
+    MBEDTLS_MPI_CHK(ecp_comb_recode_scalar(grp, m, kG, dG, wG, &negG));
+    MBEDTLS_MPI_CHK(ecp_comb_recode_scalar(grp, n, kQ, dQ, wQ, &negQ));
+
+    /* P and Q are no longer needed, R may overwrite them from here on */
+    MBEDTLS_MPI_CHK(mbedtls_ecp_set_zero(R));
+
+    i = (dG > dQ ? dG : dQ) + 1;
+    while (i-- > 0) {
+        if (mbedtls_ecp_is_zero(R) == 0) {
+            MBEDTLS_MPI_CHK(ecp_double_jac(grp, R, R, tmp));
+        }
+        if (i <= dG) {
+            MBEDTLS_MPI_CHK(ecp_add_wnaf_digit(grp, R, TG,
+                                               ecp_comb_digit(kG[i], negG), &S, tmp));
+        }
+        if (i <= dQ) {
+            MBEDTLS_MPI_CHK(ecp_add_wnaf_digit(grp, R, TQ,
+                                               ecp_comb_digit(kQ[i], negQ), &S, tmp));
+        }
+    }
+
+cleanup:
+
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    if (TG_cached) {
+        ecp_group_cache_put(grp, TG);
+    }
+#endif
+
+    if (entry != NULL) {
+        ecp_pubkey_cache_release(entry);
+    }
+
+    if (T != NULL) {
+        for (i = 0; i < T_size; i++) {
+            mbedtls_ecp_point_free(&T[i]);
+        }
+        mbedtls_free(T);
+    }
+
+    mbedtls_ecp_point_free(&S);
+    mpi_free_many(tmp, sizeof(tmp) / sizeof(mbedtls_mpi));
+
+    return ret;
+}
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE */
+
 /*
  * Restartable linear combination
  * NOT constant-time
@@ -2801,6 +3782,10 @@ int mbedtls_ecp_muladd_restartable(
         pR  = &rs_ctx->ma->R;
 
         /* jump to next operation */
+        if (rs_ctx->ma->state >= ecp_rsma_wnaf_pre_dbl &&
+            rs_ctx->ma->state <= ecp_rsma_wnaf_core) {
+            goto wnaf;
+        }
         if (rs_ctx->ma->state == ecp_rsma_mul2) {
             goto mul2;
         }
@@ -2813,6 +3798,38 @@ int mbedtls_ecp_muladd_restartable(
     }
 #endif /* MBEDTLS_ECP_RESTARTABLE */
 
+    if (!ecp_mul_is_shortcut(m) && !ecp_mul_is_shortcut(n)) {
+        MBEDTLS_ECP_BUDGET(2 * MBEDTLS_ECP_OPS_CHK);
+        MBEDTLS_MPI_CHK(mbedtls_ecp_check_privkey(grp, m));
+        MBEDTLS_MPI_CHK(mbedtls_ecp_check_pubkey(grp, P));
+        MBEDTLS_MPI_CHK(mbedtls_ecp_check_privkey(grp, n));
+        MBEDTLS_MPI_CHK(mbedtls_ecp_check_pubkey(grp, Q));
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+        if (rs_ctx != NULL && rs_ctx->ma != NULL) {
+            rs_ctx->ma->state = ecp_rsma_wnaf_pre_dbl;
+        }
+
+wnaf:
+#endif
+#if defined(MBEDTLS_ECP_INTERNAL_ALT)
+        if ((is_grp_capable = mbedtls_internal_ecp_grp_capable(grp))) {
+            MBEDTLS_MPI_CHK(mbedtls_internal_ecp_init(grp));
+        }
+#endif /* MBEDTLS_ECP_INTERNAL_ALT */
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+        ret = ecp_muladd_cached(grp, pR, m, P, n, Q, rs_ctx);
+        if (ret != MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE) {
+            MBEDTLS_MPI_CHK(ret);
+            goto normalize;
+        }
+#endif
+
+        MBEDTLS_MPI_CHK(ecp_muladd_wnaf(grp, pR, m, P, n, Q, rs_ctx));
+        goto normalize;
+    }
+
     MBEDTLS_MPI_CHK(mbedtls_ecp_mul_shortcuts(grp, pmP, m, P, rs_ctx));
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     if (rs_ctx != NULL && rs_ctx->ma != NULL) {
@@ -2838,6 +3855,8 @@ add:
 #endif
     MBEDTLS_ECP_BUDGET(MBEDTLS_ECP_OPS_ADD);
     MBEDTLS_MPI_CHK(ecp_add_mixed(grp, pR, pmP, pR, tmp));
+
+normalize:
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     if (rs_ctx != NULL && rs_ctx->ma != NULL) {
         rs_ctx->ma->state = ecp_rsma_norm;
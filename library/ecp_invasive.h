@@ -322,4 +322,16 @@ int mbedtls_ecp_modulus_setup(mbedtls_mpi_mod_modulus *N,
 
 #endif /* MBEDTLS_TEST_HOOKS && MBEDTLS_ECP_C */
 
+#if defined(MBEDTLS_TEST_HOOKS) && defined(MBEDTLS_ECP_GROUP_CACHE)
+
+/** Get the cached comb table of the generator of a curve.
+ *
+ * \param id        The group id of the curve.
+ *
+ * eturn          The table, or \c NULL if the cache has none for \p id.
+ */
+const mbedtls_ecp_point *mbedtls_ecp_group_cache_table(mbedtls_ecp_group_id id);
+
+#endif /* MBEDTLS_TEST_HOOKS && MBEDTLS_ECP_GROUP_CACHE */
+
 #endif /* MBEDTLS_ECP_INVASIVE_H */
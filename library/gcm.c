@@ -46,6 +46,15 @@
 #define MBEDTLS_GCM_ACC_LARGETABLE  1
 #define MBEDTLS_GCM_ACC_AESNI       2
 #define MBEDTLS_GCM_ACC_AESCE       3
+/* Same as AESNI/AESCE, and the block cipher is AES using the same extension,
+ * so bulk data can go through the stitched AES-CTR/GHASH kernel */
+#define MBEDTLS_GCM_ACC_AESNI_AES   4
+#define MBEDTLS_GCM_ACC_AESCE_AES   5
+
+#if (defined(MBEDTLS_AESNI_HAVE_CODE) || defined(MBEDTLS_AESCE_HAVE_CODE)) && \
+    defined(MBEDTLS_AES_C) && !defined(MBEDTLS_AES_ALT)
+#define MBEDTLS_GCM_HAVE_STITCHED
+#endif
 
 /*
  * Initialize a context
@@ -55,6 +64,36 @@ void mbedtls_gcm_init(mbedtls_gcm_context *ctx)
     memset(ctx, 0, sizeof(mbedtls_gcm_context));
 }
 
+#if defined(MBEDTLS_GCM_HAVE_STITCHED)
+/*
+ * Return the AES context used by ctx, or NULL if the block cipher is not
+ * AES or is not implemented by aes.c.
+ */
+static mbedtls_aes_context *gcm_aes_context(mbedtls_gcm_context *ctx)
+{
+#if defined(MBEDTLS_BLOCK_CIPHER_C)
+#if defined(MBEDTLS_BLOCK_CIPHER_SOME_PSA)
+    if (ctx->block_cipher_ctx.engine != MBEDTLS_BLOCK_CIPHER_ENGINE_LEGACY) {
+        return NULL;
+    }
+#endif
+    if (ctx->block_cipher_ctx.id != MBEDTLS_BLOCK_CIPHER_ID_AES) {
+        return NULL;
+    }
+    return &ctx->block_cipher_ctx.ctx.aes;
+#else
+    switch (mbedtls_cipher_get_type(&ctx->cipher_ctx)) {
+        case MBEDTLS_CIPHER_AES_128_ECB:
+        case MBEDTLS_CIPHER_AES_192_ECB:
+        case MBEDTLS_CIPHER_AES_256_ECB:
+            return ctx->cipher_ctx.cipher_ctx;
+        default:
+            return NULL;
+    }
+#endif
+}
+#endif /* MBEDTLS_GCM_HAVE_STITCHED */
+
 static inline void gcm_set_acceleration(mbedtls_gcm_context *ctx)
 {
 #if defined(MBEDTLS_GCM_LARGE_TABLE)
@@ -67,12 +106,23 @@ static inline void gcm_set_acceleration(mbedtls_gcm_context *ctx)
     /* With CLMUL support, we need only h, not the rest of the table */
     if (mbedtls_aesni_has_support(MBEDTLS_AESNI_CLMUL)) {
         ctx->acceleration = MBEDTLS_GCM_ACC_AESNI;
+#if defined(MBEDTLS_GCM_HAVE_STITCHED)
+        if (mbedtls_aesni_has_support(MBEDTLS_AESNI_AES) &&
+            gcm_aes_context(ctx) != NULL) {
+            ctx->acceleration = MBEDTLS_GCM_ACC_AESNI_AES;
+        }
+#endif
     }
 #endif
 
 #if defined(MBEDTLS_AESCE_HAVE_CODE)
     if (MBEDTLS_AESCE_HAS_SUPPORT()) {
         ctx->acceleration = MBEDTLS_GCM_ACC_AESCE;
+#if defined(MBEDTLS_GCM_HAVE_STITCHED)
+        if (gcm_aes_context(ctx) != NULL) {
+            ctx->acceleration = MBEDTLS_GCM_ACC_AESCE_AES;
+        }
+#endif
     }
 #endif
 }
@@ -122,11 +172,31 @@ static int gcm_gen_table(mbedtls_gcm_context *ctx)
 #if defined(MBEDTLS_AESNI_HAVE_CODE)
         case MBEDTLS_GCM_ACC_AESNI:
             return 0;
+#if defined(MBEDTLS_GCM_HAVE_STITCHED)
+        case MBEDTLS_GCM_ACC_AESNI_AES:
+            /* The stitched kernel needs H^4, H^3, H^2, H in H[0..3] */
+            memcpy(ctx->H[3], h, 16);
+            for (i = 2; i >= 0; i--) {
+                mbedtls_aesni_gcm_mult((unsigned char *) ctx->H[i],
+                                       (unsigned char *) ctx->H[i + 1], h);
+            }
+            return 0;
+#endif
 #endif
 
 #if defined(MBEDTLS_AESCE_HAVE_CODE)
         case MBEDTLS_GCM_ACC_AESCE:
             return 0;
+#if defined(MBEDTLS_GCM_HAVE_STITCHED)
+        case MBEDTLS_GCM_ACC_AESCE_AES:
+            /* The stitched kernel needs H^4, H^3, H^2, H in H[0..3] */
+            memcpy(ctx->H[3], h, 16);
+            for (i = 2; i >= 0; i--) {
+                mbedtls_aesce_gcm_mult((unsigned char *) ctx->H[i],
+                                       (unsigned char *) ctx->H[i + 1], h);
+            }
+            return 0;
+#endif
 #endif
 
         default:
@@ -350,12 +420,14 @@ static void gcm_mult(mbedtls_gcm_context *ctx, const unsigned char x[16],
     switch (ctx->acceleration) {
 #if defined(MBEDTLS_AESNI_HAVE_CODE)
         case MBEDTLS_GCM_ACC_AESNI:
+        case MBEDTLS_GCM_ACC_AESNI_AES:
             mbedtls_aesni_gcm_mult(output, x, (uint8_t *) ctx->H[MBEDTLS_GCM_HTABLE_SIZE/2]);
             break;
 #endif
 
 #if defined(MBEDTLS_AESCE_HAVE_CODE)
         case MBEDTLS_GCM_ACC_AESCE:
+        case MBEDTLS_GCM_ACC_AESCE_AES:
             mbedtls_aesce_gcm_mult(output, x, (uint8_t *) ctx->H[MBEDTLS_GCM_HTABLE_SIZE/2]);
             break;
 #endif
@@ -561,6 +633,48 @@ static int gcm_mask(mbedtls_gcm_context *ctx,
     return 0;
 }
 
+#if defined(MBEDTLS_GCM_HAVE_STITCHED)
+/* Encrypt or decrypt as many groups of four whole blocks as possible with
+ * the stitched AES-CTR/GHASH kernel, if the context uses one. Return the
+ * number of bytes processed, which may be 0. */
+static size_t gcm_crypt_blocks(mbedtls_gcm_context *ctx,
+                               const unsigned char *input,
+                               unsigned char *output,
+                               size_t length)
+{
+    size_t blocks = (length / 64) * 4;
+    int mode = (ctx->mode == MBEDTLS_GCM_ENCRYPT) ?
+               MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT;
+    int ret = 1;
+
+    if (blocks == 0) {
+        return 0;
+    }
+
+    switch (ctx->acceleration) {
+#if defined(MBEDTLS_AESNI_HAVE_CODE)
+        case MBEDTLS_GCM_ACC_AESNI_AES:
+            ret = mbedtls_aesni_gcm_crypt_blocks(gcm_aes_context(ctx), mode,
+                                                 (const unsigned char *) ctx->H[0],
+                                                 ctx->y, ctx->buf,
+                                                 blocks, input, output);
+            break;
+#endif
+
+#if defined(MBEDTLS_AESCE_HAVE_CODE)
+        case MBEDTLS_GCM_ACC_AESCE_AES:
+            ret = mbedtls_aesce_gcm_crypt_blocks(gcm_aes_context(ctx), mode,
+                                                 (const unsigned char *) ctx->H[0],
+                                                 ctx->y, ctx->buf,
+                                                 blocks, input, output);
+            break;
+#endif
+    }
+
+    return (ret == 0) ? blocks * 16 : 0;
+}
+#endif /* MBEDTLS_GCM_HAVE_STITCHED */
+
 int mbedtls_gcm_update(mbedtls_gcm_context *ctx,
                        const unsigned char *input, size_t input_length,
                        unsigned char *output, size_t output_size,
@@ -623,6 +737,15 @@ int mbedtls_gcm_update(mbedtls_gcm_context *ctx,
 
     ctx->len += input_length;
 
+#if defined(MBEDTLS_GCM_HAVE_STITCHED)
+    {
+        size_t done = gcm_crypt_blocks(ctx, p, out_p, input_length);
+        input_length -= done;
+        p += done;
+        out_p += done;
+    }
+#endif
+
     while (input_length >= 16) {
         gcm_incr(ctx->y);
         if ((ret = gcm_mask(ctx, ectr, 0, 16, p, out_p)) != 0) {
@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "lmots.h"
+#include "sha256_internal.h"
 
 #include "mbedtls/lms.h"
 #include "mbedtls/platform_util.h"
@@ -205,6 +206,100 @@ exit:
  *                      MBEDTLS_LMOTS_SHA256_N32_W8, this is of size 32 *
  *                      34.
  */
+#if defined(MBEDTLS_SHA256_C) && !defined(MBEDTLS_PSA_ACCEL_ALG_SHA_256)
+/* The chains of several digits are walked together, so that each step hashes
+ * one message per chain with mbedtls_sha256_multi(). Each message is
+ * I || q || i || j || tmp. When a PSA driver accelerates SHA-256, the chains
+ * go through PSA instead so that the driver is used. */
+#define CHAIN_MSG_Q_OFFSET     (MBEDTLS_LMOTS_I_KEY_ID_LEN)
+#define CHAIN_MSG_I_OFFSET     (CHAIN_MSG_Q_OFFSET + MBEDTLS_LMOTS_Q_LEAF_ID_LEN)
+#define CHAIN_MSG_J_OFFSET     (CHAIN_MSG_I_OFFSET + I_DIGIT_IDX_LEN)
+#define CHAIN_MSG_TMP_OFFSET   (CHAIN_MSG_J_OFFSET + J_HASH_IDX_LEN)
+
+static int hash_digit_array(const mbedtls_lmots_parameters_t *params,
+                            const unsigned char *x_digit_array,
+                            const unsigned char *hash_idx_min_values,
+                            const unsigned char *hash_idx_max_values,
+                            unsigned char *output)
+{
+    const size_t n_len = MBEDTLS_LMOTS_N_HASH_LEN(params->type);
+    const size_t digit_count = MBEDTLS_LMOTS_P_SIG_DIGIT_COUNT(params->type);
+    unsigned char msg[MBEDTLS_SHA256_MULTI_LANES][CHAIN_MSG_TMP_OFFSET +
+                                                  MBEDTLS_LMOTS_N_HASH_LEN_MAX];
+    unsigned char tmp_hash[MBEDTLS_SHA256_MULTI_LANES][MBEDTLS_LMOTS_N_HASH_LEN_MAX];
+    const unsigned char *in[MBEDTLS_SHA256_MULTI_LANES];
+    unsigned char *out[MBEDTLS_SHA256_MULTI_LANES];
+    unsigned int j_hash_idx_min[MBEDTLS_SHA256_MULTI_LANES];
+    unsigned int j_hash_idx_max[MBEDTLS_SHA256_MULTI_LANES];
+    unsigned int j_hash_idx_lo, j_hash_idx_hi, j_hash_idx;
+    size_t i_digit_first, i_digit_idx, lanes, lane, active;
+    int ret = 0;
+
+    for (i_digit_first = 0; i_digit_first < digit_count; i_digit_first += lanes) {
+        lanes = digit_count - i_digit_first;
+        if (lanes > MBEDTLS_SHA256_MULTI_LANES) {
+            lanes = MBEDTLS_SHA256_MULTI_LANES;
+        }
+
+        j_hash_idx_lo = DIGIT_MAX_VALUE;
+        j_hash_idx_hi = 0;
+        for (lane = 0; lane < lanes; lane++) {
+            i_digit_idx = i_digit_first + lane;
+
+            memcpy(msg[lane], params->I_key_identifier, MBEDTLS_LMOTS_I_KEY_ID_LEN);
+            memcpy(&msg[lane][CHAIN_MSG_Q_OFFSET], params->q_leaf_identifier,
+                   MBEDTLS_LMOTS_Q_LEAF_ID_LEN);
+            MBEDTLS_PUT_UINT16_BE(i_digit_idx, msg[lane], CHAIN_MSG_I_OFFSET);
+            memcpy(&msg[lane][CHAIN_MSG_TMP_OFFSET], &x_digit_array[i_digit_idx * n_len], n_len);
+
+            j_hash_idx_min[lane] = hash_idx_min_values != NULL ?
+                                   hash_idx_min_values[i_digit_idx] : 0;
+            j_hash_idx_max[lane] = hash_idx_max_values != NULL ?
+                                   hash_idx_max_values[i_digit_idx] : DIGIT_MAX_VALUE;
+            if (j_hash_idx_min[lane] < j_hash_idx_lo) {
+                j_hash_idx_lo = j_hash_idx_min[lane];
+            }
+            if (j_hash_idx_max[lane] > j_hash_idx_hi) {
+                j_hash_idx_hi = j_hash_idx_max[lane];
+            }
+        }
+
+        for (j_hash_idx = j_hash_idx_lo; j_hash_idx < j_hash_idx_hi; j_hash_idx++) {
+            active = 0;
+            for (lane = 0; lane < lanes; lane++) {
+                if (j_hash_idx >= j_hash_idx_min[lane] && j_hash_idx < j_hash_idx_max[lane]) {
+                    msg[lane][CHAIN_MSG_J_OFFSET] = (uint8_t) j_hash_idx;
+                    in[active] = msg[lane];
+                    out[active] = tmp_hash[lane];
+                    active++;
+                }
+            }
+
+            ret = mbedtls_sha256_multi(in, CHAIN_MSG_TMP_OFFSET + n_len, out, active);
+            if (ret != 0) {
+                goto exit;
+            }
+
+            for (lane = 0; lane < lanes; lane++) {
+                if (j_hash_idx >= j_hash_idx_min[lane] && j_hash_idx < j_hash_idx_max[lane]) {
+                    memcpy(&msg[lane][CHAIN_MSG_TMP_OFFSET], tmp_hash[lane], n_len);
+                }
+            }
+        }
+
+        for (lane = 0; lane < lanes; lane++) {
+            memcpy(&output[(i_digit_first + lane) * n_len],
+                   &msg[lane][CHAIN_MSG_TMP_OFFSET], n_len);
+        }
+    }
+
+exit:
+    mbedtls_platform_zeroize(msg, sizeof(msg));
+    mbedtls_platform_zeroize(tmp_hash, sizeof(tmp_hash));
+
+    return ret;
+}
+#else /* MBEDTLS_SHA256_C && !MBEDTLS_PSA_ACCEL_ALG_SHA_256 */
 static int hash_digit_array(const mbedtls_lmots_parameters_t *params,
                             const unsigned char *x_digit_array,
                             const unsigned char *hash_idx_min_values,
@@ -294,6 +389,7 @@ exit:
 
     return PSA_TO_MBEDTLS_ERR(status);
 }
+#endif /* MBEDTLS_SHA256_C && !MBEDTLS_PSA_ACCEL_ALG_SHA_256 */
 
 /* Combine the hashes of the digit array into a public key. This is used in
  * in order to calculate a public key from a private key (RFC8554 Algorithm 1
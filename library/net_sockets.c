@@ -14,6 +14,10 @@
 #ifndef _XOPEN_SOURCE
 #define _XOPEN_SOURCE 600 /* sockaddr_storage */
 #endif
+/* accept4() is a GNU extension on Linux C libraries. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 
 #include "common.h"
 
@@ -75,6 +79,14 @@ static int wsa_init_done = 0;
 #define IS_EINTR(ret) ((ret) == EINTR)
 #define SOCKET int
 
+#if defined(__linux__) && defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+#define MBEDTLS_NET_HAVE_ACCEPT4
+#endif
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define MBEDTLS_NET_HAVE_MMSG
+#endif
+
 #endif /* ( _WIN32 || _WIN32_WCE ) && !EFIX64 && !EFI32 */
 
 /* Some MS functions want int and MSVC warns if we pass size_t,
@@ -200,12 +212,73 @@ int mbedtls_net_connect(mbedtls_net_context *ctx, const char *host,
 }
 
 /*
- * Create a listening socket on bind_ip:port
+ * Open a socket for the given address, bind it and make it listen if TCP
  */
-int mbedtls_net_bind(mbedtls_net_context *ctx, const char *bind_ip, const char *port, int proto)
+static int net_bind_addr(mbedtls_net_context *ctx, int family,
+                         const struct sockaddr *addr, size_t addrlen,
+                         int proto, int reuseport)
+{
+    int n;
+
+    ctx->fd = (int) socket(family,
+                           proto == MBEDTLS_NET_PROTO_UDP ? SOCK_DGRAM : SOCK_STREAM,
+                           proto == MBEDTLS_NET_PROTO_UDP ? IPPROTO_UDP : IPPROTO_TCP);
+    if (ctx->fd < 0) {
+        return MBEDTLS_ERR_NET_SOCKET_FAILED;
+    }
+
+    n = 1;
+    if (setsockopt(ctx->fd, SOL_SOCKET, SO_REUSEADDR,
+                   (const char *) &n, sizeof(n)) != 0) {
+        mbedtls_net_close(ctx);
+        return MBEDTLS_ERR_NET_SOCKET_FAILED;
+    }
+
+#if defined(SO_REUSEPORT)
+    if (reuseport &&
+        setsockopt(ctx->fd, SOL_SOCKET, SO_REUSEPORT,
+                   (const char *) &n, sizeof(n)) != 0) {
+        mbedtls_net_close(ctx);
+        return MBEDTLS_ERR_NET_SOCKET_FAILED;
+    }
+#else
+    (void) reuseport;
+#endif
+
+    if (bind(ctx->fd, addr, MSVC_INT_CAST addrlen) != 0) {
+        mbedtls_net_close(ctx);
+        return MBEDTLS_ERR_NET_BIND_FAILED;
+    }
+
+    /* Listen only makes sense for TCP */
+    if (proto == MBEDTLS_NET_PROTO_TCP) {
+        if (listen(ctx->fd, MBEDTLS_NET_LISTEN_BACKLOG) != 0) {
+            mbedtls_net_close(ctx);
+            return MBEDTLS_ERR_NET_LISTEN_FAILED;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Create count listening sockets on bind_ip:port
+ */
+static int net_bind(mbedtls_net_context *ctx, size_t count,
+                    const char *bind_ip, const char *port, int proto)
 {
-    int n, ret;
+    int ret;
+    size_t i;
     struct addrinfo hints, *addr_list, *cur;
+    struct sockaddr_storage local_addr;
+
+#if defined(__socklen_t_defined) || defined(_SOCKLEN_T) ||  \
+    defined(_SOCKLEN_T_DECLARED) || defined(__DEFINED_socklen_t) || \
+    defined(socklen_t) || (defined(_POSIX_VERSION) && _POSIX_VERSION >= 200112L)
+    socklen_t n;
+#else
+    int n;
+#endif
 
     if ((ret = net_prepare()) != 0) {
         return ret;
@@ -227,45 +300,73 @@ int mbedtls_net_bind(mbedtls_net_context *ctx, const char *bind_ip, const char *
     /* Try the sockaddrs until a binding succeeds */
     ret = MBEDTLS_ERR_NET_UNKNOWN_HOST;
     for (cur = addr_list; cur != NULL; cur = cur->ai_next) {
-        ctx->fd = (int) socket(cur->ai_family, cur->ai_socktype,
-                               cur->ai_protocol);
-        if (ctx->fd < 0) {
-            ret = MBEDTLS_ERR_NET_SOCKET_FAILED;
+        ret = net_bind_addr(&ctx[0], cur->ai_family, cur->ai_addr, cur->ai_addrlen,
+                            proto, count > 1);
+        if (ret != 0) {
             continue;
         }
 
-        n = 1;
-        if (setsockopt(ctx->fd, SOL_SOCKET, SO_REUSEADDR,
-                       (const char *) &n, sizeof(n)) != 0) {
-            mbedtls_net_close(ctx);
-            ret = MBEDTLS_ERR_NET_SOCKET_FAILED;
-            continue;
+        if (count == 1) {
+            break;
         }
 
-        if (bind(ctx->fd, cur->ai_addr, MSVC_INT_CAST cur->ai_addrlen) != 0) {
-            mbedtls_net_close(ctx);
-            ret = MBEDTLS_ERR_NET_BIND_FAILED;
-            continue;
+        /* Bind the other sockets to the address actually bound, which
+         * differs from cur->ai_addr if an ephemeral port was requested */
+        n = sizeof(local_addr);
+        if (getsockname(ctx[0].fd, (struct sockaddr *) &local_addr, &n) != 0) {
+            ret = MBEDTLS_ERR_NET_SOCKET_FAILED;
+            i = 1;
+        } else {
+            for (i = 1; i < count; i++) {
+                ret = net_bind_addr(&ctx[i], cur->ai_family,
+                                    (struct sockaddr *) &local_addr, (size_t) n,
+                                    proto, 1);
+                if (ret != 0) {
+                    break;
+                }
+            }
         }
 
-        /* Listen only makes sense for TCP */
-        if (proto == MBEDTLS_NET_PROTO_TCP) {
-            if (listen(ctx->fd, MBEDTLS_NET_LISTEN_BACKLOG) != 0) {
-                mbedtls_net_close(ctx);
-                ret = MBEDTLS_ERR_NET_LISTEN_FAILED;
-                continue;
-            }
+        if (ret == 0) {
+            break;
         }
 
-        /* Bind was successful */
-        ret = 0;
-        break;
+        /* Close the sockets bound so far and try the next address */
+        while (i > 0) {
+            mbedtls_net_close(&ctx[--i]);
+        }
     }
 
     freeaddrinfo(addr_list);
 
     return ret;
+}
 
+/*
+ * Create a listening socket on bind_ip:port
+ */
+int mbedtls_net_bind(mbedtls_net_context *ctx, const char *bind_ip, const char *port, int proto)
+{
+    return net_bind(ctx, 1, bind_ip, port, proto);
+}
+
+/*
+ * Create several listening sockets sharing bind_ip:port
+ */
+int mbedtls_net_bind_reuseport(mbedtls_net_context *ctx, size_t count,
+                               const char *bind_ip, const char *port, int proto)
+{
+    if (count == 0) {
+        return MBEDTLS_ERR_NET_BAD_INPUT_DATA;
+    }
+
+#if !defined(SO_REUSEPORT)
+    if (count > 1) {
+        return MBEDTLS_ERR_NET_SOCKET_FAILED;
+    }
+#endif
+
+    return net_bind(ctx, count, bind_ip, port, proto);
 }
 
 #if (defined(_WIN32) || defined(_WIN32_WCE)) && !defined(EFIX64) && \
@@ -312,14 +413,17 @@ static int net_would_block(const mbedtls_net_context *ctx)
 #endif /* ( _WIN32 || _WIN32_WCE ) && !EFIX64 && !EFI32 */
 
 /*
- * Accept a connection from a remote client
+ * Accept a connection from a remote client, optionally making the client
+ * socket non-blocking
  */
-int mbedtls_net_accept(mbedtls_net_context *bind_ctx,
-                       mbedtls_net_context *client_ctx,
-                       void *client_ip, size_t buf_size, size_t *cip_len)
+static int net_accept(mbedtls_net_context *bind_ctx,
+                      mbedtls_net_context *client_ctx,
+                      void *client_ip, size_t buf_size, size_t *cip_len,
+                      int nonblock)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     int type;
+    int is_nonblock = 0;
 
     struct sockaddr_storage client_addr;
 
@@ -342,6 +446,14 @@ int mbedtls_net_accept(mbedtls_net_context *bind_ctx,
 
     if (type == SOCK_STREAM) {
         /* TCP: actual accept() */
+#if defined(MBEDTLS_NET_HAVE_ACCEPT4)
+        if (nonblock) {
+            /* Save the fcntl() calls on the new socket */
+            ret = client_ctx->fd = accept4(bind_ctx->fd, (struct sockaddr *) &client_addr,
+                                           &n, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            is_nonblock = 1;
+        } else
+#endif
         ret = client_ctx->fd = (int) accept(bind_ctx->fd,
                                             (struct sockaddr *) &client_addr, &n);
     } else {
@@ -373,6 +485,17 @@ int mbedtls_net_accept(mbedtls_net_context *bind_ctx,
     if (type != SOCK_STREAM) {
         struct sockaddr_storage local_addr;
         int one = 1;
+#if defined(SO_REUSEPORT)
+        int reuseport = 0;
+
+        /* The new socket can only share the port with the other listeners
+         * of a mbedtls_net_bind_reuseport() group if it joins the group */
+        type_len = sizeof(reuseport);
+        if (getsockopt(bind_ctx->fd, SOL_SOCKET, SO_REUSEPORT,
+                       (void *) &reuseport, &type_len) != 0) {
+            reuseport = 0;
+        }
+#endif
 
         if (connect(bind_ctx->fd, (struct sockaddr *) &client_addr, n) != 0) {
             return MBEDTLS_ERR_NET_ACCEPT_FAILED;
@@ -391,11 +514,26 @@ int mbedtls_net_accept(mbedtls_net_context *bind_ctx,
             return MBEDTLS_ERR_NET_SOCKET_FAILED;
         }
 
+#if defined(SO_REUSEPORT)
+        if (reuseport != 0 &&
+            setsockopt(bind_ctx->fd, SOL_SOCKET, SO_REUSEPORT,
+                       (const char *) &one, sizeof(one)) != 0) {
+            return MBEDTLS_ERR_NET_SOCKET_FAILED;
+        }
+#endif
+
         if (bind(bind_ctx->fd, (struct sockaddr *) &local_addr, n) != 0) {
             return MBEDTLS_ERR_NET_BIND_FAILED;
         }
     }
 
+    if (nonblock && !is_nonblock) {
+        if (mbedtls_net_set_nonblock(client_ctx) != 0) {
+            mbedtls_net_close(client_ctx);
+            return MBEDTLS_ERR_NET_ACCEPT_FAILED;
+        }
+    }
+
     if (client_ip != NULL) {
         if (client_addr.ss_family == AF_INET) {
             struct sockaddr_in *addr4 = (struct sockaddr_in *) &client_addr;
@@ -421,6 +559,20 @@ int mbedtls_net_accept(mbedtls_net_context *bind_ctx,
     return 0;
 }
 
+int mbedtls_net_accept(mbedtls_net_context *bind_ctx,
+                       mbedtls_net_context *client_ctx,
+                       void *client_ip, size_t buf_size, size_t *cip_len)
+{
+    return net_accept(bind_ctx, client_ctx, client_ip, buf_size, cip_len, 0);
+}
+
+int mbedtls_net_accept_nonblock(mbedtls_net_context *bind_ctx,
+                                mbedtls_net_context *client_ctx,
+                                void *client_ip, size_t buf_size, size_t *cip_len)
+{
+    return net_accept(bind_ctx, client_ctx, client_ip, buf_size, cip_len, 1);
+}
+
 /*
  * Set the socket blocking or non-blocking
  */
@@ -664,6 +816,179 @@ int mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len)
     return ret;
 }
 
+/*
+ * Translate the error of a failed datagram system call
+ */
+static int net_dgram_error(mbedtls_net_context *ctx, int want, int failed)
+{
+    if (net_would_block(ctx) != 0) {
+        return want;
+    }
+
+#if (defined(_WIN32) || defined(_WIN32_WCE)) && !defined(EFIX64) && \
+    !defined(EFI32)
+    if (WSAGetLastError() == WSAECONNRESET) {
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+#else
+    if (errno == EPIPE || errno == ECONNRESET || errno == ECONNREFUSED) {
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+
+    if (errno == EINTR) {
+        return want;
+    }
+#endif
+
+    return failed;
+}
+
+/*
+ * Receive up to 'count' datagrams
+ */
+int mbedtls_net_recv_batch(mbedtls_net_context *ctx,
+                           mbedtls_net_datagram *dgrams, size_t count)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    size_t i;
+#if defined(MBEDTLS_NET_HAVE_MMSG)
+    struct mmsghdr msgs[MBEDTLS_NET_BATCH_MAX];
+    struct iovec iov[MBEDTLS_NET_BATCH_MAX];
+#else
+    int flags = 0;
+#endif
+
+    ret = check_fd(ctx->fd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (count == 0 || count > MBEDTLS_NET_BATCH_MAX) {
+        return MBEDTLS_ERR_NET_BAD_INPUT_DATA;
+    }
+
+#if defined(MBEDTLS_NET_HAVE_MMSG)
+    memset(msgs, 0, count * sizeof(msgs[0]));
+    for (i = 0; i < count; i++) {
+        iov[i].iov_base = dgrams[i].buf;
+        iov[i].iov_len = dgrams[i].size;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = dgrams[i].addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(dgrams[i].addr);
+    }
+
+    /* Wait for the first datagram only if the socket is blocking, then
+     * take whatever else is already queued */
+    ret = recvmmsg(ctx->fd, msgs, (unsigned int) count, MSG_WAITFORONE, NULL);
+    if (ret < 0) {
+        return net_dgram_error(ctx, MBEDTLS_ERR_SSL_WANT_READ,
+                               MBEDTLS_ERR_NET_RECV_FAILED);
+    }
+
+    for (i = 0; i < (size_t) ret; i++) {
+        dgrams[i].len = msgs[i].msg_len;
+        dgrams[i].addr_len = msgs[i].msg_hdr.msg_namelen;
+    }
+#else
+    /* One system call per datagram. Where possible, only the first one may
+     * block, otherwise the batch is limited to a single datagram. */
+    for (i = 0; i < count; i++) {
+#if defined(__socklen_t_defined) || defined(_SOCKLEN_T) ||  \
+        defined(_SOCKLEN_T_DECLARED) || defined(__DEFINED_socklen_t) || \
+        defined(socklen_t) || (defined(_POSIX_VERSION) && _POSIX_VERSION >= 200112L)
+        socklen_t n = (socklen_t) sizeof(dgrams[i].addr);
+#else
+        int n = (int) sizeof(dgrams[i].addr);
+#endif
+
+        ret = (int) recvfrom(ctx->fd, (char *) dgrams[i].buf, MSVC_INT_CAST dgrams[i].size,
+                             flags, (struct sockaddr *) dgrams[i].addr, &n);
+        if (ret < 0) {
+            if (i > 0) {
+                break;
+            }
+            return net_dgram_error(ctx, MBEDTLS_ERR_SSL_WANT_READ,
+                                   MBEDTLS_ERR_NET_RECV_FAILED);
+        }
+
+        dgrams[i].len = (size_t) ret;
+        dgrams[i].addr_len = (size_t) n;
+
+#if defined(MSG_DONTWAIT)
+        flags = MSG_DONTWAIT;
+#else
+        i++;
+        break;
+#endif
+    }
+    ret = (int) i;
+#endif /* MBEDTLS_NET_HAVE_MMSG */
+
+    return ret;
+}
+
+/*
+ * Send up to 'count' datagrams
+ */
+int mbedtls_net_send_batch(mbedtls_net_context *ctx,
+                           const mbedtls_net_datagram *dgrams, size_t count)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    size_t i;
+#if defined(MBEDTLS_NET_HAVE_MMSG)
+    struct mmsghdr msgs[MBEDTLS_NET_BATCH_MAX];
+    struct iovec iov[MBEDTLS_NET_BATCH_MAX];
+#endif
+
+    ret = check_fd(ctx->fd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (count == 0 || count > MBEDTLS_NET_BATCH_MAX) {
+        return MBEDTLS_ERR_NET_BAD_INPUT_DATA;
+    }
+
+#if defined(MBEDTLS_NET_HAVE_MMSG)
+    memset(msgs, 0, count * sizeof(msgs[0]));
+    for (i = 0; i < count; i++) {
+        iov[i].iov_base = dgrams[i].buf;
+        iov[i].iov_len = dgrams[i].len;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (dgrams[i].addr_len != 0) {
+            msgs[i].msg_hdr.msg_name = (void *) dgrams[i].addr;
+            msgs[i].msg_hdr.msg_namelen = (socklen_t) dgrams[i].addr_len;
+        }
+    }
+
+    ret = sendmmsg(ctx->fd, msgs, (unsigned int) count, 0);
+    if (ret < 0) {
+        return net_dgram_error(ctx, MBEDTLS_ERR_SSL_WANT_WRITE,
+                               MBEDTLS_ERR_NET_SEND_FAILED);
+    }
+#else
+    for (i = 0; i < count; i++) {
+        ret = (int) sendto(ctx->fd, (const char *) dgrams[i].buf,
+                           MSVC_INT_CAST dgrams[i].len, 0,
+                           dgrams[i].addr_len != 0 ?
+                           (const struct sockaddr *) dgrams[i].addr : NULL,
+                           MSVC_INT_CAST dgrams[i].addr_len);
+        if (ret < 0) {
+            if (i > 0) {
+                break;
+            }
+            return net_dgram_error(ctx, MBEDTLS_ERR_SSL_WANT_WRITE,
+                                   MBEDTLS_ERR_NET_SEND_FAILED);
+        }
+    }
+    ret = (int) i;
+#endif /* MBEDTLS_NET_HAVE_MMSG */
+
+    return ret;
+}
+
 /*
  * Close the connection
  */
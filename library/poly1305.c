@@ -11,6 +11,7 @@
 #if defined(MBEDTLS_POLY1305_C)
 
 #include "mbedtls/poly1305.h"
+#include "cpu_features.h"
 #include "mbedtls/platform_util.h"
 #include "mbedtls/error.h"
 
@@ -22,10 +23,41 @@
 
 #define POLY1305_BLOCK_SIZE_BYTES (16U)
 
+/*
+ * On 64-bit hosts where the compiler has a 128-bit integer type, the
+ * accumulator and r are split into three limbs of 44, 44 and 42 bits:
+ * a block then costs 9 multiplications instead of 20 with 32-bit limbs.
+ * The context keeps its 32-bit representation, which is converted on
+ * entry to and exit from poly1305_process().
+ */
+#if defined(__GNUC__) && defined(__SIZEOF_INT128__) && \
+    (defined(MBEDTLS_ARCH_IS_X64) || defined(MBEDTLS_ARCH_IS_ARM64)) && \
+    !defined(MBEDTLS_NO_64BIT_MULTIPLICATION)
+#define POLY1305_RADIX_2_44
+/* Same declaration as mbedtls_t_udbl, which avoids -Wpedantic warnings */
+typedef unsigned int poly1305_uint128 __attribute__((mode(TI)));
+#endif
+
+/*
+ * On x86-64 with AVX2, long inputs are processed four blocks at a time in
+ * radix 2^26. The kernel is compiled with a target pragma and only used if
+ * the CPU and the operating system support AVX2.
+ */
+#if defined(MBEDTLS_CPU_HAVE_AVX2_DETECTION)
+#define POLY1305_SIMD_X4_AVX2
+#include <immintrin.h>
+
+/* Below this, computing r^2, r^3 and r^4 costs more than it saves */
+#define POLY1305_AVX2_MIN_BLOCKS (16U)
+#endif
+
 /*
  * Our implementation is tuned for 32-bit platforms with a 64-bit multiplier.
  * However we provided an alternative for platforms without such a multiplier.
+ * The radix 2^44 code does not need it, but the AVX2 code computes the
+ * powers of r with it.
  */
+#if !defined(POLY1305_RADIX_2_44) || defined(POLY1305_SIMD_X4_AVX2)
 #if defined(MBEDTLS_NO_64BIT_MULTIPLICATION)
 static uint64_t mul64(uint32_t a, uint32_t b)
 {
@@ -48,6 +80,7 @@ static inline uint64_t mul64(uint32_t a, uint32_t b)
     return (uint64_t) a * b;
 }
 #endif
+#endif /* !POLY1305_RADIX_2_44 || POLY1305_SIMD_X4_AVX2 */
 
 
 /**
@@ -61,6 +94,89 @@ static inline uint64_t mul64(uint32_t a, uint32_t b)
  *                          applied to the input data before calling this
  *                          function.  Otherwise, set this parameter to 1.
  */
+#if defined(POLY1305_RADIX_2_44)
+static void poly1305_process(mbedtls_poly1305_context *ctx,
+                             size_t nblocks,
+                             const unsigned char *input,
+                             uint32_t needs_padding)
+{
+    const uint64_t mask44 = 0xFFFFFFFFFFFU;
+    const uint64_t mask42 = 0x3FFFFFFFFFFU;
+    const uint64_t hibit = (uint64_t) needs_padding << 40U;
+    poly1305_uint128 d0, d1, d2;
+    uint64_t r0, r1, r2;
+    uint64_t rs1, rs2;
+    uint64_t acc0, acc1, acc2;
+    uint64_t t0, t1, c;
+    size_t offset  = 0U;
+    size_t i;
+
+    t0 = (uint64_t) ctx->r[0] | ((uint64_t) ctx->r[1] << 32U);
+    t1 = (uint64_t) ctx->r[2] | ((uint64_t) ctx->r[3] << 32U);
+    r0 = t0 & mask44;
+    r1 = ((t0 >> 44U) | (t1 << 20U)) & mask44;
+    r2 = t1 >> 24U;
+
+    /* 2^132 = 4 * 2^130 = 20 mod (2^130 - 5) */
+    rs1 = r1 * 20U;
+    rs2 = r2 * 20U;
+
+    t0 = (uint64_t) ctx->acc[0] | ((uint64_t) ctx->acc[1] << 32U);
+    t1 = (uint64_t) ctx->acc[2] | ((uint64_t) ctx->acc[3] << 32U);
+    acc0 = t0 & mask44;
+    acc1 = ((t0 >> 44U) | (t1 << 20U)) & mask44;
+    acc2 = (t1 >> 24U) | ((uint64_t) ctx->acc[4] << 40U);
+
+    /* Process full blocks */
+    for (i = 0U; i < nblocks; i++) {
+        /* Compute: acc += (padded) block as a 130-bit integer */
+        t0 = MBEDTLS_GET_UINT64_LE(input, offset + 0);
+        t1 = MBEDTLS_GET_UINT64_LE(input, offset + 8);
+        acc0 += t0 & mask44;
+        acc1 += ((t0 >> 44U) | (t1 << 20U)) & mask44;
+        acc2 += ((t1 >> 24U) & mask42) | hibit;
+
+        /* Compute: acc *= r */
+        d0 = (poly1305_uint128) acc0 * r0 +
+             (poly1305_uint128) acc1 * rs2 +
+             (poly1305_uint128) acc2 * rs1;
+        d1 = (poly1305_uint128) acc0 * r1 +
+             (poly1305_uint128) acc1 * r0 +
+             (poly1305_uint128) acc2 * rs2;
+        d2 = (poly1305_uint128) acc0 * r2 +
+             (poly1305_uint128) acc1 * r1 +
+             (poly1305_uint128) acc2 * r0;
+
+        /* Compute: acc %= (2^130 - 5) (partial remainder) */
+        c    = (uint64_t) (d0 >> 44U);
+        acc0 = (uint64_t) d0 & mask44;
+        d1  += c;
+        c    = (uint64_t) (d1 >> 44U);
+        acc1 = (uint64_t) d1 & mask44;
+        d2  += c;
+        c    = (uint64_t) (d2 >> 42U);
+        acc2 = (uint64_t) d2 & mask42;
+        acc0 += c * 5U;
+        c     = acc0 >> 44U;
+        acc0 &= mask44;
+        acc1 += c;
+
+        offset    += POLY1305_BLOCK_SIZE_BYTES;
+    }
+
+    c     = acc1 >> 44U;
+    acc1 &= mask44;
+    acc2 += c;
+
+    t0 = acc0 | (acc1 << 44U);
+    t1 = (acc1 >> 20U) | (acc2 << 24U);
+    ctx->acc[0] = (uint32_t) t0;
+    ctx->acc[1] = (uint32_t) (t0 >> 32U);
+    ctx->acc[2] = (uint32_t) t1;
+    ctx->acc[3] = (uint32_t) (t1 >> 32U);
+    ctx->acc[4] = (uint32_t) (acc2 >> 40U);
+}
+#else /* POLY1305_RADIX_2_44 */
 static void poly1305_process(mbedtls_poly1305_context *ctx,
                              size_t nblocks,
                              const unsigned char *input,
@@ -160,6 +276,218 @@ static void poly1305_process(mbedtls_poly1305_context *ctx,
     ctx->acc[3] = acc3;
     ctx->acc[4] = acc4;
 }
+#endif /* POLY1305_RADIX_2_44 */
+
+#if defined(POLY1305_SIMD_X4_AVX2)
+/**
+ * \brief                   Multiply h by r modulo 2^130 - 5, both in radix
+ *                          2^26, with a partial reduction of the result.
+ */
+static void poly1305_mul_r26(uint32_t h[5], const uint32_t r[5])
+{
+    const uint32_t s1 = r[1] * 5U, s2 = r[2] * 5U, s3 = r[3] * 5U, s4 = r[4] * 5U;
+    uint64_t d0, d1, d2, d3, d4;
+
+    d0 = mul64(h[0], r[0]) + mul64(h[1], s4) + mul64(h[2], s3) + mul64(h[3], s2) + mul64(h[4], s1);
+    d1 = mul64(h[0], r[1]) + mul64(h[1], r[0]) + mul64(h[2], s4) + mul64(h[3], s3) + mul64(h[4], s2);
+    d2 = mul64(h[0], r[2]) + mul64(h[1], r[1]) + mul64(h[2], r[0]) + mul64(h[3], s4) + mul64(h[4], s3);
+    d3 = mul64(h[0], r[3]) + mul64(h[1], r[2]) + mul64(h[2], r[1]) + mul64(h[3], r[0]) + mul64(h[4], s4);
+    d4 = mul64(h[0], r[4]) + mul64(h[1], r[3]) + mul64(h[2], r[2]) + mul64(h[3], r[1]) + mul64(h[4], r[0]);
+
+    d1 += d0 >> 26U;
+    d2 += d1 >> 26U;
+    d3 += d2 >> 26U;
+    d4 += d3 >> 26U;
+    d0  = (d0 & 0x3FFFFFFU) + (d4 >> 26U) * 5U;
+    h[0] = (uint32_t) d0 & 0x3FFFFFFU;
+    h[1] = ((uint32_t) d1 & 0x3FFFFFFU) + (uint32_t) (d0 >> 26U);
+    h[2] = (uint32_t) d2 & 0x3FFFFFFU;
+    h[3] = (uint32_t) d3 & 0x3FFFFFFU;
+    h[4] = (uint32_t) d4 & 0x3FFFFFFU;
+}
+
+#if defined(MBEDTLS_COMPILER_IS_GCC)
+#pragma GCC push_options
+#pragma GCC target ("avx2")
+#define MBEDTLS_POP_TARGET_PRAGMA
+#elif defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#define MBEDTLS_POP_TARGET_PRAGMA
+#endif
+
+/*
+ * Multiply each lane of h by the corresponding lane of r, with s = 5 * r,
+ * and partially reduce. All limbs are in radix 2^26, one per 64-bit lane.
+ */
+static inline void poly1305_mul_x4(__m256i h[5], const __m256i r[5], const __m256i s[5])
+{
+    const __m256i mask = _mm256_set1_epi64x(0x3FFFFFF);
+    __m256i d0, d1, d2, d3, d4, c;
+
+#define MUL(a, b) _mm256_mul_epu32(a, b)
+    d0 = MUL(h[0], r[0]);
+    d1 = MUL(h[0], r[1]);
+    d2 = MUL(h[0], r[2]);
+    d3 = MUL(h[0], r[3]);
+    d4 = MUL(h[0], r[4]);
+    d0 = _mm256_add_epi64(d0, MUL(h[1], s[4]));
+    d1 = _mm256_add_epi64(d1, MUL(h[1], r[0]));
+    d2 = _mm256_add_epi64(d2, MUL(h[1], r[1]));
+    d3 = _mm256_add_epi64(d3, MUL(h[1], r[2]));
+    d4 = _mm256_add_epi64(d4, MUL(h[1], r[3]));
+    d0 = _mm256_add_epi64(d0, MUL(h[2], s[3]));
+    d1 = _mm256_add_epi64(d1, MUL(h[2], s[4]));
+    d2 = _mm256_add_epi64(d2, MUL(h[2], r[0]));
+    d3 = _mm256_add_epi64(d3, MUL(h[2], r[1]));
+    d4 = _mm256_add_epi64(d4, MUL(h[2], r[2]));
+    d0 = _mm256_add_epi64(d0, MUL(h[3], s[2]));
+    d1 = _mm256_add_epi64(d1, MUL(h[3], s[3]));
+    d2 = _mm256_add_epi64(d2, MUL(h[3], s[4]));
+    d3 = _mm256_add_epi64(d3, MUL(h[3], r[0]));
+    d4 = _mm256_add_epi64(d4, MUL(h[3], r[1]));
+    d0 = _mm256_add_epi64(d0, MUL(h[4], s[1]));
+    d1 = _mm256_add_epi64(d1, MUL(h[4], s[2]));
+    d2 = _mm256_add_epi64(d2, MUL(h[4], s[3]));
+    d3 = _mm256_add_epi64(d3, MUL(h[4], s[4]));
+    d4 = _mm256_add_epi64(d4, MUL(h[4], r[0]));
+#undef MUL
+
+    d1 = _mm256_add_epi64(d1, _mm256_srli_epi64(d0, 26));
+    d2 = _mm256_add_epi64(d2, _mm256_srli_epi64(d1, 26));
+    d3 = _mm256_add_epi64(d3, _mm256_srli_epi64(d2, 26));
+    d4 = _mm256_add_epi64(d4, _mm256_srli_epi64(d3, 26));
+    c  = _mm256_srli_epi64(d4, 26);
+    d0 = _mm256_and_si256(d0, mask);
+    d0 = _mm256_add_epi64(d0, _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+    h[0] = _mm256_and_si256(d0, mask);
+    h[1] = _mm256_add_epi64(_mm256_and_si256(d1, mask), _mm256_srli_epi64(d0, 26));
+    h[2] = _mm256_and_si256(d2, mask);
+    h[3] = _mm256_and_si256(d3, mask);
+    h[4] = _mm256_and_si256(d4, mask);
+}
+
+static inline uint64_t poly1305_hsum_x4(__m256i v)
+{
+    __m128i t = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    t = _mm_add_epi64(t, _mm_unpackhi_epi64(t, t));
+    return (uint64_t) _mm_cvtsi128_si64(t);
+}
+
+/**
+ * \brief                   Process blocks with Poly1305 using AVX2.
+ *
+ *                          Each lane accumulates every fourth block and is
+ *                          multiplied by r^4, except for the last group of
+ *                          blocks where the lanes are multiplied by r^4, r^3,
+ *                          r^2 and r respectively, then summed.
+ *
+ * \param ctx               The Poly1305 context.
+ * \param nblocks           Number of blocks to process. Must be a non-zero
+ *                          multiple of 4. The padding bit is always added.
+ * \param input             Buffer containing the input blocks.
+ */
+static void poly1305_process_avx2(mbedtls_poly1305_context *ctx,
+                                  size_t nblocks,
+                                  const unsigned char *input)
+{
+    const __m256i mask = _mm256_set1_epi64x(0x3FFFFFF);
+    const __m256i hibit = _mm256_set1_epi64x(1 << 24);
+    uint32_t rp[4][5];
+    uint64_t d[5];
+    __m256i r4[5], s4[5], rf[5], sf[5], h[5];
+    __m256i t0, t1, lo, hi;
+    size_t i;
+    int k;
+
+    /* r, then r^2, r^3 and r^4, in radix 2^26 */
+    rp[0][0] = ctx->r[0] & 0x3FFFFFFU;
+    rp[0][1] = ((ctx->r[0] >> 26U) | (ctx->r[1] << 6U)) & 0x3FFFFFFU;
+    rp[0][2] = ((ctx->r[1] >> 20U) | (ctx->r[2] << 12U)) & 0x3FFFFFFU;
+    rp[0][3] = ((ctx->r[2] >> 14U) | (ctx->r[3] << 18U)) & 0x3FFFFFFU;
+    rp[0][4] = ctx->r[3] >> 8U;
+    for (k = 1; k < 4; k++) {
+        memcpy(rp[k], rp[k - 1], sizeof(rp[k]));
+        poly1305_mul_r26(rp[k], rp[0]);
+    }
+
+    /* The message loads below leave blocks 0, 2, 1 and 3 of each group in
+     * lanes 0 to 3, so the powers for the last group are in that order. */
+    for (k = 0; k < 5; k++) {
+        r4[k] = _mm256_set1_epi64x(rp[3][k]);
+        s4[k] = _mm256_set1_epi64x(rp[3][k] * 5U);
+        rf[k] = _mm256_set_epi64x(rp[0][k], rp[2][k], rp[1][k], rp[3][k]);
+        sf[k] = _mm256_set_epi64x(rp[0][k] * 5U, rp[2][k] * 5U,
+                                  rp[1][k] * 5U, rp[3][k] * 5U);
+    }
+    mbedtls_platform_zeroize(rp, sizeof(rp));
+
+    /* The accumulator starts in lane 0 */
+    h[0] = _mm256_set_epi64x(0, 0, 0, ctx->acc[0] & 0x3FFFFFFU);
+    h[1] = _mm256_set_epi64x(0, 0, 0, ((ctx->acc[0] >> 26U) | (ctx->acc[1] << 6U)) & 0x3FFFFFFU);
+    h[2] = _mm256_set_epi64x(0, 0, 0, ((ctx->acc[1] >> 20U) | (ctx->acc[2] << 12U)) & 0x3FFFFFFU);
+    h[3] = _mm256_set_epi64x(0, 0, 0, ((ctx->acc[2] >> 14U) | (ctx->acc[3] << 18U)) & 0x3FFFFFFU);
+    h[4] = _mm256_set_epi64x(0, 0, 0, (ctx->acc[3] >> 8U) | (ctx->acc[4] << 24U));
+
+    for (i = 0U; i < nblocks; i += 4U) {
+        /* lo and hi hold the low and high 64 bits of blocks 0, 2, 1, 3 */
+        t0 = _mm256_loadu_si256((const __m256i *) input);
+        t1 = _mm256_loadu_si256((const __m256i *) (input + 32));
+        lo = _mm256_unpacklo_epi64(t0, t1);
+        hi = _mm256_unpackhi_epi64(t0, t1);
+
+        h[0] = _mm256_add_epi64(h[0], _mm256_and_si256(lo, mask));
+        h[1] = _mm256_add_epi64(h[1], _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask));
+        h[2] = _mm256_add_epi64(h[2],
+                                _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52),
+                                                                 _mm256_slli_epi64(hi, 12)),
+                                                 mask));
+        h[3] = _mm256_add_epi64(h[3], _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask));
+        h[4] = _mm256_add_epi64(h[4], _mm256_or_si256(_mm256_srli_epi64(hi, 40), hibit));
+
+        if (i + 4U < nblocks) {
+            poly1305_mul_x4(h, r4, s4);
+        } else {
+            poly1305_mul_x4(h, rf, sf);
+        }
+
+        input += 4U * POLY1305_BLOCK_SIZE_BYTES;
+    }
+
+    /* Sum the lanes and partially reduce, leaving bits 130 and up in acc[4] */
+    for (k = 0; k < 5; k++) {
+        d[k] = poly1305_hsum_x4(h[k]);
+    }
+    for (k = 0; k < 2; k++) {
+        d[1] += d[0] >> 26U;
+        d[0] &= 0x3FFFFFFU;
+        d[2] += d[1] >> 26U;
+        d[1] &= 0x3FFFFFFU;
+        d[3] += d[2] >> 26U;
+        d[2] &= 0x3FFFFFFU;
+        d[4] += d[3] >> 26U;
+        d[3] &= 0x3FFFFFFU;
+        if (k == 0) {
+            d[0] += (d[4] >> 26U) * 5U;
+            d[4] &= 0x3FFFFFFU;
+        }
+    }
+
+    ctx->acc[0] = (uint32_t) (d[0] | (d[1] << 26U));
+    ctx->acc[1] = (uint32_t) ((d[1] >> 6U) | (d[2] << 20U));
+    ctx->acc[2] = (uint32_t) ((d[2] >> 12U) | (d[3] << 14U));
+    ctx->acc[3] = (uint32_t) ((d[3] >> 18U) | (d[4] << 8U));
+    ctx->acc[4] = (uint32_t) (d[4] >> 24U);
+}
+
+#if defined(MBEDTLS_POP_TARGET_PRAGMA)
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#undef MBEDTLS_POP_TARGET_PRAGMA
+#endif
+#endif /* POLY1305_SIMD_X4_AVX2 */
 
 /**
  * \brief                   Compute the Poly1305 MAC
@@ -308,6 +636,17 @@ int mbedtls_poly1305_update(mbedtls_poly1305_context *ctx,
     if (remaining >= POLY1305_BLOCK_SIZE_BYTES) {
         nblocks = remaining / POLY1305_BLOCK_SIZE_BYTES;
 
+#if defined(POLY1305_SIMD_X4_AVX2)
+        if (nblocks >= POLY1305_AVX2_MIN_BLOCKS && mbedtls_cpu_has_avx2()) {
+            size_t vblocks = nblocks & ~(size_t) 3U;
+
+            poly1305_process_avx2(ctx, vblocks, &input[offset]);
+
+            offset  += vblocks * POLY1305_BLOCK_SIZE_BYTES;
+            nblocks -= vblocks;
+        }
+#endif
+
         poly1305_process(ctx, nblocks, &input[offset], 1U);
 
         offset += nblocks * POLY1305_BLOCK_SIZE_BYTES;
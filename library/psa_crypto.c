@@ -5072,6 +5072,125 @@ exit:
     return status;
 }
 
+psa_status_t mbedtls_psa_aead_keyed_setup(mbedtls_psa_aead_operation_t *operation,
+                                          mbedtls_svc_key_id_t key,
+                                          psa_key_usage_t usage,
+                                          psa_algorithm_t alg)
+{
+    psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
+    psa_status_t unlock_status = PSA_ERROR_CORRUPTION_DETECTED;
+    psa_key_slot_t *slot;
+
+    status = psa_aead_check_algorithm(alg);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    status = psa_get_and_lock_key_slot_with_policy(key, &slot, usage, alg);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+#if defined(PSA_CRYPTO_ACCELERATOR_DRIVER_PRESENT)
+    /* Accelerators take precedence over the built-in implementation in
+     * psa_driver_wrapper_aead_encrypt(), so don't bypass them here. */
+    status = PSA_ERROR_NOT_SUPPORTED;
+#else
+    if (PSA_KEY_LIFETIME_GET_LOCATION(slot->attr.lifetime) !=
+        PSA_KEY_LOCATION_LOCAL_STORAGE) {
+        status = PSA_ERROR_NOT_SUPPORTED;
+    } else {
+        status = mbedtls_psa_aead_set_key(operation, &slot->attr,
+                                          slot->key.data, slot->key.bytes,
+                                          alg);
+    }
+#endif /* PSA_CRYPTO_ACCELERATOR_DRIVER_PRESENT */
+
+    if (status != PSA_SUCCESS) {
+        mbedtls_psa_aead_keyed_free(operation);
+    }
+
+    unlock_status = psa_unregister_read_under_mutex(slot);
+
+    return (status == PSA_SUCCESS) ? unlock_status : status;
+}
+
+psa_status_t mbedtls_psa_aead_keyed_encrypt(mbedtls_psa_aead_operation_t *operation,
+                                            const uint8_t *nonce,
+                                            size_t nonce_length,
+                                            const uint8_t *additional_data,
+                                            size_t additional_data_length,
+                                            const uint8_t *plaintext,
+                                            size_t plaintext_length,
+                                            uint8_t *ciphertext,
+                                            size_t ciphertext_size,
+                                            size_t *ciphertext_length)
+{
+    psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
+
+    *ciphertext_length = 0;
+
+    status = psa_aead_check_nonce_length(operation->alg, nonce_length);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    status = mbedtls_psa_aead_encrypt_keyed(operation,
+                                            nonce, nonce_length,
+                                            additional_data,
+                                            additional_data_length,
+                                            plaintext, plaintext_length,
+                                            ciphertext, ciphertext_size,
+                                            ciphertext_length);
+
+    if (status != PSA_SUCCESS && ciphertext_size != 0) {
+        memset(ciphertext, 0, ciphertext_size);
+    }
+
+    return status;
+}
+
+psa_status_t mbedtls_psa_aead_keyed_decrypt(mbedtls_psa_aead_operation_t *operation,
+                                            const uint8_t *nonce,
+                                            size_t nonce_length,
+                                            const uint8_t *additional_data,
+                                            size_t additional_data_length,
+                                            const uint8_t *ciphertext,
+                                            size_t ciphertext_length,
+                                            uint8_t *plaintext,
+                                            size_t plaintext_size,
+                                            size_t *plaintext_length)
+{
+    psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
+
+    *plaintext_length = 0;
+
+    status = psa_aead_check_nonce_length(operation->alg, nonce_length);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    status = mbedtls_psa_aead_decrypt_keyed(operation,
+                                            nonce, nonce_length,
+                                            additional_data,
+                                            additional_data_length,
+                                            ciphertext, ciphertext_length,
+                                            plaintext, plaintext_size,
+                                            plaintext_length);
+
+    if (status != PSA_SUCCESS && plaintext_size != 0) {
+        memset(plaintext, 0, plaintext_size);
+    }
+
+    return status;
+}
+
+void mbedtls_psa_aead_keyed_free(mbedtls_psa_aead_operation_t *operation)
+{
+    mbedtls_psa_aead_abort(operation);
+    mbedtls_platform_zeroize(operation, sizeof(*operation));
+}
+
 static psa_status_t psa_validate_tag_length(psa_algorithm_t alg)
 {
     const uint8_t tag_len = PSA_ALG_AEAD_GET_TAG_LENGTH(alg);
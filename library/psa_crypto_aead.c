@@ -114,66 +114,65 @@ static psa_status_t psa_aead_setup(
     return PSA_SUCCESS;
 }
 
-psa_status_t mbedtls_psa_aead_encrypt(
+psa_status_t mbedtls_psa_aead_set_key(
+    mbedtls_psa_aead_operation_t *operation,
     const psa_key_attributes_t *attributes,
-    const uint8_t *key_buffer, size_t key_buffer_size,
-    psa_algorithm_t alg,
+    const uint8_t *key_buffer,
+    size_t key_buffer_size,
+    psa_algorithm_t alg)
+{
+    return psa_aead_setup(operation, attributes, key_buffer,
+                          key_buffer_size, alg);
+}
+
+psa_status_t mbedtls_psa_aead_encrypt_keyed(
+    mbedtls_psa_aead_operation_t *operation,
     const uint8_t *nonce, size_t nonce_length,
     const uint8_t *additional_data, size_t additional_data_length,
     const uint8_t *plaintext, size_t plaintext_length,
     uint8_t *ciphertext, size_t ciphertext_size, size_t *ciphertext_length)
 {
     psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
-    mbedtls_psa_aead_operation_t operation = MBEDTLS_PSA_AEAD_OPERATION_INIT;
     uint8_t *tag;
 
-    status = psa_aead_setup(&operation, attributes, key_buffer,
-                            key_buffer_size, alg);
-
-    if (status != PSA_SUCCESS) {
-        goto exit;
-    }
-
     /* For all currently supported modes, the tag is at the end of the
      * ciphertext. */
-    if (ciphertext_size < (plaintext_length + operation.tag_length)) {
-        status = PSA_ERROR_BUFFER_TOO_SMALL;
-        goto exit;
+    if (ciphertext_size < (plaintext_length + operation->tag_length)) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
     }
     tag = ciphertext + plaintext_length;
 
 #if defined(MBEDTLS_PSA_BUILTIN_ALG_CCM)
-    if (operation.alg == PSA_ALG_CCM) {
+    if (operation->alg == PSA_ALG_CCM) {
         status = mbedtls_to_psa_error(
-            mbedtls_ccm_encrypt_and_tag(&operation.ctx.ccm,
+            mbedtls_ccm_encrypt_and_tag(&operation->ctx.ccm,
                                         plaintext_length,
                                         nonce, nonce_length,
                                         additional_data,
                                         additional_data_length,
                                         plaintext, ciphertext,
-                                        tag, operation.tag_length));
+                                        tag, operation->tag_length));
     } else
 #endif /* MBEDTLS_PSA_BUILTIN_ALG_CCM */
 #if defined(MBEDTLS_PSA_BUILTIN_ALG_GCM)
-    if (operation.alg == PSA_ALG_GCM) {
+    if (operation->alg == PSA_ALG_GCM) {
         status = mbedtls_to_psa_error(
-            mbedtls_gcm_crypt_and_tag(&operation.ctx.gcm,
+            mbedtls_gcm_crypt_and_tag(&operation->ctx.gcm,
                                       MBEDTLS_GCM_ENCRYPT,
                                       plaintext_length,
                                       nonce, nonce_length,
                                       additional_data, additional_data_length,
                                       plaintext, ciphertext,
-                                      operation.tag_length, tag));
+                                      operation->tag_length, tag));
     } else
 #endif /* MBEDTLS_PSA_BUILTIN_ALG_GCM */
 #if defined(MBEDTLS_PSA_BUILTIN_ALG_CHACHA20_POLY1305)
-    if (operation.alg == PSA_ALG_CHACHA20_POLY1305) {
-        if (operation.tag_length != 16) {
-            status = PSA_ERROR_NOT_SUPPORTED;
-            goto exit;
+    if (operation->alg == PSA_ALG_CHACHA20_POLY1305) {
+        if (operation->tag_length != 16) {
+            return PSA_ERROR_NOT_SUPPORTED;
         }
         status = mbedtls_to_psa_error(
-            mbedtls_chachapoly_encrypt_and_tag(&operation.ctx.chachapoly,
+            mbedtls_chachapoly_encrypt_and_tag(&operation->ctx.chachapoly,
                                                plaintext_length,
                                                nonce,
                                                additional_data,
@@ -194,9 +193,39 @@ psa_status_t mbedtls_psa_aead_encrypt(
     }
 
     if (status == PSA_SUCCESS) {
-        *ciphertext_length = plaintext_length + operation.tag_length;
+        *ciphertext_length = plaintext_length + operation->tag_length;
+    }
+
+    return status;
+}
+
+psa_status_t mbedtls_psa_aead_encrypt(
+    const psa_key_attributes_t *attributes,
+    const uint8_t *key_buffer, size_t key_buffer_size,
+    psa_algorithm_t alg,
+    const uint8_t *nonce, size_t nonce_length,
+    const uint8_t *additional_data, size_t additional_data_length,
+    const uint8_t *plaintext, size_t plaintext_length,
+    uint8_t *ciphertext, size_t ciphertext_size, size_t *ciphertext_length)
+{
+    psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
+    mbedtls_psa_aead_operation_t operation = MBEDTLS_PSA_AEAD_OPERATION_INIT;
+
+    status = psa_aead_setup(&operation, attributes, key_buffer,
+                            key_buffer_size, alg);
+
+    if (status != PSA_SUCCESS) {
+        goto exit;
     }
 
+    status = mbedtls_psa_aead_encrypt_keyed(&operation,
+                                            nonce, nonce_length,
+                                            additional_data,
+                                            additional_data_length,
+                                            plaintext, plaintext_length,
+                                            ciphertext, ciphertext_size,
+                                            ciphertext_length);
+
 exit:
     mbedtls_psa_aead_abort(&operation);
 
@@ -226,66 +255,55 @@ static psa_status_t psa_aead_unpadded_locate_tag(size_t tag_length,
     return PSA_SUCCESS;
 }
 
-psa_status_t mbedtls_psa_aead_decrypt(
-    const psa_key_attributes_t *attributes,
-    const uint8_t *key_buffer, size_t key_buffer_size,
-    psa_algorithm_t alg,
+psa_status_t mbedtls_psa_aead_decrypt_keyed(
+    mbedtls_psa_aead_operation_t *operation,
     const uint8_t *nonce, size_t nonce_length,
     const uint8_t *additional_data, size_t additional_data_length,
     const uint8_t *ciphertext, size_t ciphertext_length,
     uint8_t *plaintext, size_t plaintext_size, size_t *plaintext_length)
 {
     psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
-    mbedtls_psa_aead_operation_t operation = MBEDTLS_PSA_AEAD_OPERATION_INIT;
     const uint8_t *tag = NULL;
 
-    status = psa_aead_setup(&operation, attributes, key_buffer,
-                            key_buffer_size, alg);
-
-    if (status != PSA_SUCCESS) {
-        goto exit;
-    }
-
-    status = psa_aead_unpadded_locate_tag(operation.tag_length,
+    status = psa_aead_unpadded_locate_tag(operation->tag_length,
                                           ciphertext, ciphertext_length,
                                           plaintext_size, &tag);
     if (status != PSA_SUCCESS) {
-        goto exit;
+        return status;
     }
 
 #if defined(MBEDTLS_PSA_BUILTIN_ALG_CCM)
-    if (operation.alg == PSA_ALG_CCM) {
+    if (operation->alg == PSA_ALG_CCM) {
         status = mbedtls_to_psa_error(
-            mbedtls_ccm_auth_decrypt(&operation.ctx.ccm,
-                                     ciphertext_length - operation.tag_length,
+            mbedtls_ccm_auth_decrypt(&operation->ctx.ccm,
+                                     ciphertext_length - operation->tag_length,
                                      nonce, nonce_length,
                                      additional_data,
                                      additional_data_length,
                                      ciphertext, plaintext,
-                                     tag, operation.tag_length));
+                                     tag, operation->tag_length));
     } else
 #endif /* MBEDTLS_PSA_BUILTIN_ALG_CCM */
 #if defined(MBEDTLS_PSA_BUILTIN_ALG_GCM)
-    if (operation.alg == PSA_ALG_GCM) {
+    if (operation->alg == PSA_ALG_GCM) {
         status = mbedtls_to_psa_error(
-            mbedtls_gcm_auth_decrypt(&operation.ctx.gcm,
-                                     ciphertext_length - operation.tag_length,
+            mbedtls_gcm_auth_decrypt(&operation->ctx.gcm,
+                                     ciphertext_length - operation->tag_length,
                                      nonce, nonce_length,
                                      additional_data,
                                      additional_data_length,
-                                     tag, operation.tag_length,
+                                     tag, operation->tag_length,
                                      ciphertext, plaintext));
     } else
 #endif /* MBEDTLS_PSA_BUILTIN_ALG_GCM */
 #if defined(MBEDTLS_PSA_BUILTIN_ALG_CHACHA20_POLY1305)
-    if (operation.alg == PSA_ALG_CHACHA20_POLY1305) {
-        if (operation.tag_length != 16) {
-            status = PSA_ERROR_NOT_SUPPORTED;
-            goto exit;
+    if (operation->alg == PSA_ALG_CHACHA20_POLY1305) {
+        if (operation->tag_length != 16) {
+            return PSA_ERROR_NOT_SUPPORTED;
         }
         status = mbedtls_to_psa_error(
-            mbedtls_chachapoly_auth_decrypt(&operation.ctx.chachapoly,
-                                            ciphertext_length - operation.tag_length,
+            mbedtls_chachapoly_auth_decrypt(&operation->ctx.chachapoly,
+                                            ciphertext_length - operation->tag_length,
                                             nonce,
                                             additional_data,
                                             additional_data_length,
@@ -304,15 +322,42 @@ psa_status_t mbedtls_psa_aead_decrypt(
     }
 
     if (status == PSA_SUCCESS) {
-        *plaintext_length = ciphertext_length - operation.tag_length;
+        *plaintext_length = ciphertext_length - operation->tag_length;
+    }
+
+    return status;
+}
+
+psa_status_t mbedtls_psa_aead_decrypt(
+    const psa_key_attributes_t *attributes,
+    const uint8_t *key_buffer, size_t key_buffer_size,
+    psa_algorithm_t alg,
+    const uint8_t *nonce, size_t nonce_length,
+    const uint8_t *additional_data, size_t additional_data_length,
+    const uint8_t *ciphertext, size_t ciphertext_length,
+    uint8_t *plaintext, size_t plaintext_size, size_t *plaintext_length)
+{
+    psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
+    mbedtls_psa_aead_operation_t operation = MBEDTLS_PSA_AEAD_OPERATION_INIT;
+
+    status = psa_aead_setup(&operation, attributes, key_buffer,
+                            key_buffer_size, alg);
+
+    if (status != PSA_SUCCESS) {
+        goto exit;
     }
 
+    status = mbedtls_psa_aead_decrypt_keyed(&operation,
+                                            nonce, nonce_length,
+                                            additional_data,
+                                            additional_data_length,
+                                            ciphertext, ciphertext_length,
+                                            plaintext, plaintext_size,
+                                            plaintext_length);
+
 exit:
     mbedtls_psa_aead_abort(&operation);
 
-    if (status == PSA_SUCCESS) {
-        *plaintext_length = ciphertext_length - operation.tag_length;
-    }
     return status;
 }
 
@@ -136,6 +136,66 @@ psa_status_t mbedtls_psa_aead_decrypt(
     const uint8_t *ciphertext, size_t ciphertext_length,
     uint8_t *plaintext, size_t plaintext_size, size_t *plaintext_length);
 
+/** Set up an AEAD context with a key, for repeated one-shot operations.
+ *
+ * Unlike mbedtls_psa_aead_encrypt() and mbedtls_psa_aead_decrypt(), which
+ * run the key schedule on every call, the context set up by this function
+ * keeps the expanded key and can be passed to
+ * mbedtls_psa_aead_encrypt_keyed() or mbedtls_psa_aead_decrypt_keyed() any
+ * number of times. Release it with mbedtls_psa_aead_abort().
+ *
+ * \note This is not a PSA driver entry point. It is only used by the core
+ *       to implement mbedtls_psa_aead_keyed_setup().
+ *
+ * \param[in,out] operation     The operation object to set up. It must have
+ *                              been initialized to all-zero.
+ * \param[in]  attributes       The attributes of the key to use for the
+ *                              operation.
+ * \param[in]  key_buffer       The buffer containing the key context.
+ * \param      key_buffer_size  Size of the \p key_buffer buffer in bytes.
+ * \param      alg              The AEAD algorithm to compute.
+ *
+ * \retval #PSA_SUCCESS Success.
+ * \retval #PSA_ERROR_NOT_SUPPORTED
+ *         \p alg is not supported by the built-in implementation.
+ * \retval #PSA_ERROR_INSUFFICIENT_MEMORY \emptydescription
+ * \retval #PSA_ERROR_CORRUPTION_DETECTED \emptydescription
+ */
+psa_status_t mbedtls_psa_aead_set_key(
+    mbedtls_psa_aead_operation_t *operation,
+    const psa_key_attributes_t *attributes,
+    const uint8_t *key_buffer,
+    size_t key_buffer_size,
+    psa_algorithm_t alg);
+
+/** Process an authenticated encryption operation with a context set up by
+ *  mbedtls_psa_aead_set_key().
+ *
+ * The parameters and return values are the same as for
+ * mbedtls_psa_aead_encrypt(), except that the key and algorithm are taken
+ * from \p operation, which is left unchanged and may be reused.
+ */
+psa_status_t mbedtls_psa_aead_encrypt_keyed(
+    mbedtls_psa_aead_operation_t *operation,
+    const uint8_t *nonce, size_t nonce_length,
+    const uint8_t *additional_data, size_t additional_data_length,
+    const uint8_t *plaintext, size_t plaintext_length,
+    uint8_t *ciphertext, size_t ciphertext_size, size_t *ciphertext_length);
+
+/** Process an authenticated decryption operation with a context set up by
+ *  mbedtls_psa_aead_set_key().
+ *
+ * The parameters and return values are the same as for
+ * mbedtls_psa_aead_decrypt(), except that the key and algorithm are taken
+ * from \p operation, which is left unchanged and may be reused.
+ */
+psa_status_t mbedtls_psa_aead_decrypt_keyed(
+    mbedtls_psa_aead_operation_t *operation,
+    const uint8_t *nonce, size_t nonce_length,
+    const uint8_t *additional_data, size_t additional_data_length,
+    const uint8_t *ciphertext, size_t ciphertext_length,
+    uint8_t *plaintext, size_t plaintext_size, size_t *plaintext_length);
+
 /** Set the key for a multipart authenticated encryption operation.
  *
  *  \note The signature of this function is that of a PSA driver
@@ -910,6 +910,90 @@ psa_status_t mbedtls_psa_verify_hash_complete(
 psa_status_t mbedtls_psa_verify_hash_abort(
     mbedtls_psa_verify_hash_interruptible_operation_t *operation);
 
+/** Set up a pre-keyed AEAD context bound to a key in the key store.
+ *
+ * This is an internal shortcut for the TLS record layer, which performs
+ * many one-shot AEAD operations with the same key. Calling
+ * psa_aead_encrypt() or psa_aead_decrypt() on every record repeats the key
+ * lookup and the key schedule (AES key expansion, GHASH table, etc.) each
+ * time. The context set up here keeps that state so that
+ * mbedtls_psa_aead_keyed_encrypt() and mbedtls_psa_aead_keyed_decrypt()
+ * only do the per-message work.
+ *
+ * The context holds a copy of the expanded key and is not tied to the
+ * lifetime of \p key: it stays usable after the key is destroyed, and must
+ * be freed with mbedtls_psa_aead_keyed_free(). A context must not be used
+ * concurrently from multiple threads.
+ *
+ * \param[out] operation     The context to set up. It must have been
+ *                           initialized to all-zero.
+ * \param      key           Identifier of the key to use.
+ * \param      usage         The usage that the context will be used for,
+ *                           i.e. #PSA_KEY_USAGE_ENCRYPT or
+ *                           #PSA_KEY_USAGE_DECRYPT. It is checked against
+ *                           the key policy.
+ * \param      alg           The AEAD algorithm to compute.
+ *
+ * \retval #PSA_SUCCESS
+ *         Success.
+ * \retval #PSA_ERROR_NOT_SUPPORTED
+ *         The key is not handled by the built-in implementation, for
+ *         example because it lives in a secure element or because an
+ *         accelerator driver is present. Callers should fall back to
+ *         psa_aead_encrypt() or psa_aead_decrypt().
+ * \return Any error that psa_aead_encrypt() or psa_aead_decrypt() can
+ *         return when looking up the key or checking its policy.
+ */
+psa_status_t mbedtls_psa_aead_keyed_setup(mbedtls_psa_aead_operation_t *operation,
+                                          mbedtls_svc_key_id_t key,
+                                          psa_key_usage_t usage,
+                                          psa_algorithm_t alg);
+
+/** Authenticate and encrypt with a context set up by
+ *  mbedtls_psa_aead_keyed_setup().
+ *
+ * The parameters and return values are the same as for psa_aead_encrypt(),
+ * except that the key and algorithm are those of \p operation. As with
+ * psa_aead_encrypt(), \p ciphertext may be the same buffer as
+ * \p plaintext.
+ */
+psa_status_t mbedtls_psa_aead_keyed_encrypt(mbedtls_psa_aead_operation_t *operation,
+                                            const uint8_t *nonce,
+                                            size_t nonce_length,
+                                            const uint8_t *additional_data,
+                                            size_t additional_data_length,
+                                            const uint8_t *plaintext,
+                                            size_t plaintext_length,
+                                            uint8_t *ciphertext,
+                                            size_t ciphertext_size,
+                                            size_t *ciphertext_length);
+
+/** Decrypt and authenticate with a context set up by
+ *  mbedtls_psa_aead_keyed_setup().
+ *
+ * The parameters and return values are the same as for psa_aead_decrypt(),
+ * except that the key and algorithm are those of \p operation. As with
+ * psa_aead_decrypt(), \p plaintext may be the same buffer as
+ * \p ciphertext.
+ */
+psa_status_t mbedtls_psa_aead_keyed_decrypt(mbedtls_psa_aead_operation_t *operation,
+                                            const uint8_t *nonce,
+                                            size_t nonce_length,
+                                            const uint8_t *additional_data,
+                                            size_t additional_data_length,
+                                            const uint8_t *ciphertext,
+                                            size_t ciphertext_length,
+                                            uint8_t *plaintext,
+                                            size_t plaintext_size,
+                                            size_t *plaintext_length);
+
+/** Free a context set up by mbedtls_psa_aead_keyed_setup().
+ *
+ * This function also accepts an all-zero context, or one whose setup
+ * failed, and leaves \p operation all-zero.
+ */
+void mbedtls_psa_aead_keyed_free(mbedtls_psa_aead_operation_t *operation);
+
 typedef struct psa_crypto_local_input_s {
     uint8_t *buffer;
     size_t length;
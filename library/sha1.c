@@ -15,6 +15,7 @@
 #if defined(MBEDTLS_SHA1_C)
 
 #include "mbedtls/sha1.h"
+#include "cpu_features.h"
 #include "mbedtls/platform_util.h"
 #include "mbedtls/error.h"
 
@@ -22,6 +23,18 @@
 
 #include "mbedtls/platform.h"
 
+#if defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+#if !defined(MBEDTLS_ARCH_IS_X64) && !defined(MBEDTLS_ARCH_IS_X86)
+/* Silently ignored on other architectures */
+#undef MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT
+#elif defined(MBEDTLS_CPU_HAVE_SHA_NI_DETECTION)
+#include <immintrin.h>
+#else
+#warning "No support for SHA-NI intrinsics found, using C code only"
+#undef MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT
+#endif
+#endif /* MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT */
+
 #if !defined(MBEDTLS_SHA1_ALT)
 
 void mbedtls_sha1_init(mbedtls_sha1_context *ctx)
@@ -61,9 +74,20 @@ int mbedtls_sha1_starts(mbedtls_sha1_context *ctx)
     return 0;
 }
 
+#if !defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+#define mbedtls_internal_sha1_process_c mbedtls_internal_sha1_process
+#endif
+
 #if !defined(MBEDTLS_SHA1_PROCESS_ALT)
-int mbedtls_internal_sha1_process(mbedtls_sha1_context *ctx,
-                                  const unsigned char data[64])
+#if defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+/*
+ * This function is for internal use only if we are building both C and SHA-NI
+ * versions, otherwise it is renamed to be the public mbedtls_internal_sha1_process()
+ */
+static
+#endif
+int mbedtls_internal_sha1_process_c(mbedtls_sha1_context *ctx,
+                                    const unsigned char data[64])
 {
     struct {
         uint32_t temp, W[16], A, B, C, D, E;
@@ -232,6 +256,136 @@ int mbedtls_internal_sha1_process(mbedtls_sha1_context *ctx,
 
 #endif /* !MBEDTLS_SHA1_PROCESS_ALT */
 
+#if defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+#if defined(MBEDTLS_COMPILER_IS_GCC)
+#pragma GCC push_options
+#pragma GCC target ("sha,ssse3,sse4.1")
+#define MBEDTLS_POP_TARGET_PRAGMA
+#elif defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sha,ssse3,sse4.1"))), apply_to=function)
+#define MBEDTLS_POP_TARGET_PRAGMA
+#endif
+
+/*
+ * Four rounds with SHA-NI. sha1nexte adds the message words to E, which it
+ * derives from the value of ABCD four rounds earlier (e_prev).
+ */
+#define SHA_NI_ROUNDS4(sched, f)                                        \
+    do                                                                  \
+    {                                                                   \
+        e = _mm_sha1nexte_epu32(e_prev, sched);                         \
+        e_prev = abcd;                                                  \
+        abcd = _mm_sha1rnds4_epu32(abcd, e, f);                         \
+    } while (0)
+
+/* sched0 = W[t..t+3], given sched0..sched3 = W[t-16..t-1] */
+#define SHA_NI_SCHEDULE(sched0, sched1, sched2, sched3)                 \
+    (sched0) = _mm_sha1msg2_epu32(                                      \
+        _mm_xor_si128(_mm_sha1msg1_epu32(sched0, sched1), sched2),      \
+        sched3)
+
+static size_t mbedtls_internal_sha1_process_many_x86_sha_ni(
+    mbedtls_sha1_context *ctx, const unsigned char *msg, size_t len)
+{
+    /* Reverses the bytes of the whole register */
+    const __m128i bswap = _mm_set_epi64x(0x0001020304050607LL, 0x08090A0B0C0D0E0FLL);
+    __m128i abcd, e, e_prev;
+    size_t processed = 0;
+
+    /* The instructions want A in the most significant word, and E in the
+     * most significant word of its own register. */
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &ctx->state[0]), 0x1B);
+    e_prev = _mm_set_epi32((int) ctx->state[4], 0, 0, 0);
+
+    for (;
+         len >= 64;
+         processed += 64, msg += 64, len -= 64) {
+        const __m128i abcd_orig = abcd;
+        const __m128i e_orig = e_prev;
+
+        __m128i sched0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (msg + 16 * 0)), bswap);
+        __m128i sched1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (msg + 16 * 1)), bswap);
+        __m128i sched2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (msg + 16 * 2)), bswap);
+        __m128i sched3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (msg + 16 * 3)), bswap);
+
+        /* Rounds 0 to 3: E is used as is */
+        e = _mm_add_epi32(e_prev, sched0);
+        e_prev = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+
+        /* Rounds 4 to 15 */
+        SHA_NI_ROUNDS4(sched1, 0);
+        SHA_NI_ROUNDS4(sched2, 0);
+        SHA_NI_ROUNDS4(sched3, 0);
+
+        /* Rounds 16 to 79, with the message schedule */
+        SHA_NI_SCHEDULE(sched0, sched1, sched2, sched3);
+        SHA_NI_ROUNDS4(sched0, 0);
+        SHA_NI_SCHEDULE(sched1, sched2, sched3, sched0);
+        SHA_NI_ROUNDS4(sched1, 1);
+        SHA_NI_SCHEDULE(sched2, sched3, sched0, sched1);
+        SHA_NI_ROUNDS4(sched2, 1);
+        SHA_NI_SCHEDULE(sched3, sched0, sched1, sched2);
+        SHA_NI_ROUNDS4(sched3, 1);
+        SHA_NI_SCHEDULE(sched0, sched1, sched2, sched3);
+        SHA_NI_ROUNDS4(sched0, 1);
+        SHA_NI_SCHEDULE(sched1, sched2, sched3, sched0);
+        SHA_NI_ROUNDS4(sched1, 1);
+        SHA_NI_SCHEDULE(sched2, sched3, sched0, sched1);
+        SHA_NI_ROUNDS4(sched2, 2);
+        SHA_NI_SCHEDULE(sched3, sched0, sched1, sched2);
+        SHA_NI_ROUNDS4(sched3, 2);
+        SHA_NI_SCHEDULE(sched0, sched1, sched2, sched3);
+        SHA_NI_ROUNDS4(sched0, 2);
+        SHA_NI_SCHEDULE(sched1, sched2, sched3, sched0);
+        SHA_NI_ROUNDS4(sched1, 2);
+        SHA_NI_SCHEDULE(sched2, sched3, sched0, sched1);
+        SHA_NI_ROUNDS4(sched2, 2);
+        SHA_NI_SCHEDULE(sched3, sched0, sched1, sched2);
+        SHA_NI_ROUNDS4(sched3, 3);
+        SHA_NI_SCHEDULE(sched0, sched1, sched2, sched3);
+        SHA_NI_ROUNDS4(sched0, 3);
+        SHA_NI_SCHEDULE(sched1, sched2, sched3, sched0);
+        SHA_NI_ROUNDS4(sched1, 3);
+        SHA_NI_SCHEDULE(sched2, sched3, sched0, sched1);
+        SHA_NI_ROUNDS4(sched2, 3);
+        SHA_NI_SCHEDULE(sched3, sched0, sched1, sched2);
+        SHA_NI_ROUNDS4(sched3, 3);
+
+        /* E for the next block is derived from ABCD four rounds ago */
+        e_prev = _mm_sha1nexte_epu32(e_prev, e_orig);
+        abcd = _mm_add_epi32(abcd, abcd_orig);
+    }
+
+    _mm_storeu_si128((__m128i *) &ctx->state[0], _mm_shuffle_epi32(abcd, 0x1B));
+    ctx->state[4] = (uint32_t) _mm_extract_epi32(e_prev, 3);
+
+    return processed;
+}
+
+#undef SHA_NI_ROUNDS4
+#undef SHA_NI_SCHEDULE
+
+#if defined(MBEDTLS_POP_TARGET_PRAGMA)
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#undef MBEDTLS_POP_TARGET_PRAGMA
+#endif
+
+int mbedtls_internal_sha1_process(mbedtls_sha1_context *ctx,
+                                  const unsigned char data[64])
+{
+    if (mbedtls_cpu_has_sha_ni()) {
+        return (mbedtls_internal_sha1_process_many_x86_sha_ni(ctx, data, 64) == 64) ? 0 : -1;
+    } else {
+        return mbedtls_internal_sha1_process_c(ctx, data);
+    }
+}
+#endif /* MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT */
+
 /*
  * SHA-1 process buffer
  */
@@ -269,6 +423,15 @@ int mbedtls_sha1_update(mbedtls_sha1_context *ctx,
         left = 0;
     }
 
+#if defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+    if (ilen >= 64 && mbedtls_cpu_has_sha_ni()) {
+        size_t processed = mbedtls_internal_sha1_process_many_x86_sha_ni(ctx, input, ilen);
+
+        input += processed;
+        ilen  -= processed;
+    }
+#endif
+
     while (ilen >= 64) {
         if ((ret = mbedtls_internal_sha1_process(ctx, input)) != 0) {
             return ret;
@@ -53,6 +53,8 @@
 #if defined(MBEDTLS_SHA256_C) || defined(MBEDTLS_SHA224_C)
 
 #include "mbedtls/sha256.h"
+#include "sha256_internal.h"
+#include "cpu_features.h"
 #include "mbedtls/platform_util.h"
 #include "mbedtls/error.h"
 
@@ -218,6 +220,18 @@ static int mbedtls_a64_crypto_sha256_determine_support(void)
 
 #endif  /* MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT */
 
+#if defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
+#if !defined(MBEDTLS_ARCH_IS_X64) && !defined(MBEDTLS_ARCH_IS_X86)
+/* Silently ignored on other architectures */
+#undef MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT
+#elif defined(MBEDTLS_CPU_HAVE_SHA_NI_DETECTION)
+#include <immintrin.h>
+#else
+#warning "No support for SHA-NI intrinsics found, using C code only"
+#undef MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT
+#endif
+#endif /* MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT */
+
 #if !defined(MBEDTLS_SHA256_ALT)
 
 #define SHA256_BLOCK_SIZE 64
@@ -447,7 +461,110 @@ int mbedtls_internal_sha256_process_a64_crypto(mbedtls_sha256_context *ctx,
 #undef MBEDTLS_POP_TARGET_PRAGMA
 #endif
 
-#if !defined(MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT)
+#if defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
+
+#if defined(MBEDTLS_COMPILER_IS_GCC)
+#pragma GCC push_options
+#pragma GCC target ("sha,ssse3,sse4.1")
+#define MBEDTLS_POP_TARGET_PRAGMA
+#elif defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sha,ssse3,sse4.1"))), apply_to=function)
+#define MBEDTLS_POP_TARGET_PRAGMA
+#endif
+
+/*
+ * Four rounds with SHA-NI: sha256rnds2 performs two rounds, taking the two
+ * message words + constants from the low half of its third operand.
+ */
+#define SHA_NI_ROUNDS4(sched, t)                                        \
+    do                                                                  \
+    {                                                                   \
+        tmp = _mm_add_epi32(sched, _mm_loadu_si128((const __m128i *) &K[t])); \
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, tmp);                  \
+        tmp = _mm_shuffle_epi32(tmp, 0x0E);                             \
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, tmp);                  \
+    } while (0)
+
+/* sched0 = W[t..t+3], given sched0..sched3 = W[t-16..t-1] */
+#define SHA_NI_SCHEDULE(sched0, sched1, sched2, sched3)                 \
+    (sched0) = _mm_sha256msg2_epu32(                                    \
+        _mm_add_epi32(_mm_sha256msg1_epu32(sched0, sched1),             \
+                      _mm_alignr_epi8(sched3, sched2, 4)),              \
+        sched3)
+
+static size_t mbedtls_internal_sha256_process_many_x86_sha_ni(
+    mbedtls_sha256_context *ctx, const uint8_t *msg, size_t len)
+{
+    /* Byte-swaps each 32-bit word */
+    const __m128i bswap = _mm_set_epi64x(0x0C0D0E0F08090A0BLL, 0x0405060700010203LL);
+    __m128i abef, cdgh, tmp;
+    size_t processed = 0;
+
+    /* The instructions want the state as ABEF and CDGH, most significant
+     * word first. */
+    tmp  = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &ctx->state[0]), 0xB1);
+    cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &ctx->state[4]), 0x1B);
+    abef = _mm_alignr_epi8(tmp, cdgh, 8);
+    cdgh = _mm_blend_epi16(cdgh, tmp, 0xF0);
+
+    for (;
+         len >= SHA256_BLOCK_SIZE;
+         processed += SHA256_BLOCK_SIZE,
+         msg += SHA256_BLOCK_SIZE,
+         len -= SHA256_BLOCK_SIZE) {
+        const __m128i abef_orig = abef;
+        const __m128i cdgh_orig = cdgh;
+
+        __m128i sched0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (msg + 16 * 0)), bswap);
+        __m128i sched1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (msg + 16 * 1)), bswap);
+        __m128i sched2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (msg + 16 * 2)), bswap);
+        __m128i sched3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (msg + 16 * 3)), bswap);
+
+        SHA_NI_ROUNDS4(sched0, 0);
+        SHA_NI_ROUNDS4(sched1, 4);
+        SHA_NI_ROUNDS4(sched2, 8);
+        SHA_NI_ROUNDS4(sched3, 12);
+
+        for (int t = 16; t < 64; t += 16) {
+            SHA_NI_SCHEDULE(sched0, sched1, sched2, sched3);
+            SHA_NI_ROUNDS4(sched0, t);
+            SHA_NI_SCHEDULE(sched1, sched2, sched3, sched0);
+            SHA_NI_ROUNDS4(sched1, t + 4);
+            SHA_NI_SCHEDULE(sched2, sched3, sched0, sched1);
+            SHA_NI_ROUNDS4(sched2, t + 8);
+            SHA_NI_SCHEDULE(sched3, sched0, sched1, sched2);
+            SHA_NI_ROUNDS4(sched3, t + 12);
+        }
+
+        abef = _mm_add_epi32(abef, abef_orig);
+        cdgh = _mm_add_epi32(cdgh, cdgh_orig);
+    }
+
+    /* Back to ABCD and EFGH */
+    tmp  = _mm_shuffle_epi32(abef, 0x1B);
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128((__m128i *) &ctx->state[0], _mm_blend_epi16(tmp, cdgh, 0xF0));
+    _mm_storeu_si128((__m128i *) &ctx->state[4], _mm_alignr_epi8(cdgh, tmp, 8));
+
+    return processed;
+}
+
+#undef SHA_NI_ROUNDS4
+#undef SHA_NI_SCHEDULE
+
+#if defined(MBEDTLS_POP_TARGET_PRAGMA)
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#undef MBEDTLS_POP_TARGET_PRAGMA
+#endif
+
+#endif /* MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT */
+
+#if !defined(MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT) && \
+    !defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
 #define mbedtls_internal_sha256_process_many_c mbedtls_internal_sha256_process_many
 #define mbedtls_internal_sha256_process_c      mbedtls_internal_sha256_process
 #endif
@@ -482,10 +599,12 @@ int mbedtls_internal_sha256_process_a64_crypto(mbedtls_sha256_context *ctx,
         (d) += local.temp1; (h) = local.temp1 + local.temp2;        \
     } while (0)
 
-#if defined(MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT)
+#if defined(MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT) || \
+    defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
 /*
  * This function is for internal use only if we are building both C and Armv8
- * versions, otherwise it is renamed to be the public mbedtls_internal_sha256_process()
+ * or SHA-NI versions, otherwise it is renamed to be the public
+ * mbedtls_internal_sha256_process()
  */
 static
 #endif
@@ -639,6 +758,33 @@ int mbedtls_internal_sha256_process(mbedtls_sha256_context *ctx,
 #endif /* MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT */
 
 
+#if defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
+
+static size_t mbedtls_internal_sha256_process_many(mbedtls_sha256_context *ctx,
+                                                   const uint8_t *msg, size_t len)
+{
+    if (mbedtls_cpu_has_sha_ni()) {
+        return mbedtls_internal_sha256_process_many_x86_sha_ni(ctx, msg, len);
+    } else {
+        return mbedtls_internal_sha256_process_many_c(ctx, msg, len);
+    }
+}
+
+int mbedtls_internal_sha256_process(mbedtls_sha256_context *ctx,
+                                    const unsigned char data[SHA256_BLOCK_SIZE])
+{
+    if (mbedtls_cpu_has_sha_ni()) {
+        return (mbedtls_internal_sha256_process_many_x86_sha_ni(ctx, data,
+                                                               SHA256_BLOCK_SIZE) ==
+                SHA256_BLOCK_SIZE) ? 0 : -1;
+    } else {
+        return mbedtls_internal_sha256_process_c(ctx, data);
+    }
+}
+
+#endif /* MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT */
+
+
 /*
  * SHA-256 process buffer
  */
@@ -812,6 +958,252 @@ exit:
     return ret;
 }
 
+#if defined(MBEDTLS_SHA256_C)
+
+/*
+ * The multi-buffer kernel hashes one block of each of eight messages at once,
+ * one message per 32-bit lane of the AVX2 registers. It is compiled with a
+ * target pragma and only used if the CPU and the OS support AVX2.
+ */
+#if defined(MBEDTLS_CPU_HAVE_AVX2_DETECTION) && \
+    !defined(MBEDTLS_SHA256_ALT) && !defined(MBEDTLS_SHA256_PROCESS_ALT)
+#define MBEDTLS_SHA256_MULTI_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(MBEDTLS_SHA256_MULTI_AVX2)
+#if defined(MBEDTLS_COMPILER_IS_GCC)
+#pragma GCC push_options
+#pragma GCC target ("avx2")
+#define MBEDTLS_POP_TARGET_PRAGMA
+#elif defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#define MBEDTLS_POP_TARGET_PRAGMA
+#endif
+
+#define VROTR(x, n)  _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define VS0(x) _mm256_xor_si256(_mm256_xor_si256(VROTR(x, 7), VROTR(x, 18)), _mm256_srli_epi32(x, 3))
+#define VS1(x) _mm256_xor_si256(_mm256_xor_si256(VROTR(x, 17), VROTR(x, 19)), _mm256_srli_epi32(x, 10))
+#define VS2(x) _mm256_xor_si256(_mm256_xor_si256(VROTR(x, 2), VROTR(x, 13)), VROTR(x, 22))
+#define VS3(x) _mm256_xor_si256(_mm256_xor_si256(VROTR(x, 6), VROTR(x, 11)), VROTR(x, 25))
+
+/*
+ * Load 32 bytes from each of the eight blocks and transpose them, so that
+ * W[i] holds big-endian word i of every block.
+ */
+static void sha256_multi_load_avx2(__m256i W[8], const unsigned char *const block[8],
+                                   size_t offset)
+{
+    const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                          12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i r[8], t[8];
+    unsigned int i;
+
+    for (i = 0; i < 8; i++) {
+        r[i] = _mm256_shuffle_epi8(
+            _mm256_loadu_si256((const __m256i *) (block[i] + offset)), bswap);
+    }
+    for (i = 0; i < 8; i += 2) {
+        t[i]     = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (i = 0; i < 8; i += 4) {
+        r[i]     = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        r[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        r[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        r[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (i = 0; i < 4; i++) {
+        W[i]     = _mm256_permute2x128_si256(r[i], r[i + 4], 0x20);
+        W[i + 4] = _mm256_permute2x128_si256(r[i], r[i + 4], 0x31);
+    }
+}
+
+#define VR(t)                                                           \
+    (                                                                   \
+        W[(t) & 15] = _mm256_add_epi32(                                 \
+            _mm256_add_epi32(VS1(W[((t) - 2) & 15]), W[((t) - 7) & 15]), \
+            _mm256_add_epi32(VS0(W[((t) - 15) & 15]), W[(t) & 15]))     \
+    )
+
+#define VP(a, b, c, d, e, f, g, h, x, K)                                \
+    do                                                                  \
+    {                                                                   \
+        temp1 = _mm256_add_epi32(                                       \
+            _mm256_add_epi32(h, VS3(e)),                                \
+            _mm256_add_epi32(                                           \
+                _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g))), \
+                _mm256_add_epi32(_mm256_set1_epi32((int) (K)), x)));    \
+        temp2 = _mm256_add_epi32(                                       \
+            VS2(a),                                                     \
+            _mm256_or_si256(_mm256_and_si256(a, b),                     \
+                            _mm256_and_si256(c, _mm256_or_si256(a, b)))); \
+        (d) = _mm256_add_epi32(d, temp1);                               \
+        (h) = _mm256_add_epi32(temp1, temp2);                           \
+    } while (0)
+
+/**
+ * \brief               Process one block of each of eight messages.
+ *
+ * \param state         The eight states, one per lane: state[i] holds word
+ *                      i of the state of every message.
+ * \param block         Pointers to the 64-byte blocks, one per lane.
+ */
+static void sha256_multi_block_avx2(__m256i state[8], const unsigned char *const block[8])
+{
+    __m256i W[16];
+    __m256i A[8];
+    __m256i temp1, temp2;
+    unsigned int i;
+
+    sha256_multi_load_avx2(W, block, 0);
+    sha256_multi_load_avx2(W + 8, block, 32);
+
+    for (i = 0; i < 8; i++) {
+        A[i] = state[i];
+    }
+
+    for (i = 0; i < 16; i += 8) {
+        VP(A[0], A[1], A[2], A[3], A[4], A[5], A[6], A[7], W[i+0], K[i+0]);
+        VP(A[7], A[0], A[1], A[2], A[3], A[4], A[5], A[6], W[i+1], K[i+1]);
+        VP(A[6], A[7], A[0], A[1], A[2], A[3], A[4], A[5], W[i+2], K[i+2]);
+        VP(A[5], A[6], A[7], A[0], A[1], A[2], A[3], A[4], W[i+3], K[i+3]);
+        VP(A[4], A[5], A[6], A[7], A[0], A[1], A[2], A[3], W[i+4], K[i+4]);
+        VP(A[3], A[4], A[5], A[6], A[7], A[0], A[1], A[2], W[i+5], K[i+5]);
+        VP(A[2], A[3], A[4], A[5], A[6], A[7], A[0], A[1], W[i+6], K[i+6]);
+        VP(A[1], A[2], A[3], A[4], A[5], A[6], A[7], A[0], W[i+7], K[i+7]);
+    }
+
+    for (i = 16; i < 64; i += 8) {
+        VP(A[0], A[1], A[2], A[3], A[4], A[5], A[6], A[7], VR(i+0), K[i+0]);
+        VP(A[7], A[0], A[1], A[2], A[3], A[4], A[5], A[6], VR(i+1), K[i+1]);
+        VP(A[6], A[7], A[0], A[1], A[2], A[3], A[4], A[5], VR(i+2), K[i+2]);
+        VP(A[5], A[6], A[7], A[0], A[1], A[2], A[3], A[4], VR(i+3), K[i+3]);
+        VP(A[4], A[5], A[6], A[7], A[0], A[1], A[2], A[3], VR(i+4), K[i+4]);
+        VP(A[3], A[4], A[5], A[6], A[7], A[0], A[1], A[2], VR(i+5), K[i+5]);
+        VP(A[2], A[3], A[4], A[5], A[6], A[7], A[0], A[1], VR(i+6), K[i+6]);
+        VP(A[1], A[2], A[3], A[4], A[5], A[6], A[7], A[0], VR(i+7), K[i+7]);
+    }
+
+    for (i = 0; i < 8; i++) {
+        state[i] = _mm256_add_epi32(state[i], A[i]);
+    }
+}
+
+/*
+ * Hash up to eight messages of ilen bytes. Missing lanes hash the first
+ * message again and their output is discarded.
+ */
+static void sha256_multi_avx2(const unsigned char *const *input, size_t ilen,
+                              unsigned char *const *output, size_t count)
+{
+    static const uint32_t iv[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+        0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+    };
+    /* The last block or two of each message, with the padding */
+    unsigned char tail[8][2 * SHA256_BLOCK_SIZE];
+    const size_t full_blocks = ilen / SHA256_BLOCK_SIZE;
+    const size_t rem = ilen % SHA256_BLOCK_SIZE;
+    const size_t tail_len = rem < 56 ? SHA256_BLOCK_SIZE : 2 * SHA256_BLOCK_SIZE;
+    const unsigned char *block[8];
+    uint32_t words[8];
+    __m256i state[8];
+    size_t b;
+    unsigned int i, lane;
+
+    memset(tail, 0, sizeof(tail));
+    for (lane = 0; lane < 8; lane++) {
+        const unsigned char *msg = input[lane < count ? lane : 0];
+
+        memcpy(tail[lane], msg + full_blocks * SHA256_BLOCK_SIZE, rem);
+        tail[lane][rem] = 0x80;
+        MBEDTLS_PUT_UINT32_BE((uint32_t) (ilen >> 29), tail[lane], tail_len - 8);
+        MBEDTLS_PUT_UINT32_BE((uint32_t) (ilen << 3), tail[lane], tail_len - 4);
+    }
+
+    for (i = 0; i < 8; i++) {
+        state[i] = _mm256_set1_epi32((int) iv[i]);
+    }
+
+    for (b = 0; b < full_blocks; b++) {
+        for (lane = 0; lane < 8; lane++) {
+            block[lane] = input[lane < count ? lane : 0] + b * SHA256_BLOCK_SIZE;
+        }
+        sha256_multi_block_avx2(state, block);
+    }
+
+    for (b = 0; b < tail_len; b += SHA256_BLOCK_SIZE) {
+        for (lane = 0; lane < 8; lane++) {
+            block[lane] = tail[lane] + b;
+        }
+        sha256_multi_block_avx2(state, block);
+    }
+
+    for (i = 0; i < 8; i++) {
+        _mm256_storeu_si256((__m256i *) words, state[i]);
+        for (lane = 0; lane < count; lane++) {
+            MBEDTLS_PUT_UINT32_BE(words[lane], output[lane], 4 * i);
+        }
+    }
+
+    mbedtls_platform_zeroize(tail, sizeof(tail));
+    mbedtls_platform_zeroize(words, sizeof(words));
+}
+
+#undef VR
+#undef VP
+#undef VROTR
+#undef VS0
+#undef VS1
+#undef VS2
+#undef VS3
+
+#if defined(MBEDTLS_POP_TARGET_PRAGMA)
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#undef MBEDTLS_POP_TARGET_PRAGMA
+#endif
+#endif /* MBEDTLS_SHA256_MULTI_AVX2 */
+
+int mbedtls_sha256_multi(const unsigned char *const *input, size_t ilen,
+                         unsigned char *const *output, size_t count)
+{
+    int ret;
+
+#if defined(MBEDTLS_SHA256_MULTI_AVX2)
+    /* With few messages, hashing them one by one is faster */
+    if (count >= MBEDTLS_SHA256_MULTI_LANES / 2 && mbedtls_cpu_has_avx2()
+#if defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
+        /* SHA-NI hashes messages one by one about as fast */
+        && !mbedtls_cpu_has_sha_ni()
+#endif
+        ) {
+        while (count >= MBEDTLS_SHA256_MULTI_LANES / 2) {
+            size_t n = count < MBEDTLS_SHA256_MULTI_LANES ? count : MBEDTLS_SHA256_MULTI_LANES;
+
+            sha256_multi_avx2(input, ilen, output, n);
+            input += n;
+            output += n;
+            count -= n;
+        }
+    }
+#endif
+
+    for (; count > 0; count--) {
+        if ((ret = mbedtls_sha256(*input++, ilen, *output++, 0)) != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* MBEDTLS_SHA256_C */
+
 #if defined(MBEDTLS_SELF_TEST)
 /*
  * FIPS-180-2 test vectors
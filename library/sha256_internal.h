@@ -0,0 +1,46 @@
+/**
+ * \file sha256_internal.h
+ *
+ * \brief SHA-256 internal interfaces: hashing many messages at once
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+
+#ifndef MBEDTLS_SHA256_INTERNAL_H
+#define MBEDTLS_SHA256_INTERNAL_H
+
+#include "common.h"
+
+#if defined(MBEDTLS_SHA256_C)
+
+/** The number of messages that mbedtls_sha256_multi() may hash in parallel.
+ * Callers get the most out of it by passing multiples of this. */
+#define MBEDTLS_SHA256_MULTI_LANES 8
+
+/**
+ * \brief          Compute the SHA-256 digests of several independent
+ *                 messages of the same length.
+ *
+ *                 The result is the same as calling mbedtls_sha256() on
+ *                 each message in turn, but where the platform supports it
+ *                 (AVX2 on x86-64) up to #MBEDTLS_SHA256_MULTI_LANES
+ *                 messages are hashed at once in SIMD lanes.
+ *
+ * \param input    An array of \p count pointers to the messages, each of
+ *                 which is \p ilen bytes long.
+ * \param ilen     The length of each message in bytes.
+ * \param output   An array of \p count pointers to 32-byte buffers for the
+ *                 digests. An output buffer may not overlap any input.
+ * \param count    The number of messages.
+ *
+ * \return         \c 0 on success.
+ * \return         An error code from mbedtls_sha256() on failure.
+ */
+int mbedtls_sha256_multi(const unsigned char *const *input, size_t ilen,
+                         unsigned char *const *output, size_t count);
+
+#endif /* MBEDTLS_SHA256_C */
+
+#endif /* MBEDTLS_SHA256_INTERNAL_H */
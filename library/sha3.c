@@ -41,6 +41,20 @@
     #define MBEDTLS_SHA3_RHO_UNROLL 1 //no-check-names
 #endif
 
+/*
+ * MBEDTLS_SHA3_LANE_COMPLEMENT selects a fully unrolled permutation that keeps the state in local
+ * variables and stores six of the lanes complemented, which removes most of the NOT operations
+ * from chi. It is much faster than the loop-based permutation but larger, so it is disabled when
+ * optimising for size. When it is disabled, the macros above tune the loop-based permutation.
+ */
+#if !defined(MBEDTLS_SHA3_LANE_COMPLEMENT)
+    #if defined(__OPTIMIZE_SIZE__)
+        #define MBEDTLS_SHA3_LANE_COMPLEMENT 0 //no-check-names
+    #else
+        #define MBEDTLS_SHA3_LANE_COMPLEMENT 1 //no-check-names
+    #endif
+#endif
+
 #include "mbedtls/sha3.h"
 #include "mbedtls/platform_util.h"
 #include "mbedtls/error.h"
@@ -52,6 +66,7 @@
 #endif /* MBEDTLS_SELF_TEST */
 
 #define XOR_BYTE 0x6
+#define XOR_BYTE_SHAKE 0x1f
 
 /* Precomputed masks for the iota transform.
  *
@@ -83,6 +98,7 @@ static const uint8_t iota_r_packed[24] = {
 };
 #undef H
 
+#if MBEDTLS_SHA3_LANE_COMPLEMENT == 0 //no-check-names
 static const uint32_t rho[6] = {
     0x3f022425, 0x1c143a09, 0x2c3d3615, 0x27191713, 0x312b382e, 0x3e030832
 };
@@ -90,6 +106,7 @@ static const uint32_t rho[6] = {
 static const uint32_t pi[6] = {
     0x110b070a, 0x10050312, 0x04181508, 0x0d13170f, 0x0e14020c, 0x01060916
 };
+#endif
 
 #define ROTR64(x, y) (((x) << (64U - (y))) | ((x) >> (y))) // 64-bit rotate right
 #define ABSORB(ctx, idx, v) do { ctx->state[(idx) >> 3] ^= ((uint64_t) (v)) << (((idx) & 0x7) << 3); \
@@ -97,6 +114,181 @@ static const uint32_t pi[6] = {
 #define SQUEEZE(ctx, idx) ((uint8_t) (ctx->state[(idx) >> 3] >> (((idx) & 0x7) << 3)))
 #define SWAP(x, y) do { uint64_t tmp = (x); (x) = (y); (y) = tmp; } while (0)
 
+#if MBEDTLS_SHA3_LANE_COMPLEMENT == 1 //no-check-names
+/* Decompress the mask of a round (see definition of iota_r_packed) */
+#define IOTA(round) (((uint64_t) iota_r_packed[round] & 0x40) << 57 | \
+                     ((uint64_t) iota_r_packed[round] & 0x20) << 26 | \
+                     ((uint64_t) iota_r_packed[round] & 0x10) << 11 | \
+                     ((uint64_t) iota_r_packed[round] & 0x8f))
+
+/* The permutation function.
+ *
+ * Each round computes the new state from a copy of the old one, one row of five lanes at a time:
+ * b holds the row after theta, rho and pi, and chi combines it into the new row. The two copies
+ * a and e swap roles every round.
+ *
+ * Lanes 1, 2, 8, 12, 17 and 20 are stored complemented for the whole permutation (the "lane
+ * complementing transform" of the Keccak implementation overview). Theta, rho and pi only XOR
+ * and rotate, so which lanes enter chi complemented is known in advance, and with this choice
+ * of lanes chi needs a single NOT per row. */
+static void keccak_f1600(mbedtls_sha3_context *ctx)
+{
+    uint64_t a[25], e[25], b[5], c[5], d[5];
+    int i, round;
+
+    for (i = 0; i < 25; i++) {
+        a[i] = ctx->state[i];
+    }
+    a[1] = ~a[1]; a[2] = ~a[2]; a[8] = ~a[8];
+    a[12] = ~a[12]; a[17] = ~a[17]; a[20] = ~a[20];
+
+    for (round = 0; round < 24; round += 2) {
+        c[0] = a[0] ^ a[5] ^ a[10] ^ a[15] ^ a[20];
+        c[1] = a[1] ^ a[6] ^ a[11] ^ a[16] ^ a[21];
+        c[2] = a[2] ^ a[7] ^ a[12] ^ a[17] ^ a[22];
+        c[3] = a[3] ^ a[8] ^ a[13] ^ a[18] ^ a[23];
+        c[4] = a[4] ^ a[9] ^ a[14] ^ a[19] ^ a[24];
+        d[0] = c[4] ^ ROTR64(c[1], 63);
+        d[1] = c[0] ^ ROTR64(c[2], 63);
+        d[2] = c[1] ^ ROTR64(c[3], 63);
+        d[3] = c[2] ^ ROTR64(c[4], 63);
+        d[4] = c[3] ^ ROTR64(c[0], 63);
+
+        b[0] = a[0] ^ d[0];
+        b[1] = ROTR64(a[6] ^ d[1], 20);
+        b[2] = ROTR64(a[12] ^ d[2], 21);
+        b[3] = ROTR64(a[18] ^ d[3], 43);
+        b[4] = ROTR64(a[24] ^ d[4], 50);
+        e[0] = b[0] ^ (b[1] | b[2]);
+        e[1] = b[1] ^ (~b[2] | b[3]);
+        e[2] = b[2] ^ (b[3] & b[4]);
+        e[3] = b[3] ^ (b[4] | b[0]);
+        e[4] = b[4] ^ (b[0] & b[1]);
+        e[0] ^= IOTA(round);
+
+        b[0] = ROTR64(a[3] ^ d[3], 36);
+        b[1] = ROTR64(a[9] ^ d[4], 44);
+        b[2] = ROTR64(a[10] ^ d[0], 61);
+        b[3] = ROTR64(a[16] ^ d[1], 19);
+        b[4] = ROTR64(a[22] ^ d[2], 3);
+        e[5] = b[0] ^ (b[1] | b[2]);
+        e[6] = b[1] ^ (b[2] & b[3]);
+        e[7] = b[2] ^ (b[3] | ~b[4]);
+        e[8] = b[3] ^ (b[4] | b[0]);
+        e[9] = b[4] ^ (b[0] & b[1]);
+
+        b[0] = ROTR64(a[1] ^ d[1], 63);
+        b[1] = ROTR64(a[7] ^ d[2], 58);
+        b[2] = ROTR64(a[13] ^ d[3], 39);
+        b[3] = ROTR64(a[19] ^ d[4], 56);
+        b[4] = ROTR64(a[20] ^ d[0], 46);
+        e[10] = b[0] ^ (b[1] | b[2]);
+        e[11] = b[1] ^ (b[2] & b[3]);
+        e[12] = b[2] ^ (~b[3] & b[4]);
+        e[13] = ~b[3] ^ (b[4] | b[0]);
+        e[14] = b[4] ^ (b[0] & b[1]);
+
+        b[0] = ROTR64(a[4] ^ d[4], 37);
+        b[1] = ROTR64(a[5] ^ d[0], 28);
+        b[2] = ROTR64(a[11] ^ d[1], 54);
+        b[3] = ROTR64(a[17] ^ d[2], 49);
+        b[4] = ROTR64(a[23] ^ d[3], 8);
+        e[15] = b[0] ^ (b[1] & b[2]);
+        e[16] = b[1] ^ (b[2] | b[3]);
+        e[17] = b[2] ^ (~b[3] | b[4]);
+        e[18] = ~b[3] ^ (b[4] & b[0]);
+        e[19] = b[4] ^ (b[0] | b[1]);
+
+        b[0] = ROTR64(a[2] ^ d[2], 2);
+        b[1] = ROTR64(a[8] ^ d[3], 9);
+        b[2] = ROTR64(a[14] ^ d[4], 25);
+        b[3] = ROTR64(a[15] ^ d[0], 23);
+        b[4] = ROTR64(a[21] ^ d[1], 62);
+        e[20] = b[0] ^ (~b[1] & b[2]);
+        e[21] = ~b[1] ^ (b[2] | b[3]);
+        e[22] = b[2] ^ (b[3] & b[4]);
+        e[23] = b[3] ^ (b[4] | b[0]);
+        e[24] = b[4] ^ (b[0] & b[1]);
+
+        c[0] = e[0] ^ e[5] ^ e[10] ^ e[15] ^ e[20];
+        c[1] = e[1] ^ e[6] ^ e[11] ^ e[16] ^ e[21];
+        c[2] = e[2] ^ e[7] ^ e[12] ^ e[17] ^ e[22];
+        c[3] = e[3] ^ e[8] ^ e[13] ^ e[18] ^ e[23];
+        c[4] = e[4] ^ e[9] ^ e[14] ^ e[19] ^ e[24];
+        d[0] = c[4] ^ ROTR64(c[1], 63);
+        d[1] = c[0] ^ ROTR64(c[2], 63);
+        d[2] = c[1] ^ ROTR64(c[3], 63);
+        d[3] = c[2] ^ ROTR64(c[4], 63);
+        d[4] = c[3] ^ ROTR64(c[0], 63);
+
+        b[0] = e[0] ^ d[0];
+        b[1] = ROTR64(e[6] ^ d[1], 20);
+        b[2] = ROTR64(e[12] ^ d[2], 21);
+        b[3] = ROTR64(e[18] ^ d[3], 43);
+        b[4] = ROTR64(e[24] ^ d[4], 50);
+        a[0] = b[0] ^ (b[1] | b[2]);
+        a[1] = b[1] ^ (~b[2] | b[3]);
+        a[2] = b[2] ^ (b[3] & b[4]);
+        a[3] = b[3] ^ (b[4] | b[0]);
+        a[4] = b[4] ^ (b[0] & b[1]);
+        a[0] ^= IOTA(round + 1);
+
+        b[0] = ROTR64(e[3] ^ d[3], 36);
+        b[1] = ROTR64(e[9] ^ d[4], 44);
+        b[2] = ROTR64(e[10] ^ d[0], 61);
+        b[3] = ROTR64(e[16] ^ d[1], 19);
+        b[4] = ROTR64(e[22] ^ d[2], 3);
+        a[5] = b[0] ^ (b[1] | b[2]);
+        a[6] = b[1] ^ (b[2] & b[3]);
+        a[7] = b[2] ^ (b[3] | ~b[4]);
+        a[8] = b[3] ^ (b[4] | b[0]);
+        a[9] = b[4] ^ (b[0] & b[1]);
+
+        b[0] = ROTR64(e[1] ^ d[1], 63);
+        b[1] = ROTR64(e[7] ^ d[2], 58);
+        b[2] = ROTR64(e[13] ^ d[3], 39);
+        b[3] = ROTR64(e[19] ^ d[4], 56);
+        b[4] = ROTR64(e[20] ^ d[0], 46);
+        a[10] = b[0] ^ (b[1] | b[2]);
+        a[11] = b[1] ^ (b[2] & b[3]);
+        a[12] = b[2] ^ (~b[3] & b[4]);
+        a[13] = ~b[3] ^ (b[4] | b[0]);
+        a[14] = b[4] ^ (b[0] & b[1]);
+
+        b[0] = ROTR64(e[4] ^ d[4], 37);
+        b[1] = ROTR64(e[5] ^ d[0], 28);
+        b[2] = ROTR64(e[11] ^ d[1], 54);
+        b[3] = ROTR64(e[17] ^ d[2], 49);
+        b[4] = ROTR64(e[23] ^ d[3], 8);
+        a[15] = b[0] ^ (b[1] & b[2]);
+        a[16] = b[1] ^ (b[2] | b[3]);
+        a[17] = b[2] ^ (~b[3] | b[4]);
+        a[18] = ~b[3] ^ (b[4] & b[0]);
+        a[19] = b[4] ^ (b[0] | b[1]);
+
+        b[0] = ROTR64(e[2] ^ d[2], 2);
+        b[1] = ROTR64(e[8] ^ d[3], 9);
+        b[2] = ROTR64(e[14] ^ d[4], 25);
+        b[3] = ROTR64(e[15] ^ d[0], 23);
+        b[4] = ROTR64(e[21] ^ d[1], 62);
+        a[20] = b[0] ^ (~b[1] & b[2]);
+        a[21] = ~b[1] ^ (b[2] | b[3]);
+        a[22] = b[2] ^ (b[3] & b[4]);
+        a[23] = b[3] ^ (b[4] | b[0]);
+        a[24] = b[4] ^ (b[0] & b[1]);
+    }
+
+    a[1] = ~a[1]; a[2] = ~a[2]; a[8] = ~a[8];
+    a[12] = ~a[12]; a[17] = ~a[17]; a[20] = ~a[20];
+    for (i = 0; i < 25; i++) {
+        ctx->state[i] = a[i];
+    }
+
+    mbedtls_platform_zeroize(a, sizeof(a));
+    mbedtls_platform_zeroize(e, sizeof(e));
+    mbedtls_platform_zeroize(b, sizeof(b));
+}
+#else
 /* The permutation function.  */
 static void keccak_f1600(mbedtls_sha3_context *ctx)
 {
@@ -243,6 +435,7 @@ static void keccak_f1600(mbedtls_sha3_context *ctx)
                  (iota_r_packed[round] & 0x8f));
     }
 }
+#endif /* MBEDTLS_SHA3_LANE_COMPLEMENT */
 
 void mbedtls_sha3_init(mbedtls_sha3_context *ctx)
 {
@@ -286,12 +479,22 @@ int mbedtls_sha3_starts(mbedtls_sha3_context *ctx, mbedtls_sha3_id id)
             ctx->olen = 512 / 8;
             ctx->max_block_size = 576 / 8;
             break;
+        /* The SHAKE functions have no fixed output length: olen is 0 */
+        case MBEDTLS_SHA3_SHAKE128:
+            ctx->olen = 0;
+            ctx->max_block_size = 1344 / 8;
+            break;
+        case MBEDTLS_SHA3_SHAKE256:
+            ctx->olen = 0;
+            ctx->max_block_size = 1088 / 8;
+            break;
         default:
             return MBEDTLS_ERR_SHA3_BAD_INPUT_DATA;
     }
 
     memset(ctx->state, 0, sizeof(ctx->state));
     ctx->index = 0;
+    ctx->squeezing = 0;
 
     return 0;
 }
@@ -303,6 +506,10 @@ int mbedtls_sha3_update(mbedtls_sha3_context *ctx,
                         const uint8_t *input,
                         size_t ilen)
 {
+    if (ctx->squeezing) {
+        return MBEDTLS_ERR_SHA3_BAD_INPUT_DATA;
+    }
+
     if (ilen >= 8) {
         // 8-byte align index
         int align_bytes = 8 - (ctx->index % 8);
@@ -319,6 +526,16 @@ int mbedtls_sha3_update(mbedtls_sha3_context *ctx,
 
         // process input in 8-byte chunks
         while (ilen >= 8) {
+            if (ctx->index == 0 && ilen >= ctx->max_block_size) {
+                // absorb a whole block at once
+                for (size_t i = 0; i < ctx->max_block_size / 8U; i++) {
+                    ctx->state[i] ^= MBEDTLS_GET_UINT64_LE(input, i * 8);
+                }
+                input += ctx->max_block_size;
+                ilen -= ctx->max_block_size;
+                keccak_f1600(ctx);
+                continue;
+            }
             ABSORB(ctx, ctx->index, MBEDTLS_GET_UINT64_LE(input, 0));
             input += 8;
             ilen -= 8;
@@ -339,6 +556,40 @@ int mbedtls_sha3_update(mbedtls_sha3_context *ctx,
     return 0;
 }
 
+/*
+ * Pad the input and permute. Afterwards index counts the bytes squeezed from the current block
+ * and ranges up to max_block_size: the next permutation is only done when more output is needed.
+ */
+static void sha3_start_squeezing(mbedtls_sha3_context *ctx)
+{
+    ABSORB(ctx, ctx->index, ctx->olen > 0 ? XOR_BYTE : XOR_BYTE_SHAKE);
+    ABSORB(ctx, ctx->max_block_size - 1, 0x80);
+    keccak_f1600(ctx);
+    ctx->index = 0;
+    ctx->squeezing = 1;
+}
+
+static void sha3_squeeze(mbedtls_sha3_context *ctx, uint8_t *output, size_t olen)
+{
+    while (olen > 0) {
+        if (ctx->index == ctx->max_block_size) {
+            keccak_f1600(ctx);
+            ctx->index = 0;
+        }
+
+        if ((ctx->index & 0x7) == 0 && olen >= 8) {
+            MBEDTLS_PUT_UINT64_LE(ctx->state[ctx->index >> 3], output, 0);
+            output += 8;
+            olen -= 8;
+            ctx->index += 8;
+        } else {
+            *output++ = SQUEEZE(ctx, ctx->index);
+            olen--;
+            ctx->index++;
+        }
+    }
+}
+
 int mbedtls_sha3_finish(mbedtls_sha3_context *ctx,
                         uint8_t *output, size_t olen)
 {
@@ -353,18 +604,10 @@ int mbedtls_sha3_finish(mbedtls_sha3_context *ctx,
         olen = ctx->olen;
     }
 
-    ABSORB(ctx, ctx->index, XOR_BYTE);
-    ABSORB(ctx, ctx->max_block_size - 1, 0x80);
-    keccak_f1600(ctx);
-    ctx->index = 0;
-
-    while (olen-- > 0) {
-        *output++ = SQUEEZE(ctx, ctx->index);
-
-        if ((ctx->index = (ctx->index + 1) % ctx->max_block_size) == 0) {
-            keccak_f1600(ctx);
-        }
+    if (!ctx->squeezing) {
+        sha3_start_squeezing(ctx);
     }
+    sha3_squeeze(ctx, output, olen);
 
     ret = 0;
 
@@ -373,6 +616,22 @@ exit:
     return ret;
 }
 
+int mbedtls_sha3_squeeze(mbedtls_sha3_context *ctx,
+                         uint8_t *output, size_t olen)
+{
+    /* Only the SHAKE functions have an output stream */
+    if (ctx->olen > 0 || ctx->max_block_size == 0) {
+        return MBEDTLS_ERR_SHA3_BAD_INPUT_DATA;
+    }
+
+    if (!ctx->squeezing) {
+        sha3_start_squeezing(ctx);
+    }
+    sha3_squeeze(ctx, output, olen);
+
+    return 0;
+}
+
 /*
  * output = SHA-3( input buffer )
  */
@@ -5,8 +5,10 @@
  *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
  */
 /*
- * These session callbacks use a simple chained list
- * to store and retrieve the session information.
+ * These session callbacks store the serialized sessions in a hash table
+ * keyed by session ID. The cache is split into MBEDTLS_SSL_CACHE_SHARDS
+ * independently locked partitions, and each partition keeps its entries in
+ * a list ordered by storage time so that eviction is O(1).
  */
 
 #include "common.h"
@@ -21,55 +23,126 @@
 
 #include <string.h>
 
+/* Initial size of a partition's hash table. The table is doubled whenever
+ * the number of entries exceeds the number of buckets. */
+#define SSL_CACHE_MIN_BUCKETS   16
+
 void mbedtls_ssl_cache_init(mbedtls_ssl_cache_context *cache)
 {
+#if defined(MBEDTLS_THREADING_C)
+    size_t i;
+#endif
+
     memset(cache, 0, sizeof(mbedtls_ssl_cache_context));
 
     cache->timeout = MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT;
     cache->max_entries = MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES;
 
 #if defined(MBEDTLS_THREADING_C)
-    mbedtls_mutex_init(&cache->mutex);
+    for (i = 0; i < MBEDTLS_SSL_CACHE_SHARDS; i++) {
+        mbedtls_mutex_init(&cache->shards[i].mutex);
+    }
 #endif
 }
 
-MBEDTLS_CHECK_RETURN_CRITICAL
-static int ssl_cache_find_entry(mbedtls_ssl_cache_context *cache,
-                                unsigned char const *session_id,
-                                size_t session_id_len,
-                                mbedtls_ssl_cache_entry **dst)
+/* FNV-1a. Session IDs are generated at random by the server, so this only
+ * needs to spread them evenly. */
+static uint32_t ssl_cache_hash(unsigned char const *session_id,
+                               size_t session_id_len)
 {
-    int ret = MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
-#if defined(MBEDTLS_HAVE_TIME)
-    mbedtls_time_t t = mbedtls_time(NULL);
-#endif
-    mbedtls_ssl_cache_entry *cur;
+    uint32_t h = 0x811c9dc5;
+    size_t i;
+
+    for (i = 0; i < session_id_len; i++) {
+        h ^= session_id[i];
+        h *= 0x01000193;
+    }
+
+    return h;
+}
+
+static mbedtls_ssl_cache_shard *ssl_cache_get_shard(mbedtls_ssl_cache_context *cache,
+                                                    uint32_t hash)
+{
+    return &cache->shards[hash % MBEDTLS_SSL_CACHE_SHARDS];
+}
+
+/* Bucket index within a shard. Use the bits of the hash that did not
+ * select the shard. */
+static size_t ssl_cache_bucket(const mbedtls_ssl_cache_shard *shard,
+                               uint32_t hash)
+{
+    return (size_t) (hash / MBEDTLS_SSL_CACHE_SHARDS) & (shard->bucket_count - 1);
+}
+
+/* Maximum number of entries in one shard */
+static int ssl_cache_shard_capacity(const mbedtls_ssl_cache_context *cache)
+{
+    return (cache->max_entries + MBEDTLS_SSL_CACHE_SHARDS - 1) /
+           MBEDTLS_SSL_CACHE_SHARDS;
+}
 
-    for (cur = cache->chain; cur != NULL; cur = cur->next) {
 #if defined(MBEDTLS_HAVE_TIME)
-        if (cache->timeout != 0 &&
-            (int) (t - cur->timestamp) > cache->timeout) {
-            continue;
-        }
-#endif
+static int ssl_cache_entry_is_expired(const mbedtls_ssl_cache_context *cache,
+                                      const mbedtls_ssl_cache_entry *entry,
+                                      mbedtls_time_t t)
+{
+    return cache->timeout != 0 &&
+           (int) (t - entry->timestamp) > cache->timeout;
+}
+#endif /* MBEDTLS_HAVE_TIME */
 
-        if (session_id_len != cur->session_id_len ||
-            memcmp(session_id, cur->session_id,
-                   cur->session_id_len) != 0) {
-            continue;
-        }
+/* Return the address of the pointer that points to the entry with the given
+ * ID in its hash bucket, or to the NULL at the end of the bucket if there is
+ * no such entry. This allows the caller to unlink the entry. */
+static mbedtls_ssl_cache_entry **ssl_cache_lookup(mbedtls_ssl_cache_shard *shard,
+                                                  uint32_t hash,
+                                                  unsigned char const *session_id,
+                                                  size_t session_id_len)
+{
+    mbedtls_ssl_cache_entry **p;
 
-        break;
+    if (shard->bucket_count == 0) {
+        return NULL;
     }
 
-    if (cur != NULL) {
-        *dst = cur;
-        ret = 0;
+    for (p = &shard->buckets[ssl_cache_bucket(shard, hash)];
+         *p != NULL; p = &(*p)->next) {
+        if (session_id_len == (*p)->session_id_len &&
+            memcmp(session_id, (*p)->session_id, session_id_len) == 0) {
+            break;
+        }
     }
 
-    return ret;
+    return p;
 }
 
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_cache_find_entry(mbedtls_ssl_cache_context *cache,
+                                mbedtls_ssl_cache_shard *shard,
+                                uint32_t hash,
+                                unsigned char const *session_id,
+                                size_t session_id_len,
+                                mbedtls_ssl_cache_entry ***dst)
+{
+    mbedtls_ssl_cache_entry **p;
+
+    p = ssl_cache_lookup(shard, hash, session_id, session_id_len);
+    if (p == NULL || *p == NULL) {
+        return MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+    }
+
+#if defined(MBEDTLS_HAVE_TIME)
+    if (ssl_cache_entry_is_expired(cache, *p, mbedtls_time(NULL))) {
+        return MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+    }
+#else
+    (void) cache;
+#endif
+
+    *dst = p;
+    return 0;
+}
 
 int mbedtls_ssl_cache_get(void *data,
                           unsigned char const *session_id,
@@ -78,22 +151,25 @@ int mbedtls_ssl_cache_get(void *data,
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     mbedtls_ssl_cache_context *cache = (mbedtls_ssl_cache_context *) data;
-    mbedtls_ssl_cache_entry *entry;
+    uint32_t hash = ssl_cache_hash(session_id, session_id_len);
+    mbedtls_ssl_cache_shard *shard = ssl_cache_get_shard(cache, hash);
+    mbedtls_ssl_cache_entry **entry;
 
 #if defined(MBEDTLS_THREADING_C)
-    if ((ret = mbedtls_mutex_lock(&cache->mutex)) != 0) {
+    if ((ret = mbedtls_mutex_lock(&shard->mutex)) != 0) {
         return ret;
     }
 #endif
 
-    ret = ssl_cache_find_entry(cache, session_id, session_id_len, &entry);
+    ret = ssl_cache_find_entry(cache, shard, hash,
+                               session_id, session_id_len, &entry);
     if (ret != 0) {
         goto exit;
     }
 
     ret = mbedtls_ssl_session_load(session,
-                                   entry->session,
-                                   entry->session_len);
+                                   (*entry)->session,
+                                   (*entry)->session_len);
     if (ret != 0) {
         goto exit;
     }
@@ -102,7 +178,7 @@ int mbedtls_ssl_cache_get(void *data,
 
 exit:
 #if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_unlock(&cache->mutex) != 0) {
+    if (mbedtls_mutex_unlock(&shard->mutex) != 0) {
         ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
     }
 #endif
@@ -126,119 +202,184 @@ static void ssl_cache_entry_zeroize(mbedtls_ssl_cache_entry *entry)
     mbedtls_platform_zeroize(entry, sizeof(mbedtls_ssl_cache_entry));
 }
 
-MBEDTLS_CHECK_RETURN_CRITICAL
-static int ssl_cache_pick_writing_slot(mbedtls_ssl_cache_context *cache,
-                                       unsigned char const *session_id,
-                                       size_t session_id_len,
-                                       mbedtls_ssl_cache_entry **dst)
+/* Remove an entry from the eviction list. */
+static void ssl_cache_list_unlink(mbedtls_ssl_cache_shard *shard,
+                                  mbedtls_ssl_cache_entry *entry)
 {
-#if defined(MBEDTLS_HAVE_TIME)
-    mbedtls_time_t t = mbedtls_time(NULL), oldest = 0;
-#endif /* MBEDTLS_HAVE_TIME */
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        shard->newest = entry->older;
+    }
 
-    mbedtls_ssl_cache_entry *old = NULL;
-    int count = 0;
-    mbedtls_ssl_cache_entry *cur, *last;
-
-    /* Check 1: Is there already an entry with the given session ID?
-     *
-     * If yes, overwrite it.
-     *
-     * If not, `count` will hold the size of the session cache
-     * at the end of this loop, and `last` will point to the last
-     * entry, both of which will be used later. */
-
-    last = NULL;
-    for (cur = cache->chain; cur != NULL; cur = cur->next) {
-        count++;
-        if (session_id_len == cur->session_id_len &&
-            memcmp(session_id, cur->session_id, cur->session_id_len) == 0) {
-            goto found;
-        }
-        last = cur;
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        shard->oldest = entry->newer;
     }
 
-    /* Check 2: Is there an outdated entry in the cache?
-     *
-     * If so, overwrite it.
-     *
-     * If not, remember the oldest entry in `old` for later.
-     */
+    entry->newer = NULL;
+    entry->older = NULL;
+}
 
-#if defined(MBEDTLS_HAVE_TIME)
-    for (cur = cache->chain; cur != NULL; cur = cur->next) {
-        if (cache->timeout != 0 &&
-            (int) (t - cur->timestamp) > cache->timeout) {
-            goto found;
-        }
+/* Insert an entry at the head (newest end) of the eviction list. */
+static void ssl_cache_list_push(mbedtls_ssl_cache_shard *shard,
+                                mbedtls_ssl_cache_entry *entry)
+{
+    entry->newer = NULL;
+    entry->older = shard->newest;
 
-        if (oldest == 0 || cur->timestamp < oldest) {
-            oldest = cur->timestamp;
-            old = cur;
-        }
+    if (shard->newest != NULL) {
+        shard->newest->newer = entry;
+    } else {
+        shard->oldest = entry;
     }
-#endif /* MBEDTLS_HAVE_TIME */
 
-    /* Check 3: Is there free space in the cache? */
+    shard->newest = entry;
+}
 
-    if (count < cache->max_entries) {
-        /* Create new entry */
-        cur = mbedtls_calloc(1, sizeof(mbedtls_ssl_cache_entry));
-        if (cur == NULL) {
-            return MBEDTLS_ERR_SSL_ALLOC_FAILED;
-        }
+/* Remove an entry from its hash bucket and from the eviction list, and free
+ * it. \p link is the pointer to the entry in its hash bucket. */
+static void ssl_cache_remove_entry(mbedtls_ssl_cache_shard *shard,
+                                   mbedtls_ssl_cache_entry **link)
+{
+    mbedtls_ssl_cache_entry *entry = *link;
 
-        /* Append to the end of the linked list. */
-        if (last == NULL) {
-            cache->chain = cur;
-        } else {
-            last->next = cur;
-        }
+    *link = entry->next;
+    ssl_cache_list_unlink(shard, entry);
+    shard->entries--;
 
-        goto found;
+    ssl_cache_entry_zeroize(entry);
+    mbedtls_free(entry);
+}
+
+/* Remove the oldest entry of a shard. */
+static void ssl_cache_evict_oldest(mbedtls_ssl_cache_shard *shard)
+{
+    mbedtls_ssl_cache_entry *entry = shard->oldest;
+    mbedtls_ssl_cache_entry **link;
+
+    link = ssl_cache_lookup(shard,
+                            ssl_cache_hash(entry->session_id,
+                                           entry->session_id_len),
+                            entry->session_id, entry->session_id_len);
+    ssl_cache_remove_entry(shard, link);
+}
+
+/* Make sure the hash table has room for one more entry. Grow it if
+ * possible, but only fail if there is no table at all: a table that
+ * could not be grown still works, with longer chains. */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_cache_reserve(mbedtls_ssl_cache_shard *shard)
+{
+    mbedtls_ssl_cache_entry **buckets, *cur, *next;
+    size_t bucket_count, i, b;
+
+    if ((size_t) shard->entries < shard->bucket_count) {
+        return 0;
+    }
+
+    bucket_count = shard->bucket_count == 0 ?
+                   SSL_CACHE_MIN_BUCKETS : 2 * shard->bucket_count;
+    buckets = mbedtls_calloc(bucket_count, sizeof(*buckets));
+    if (buckets == NULL) {
+        return shard->bucket_count == 0 ? MBEDTLS_ERR_SSL_ALLOC_FAILED : 0;
+    }
+
+    for (i = 0; i < shard->bucket_count; i++) {
+        for (cur = shard->buckets[i]; cur != NULL; cur = next) {
+            next = cur->next;
+            b = (size_t) (ssl_cache_hash(cur->session_id, cur->session_id_len) /
+                          MBEDTLS_SSL_CACHE_SHARDS) & (bucket_count - 1);
+            cur->next = buckets[b];
+            buckets[b] = cur;
+        }
     }
 
-    /* Last resort: The cache is full and doesn't contain any outdated
-     * elements. In this case, we evict the oldest one, judged by timestamp
-     * (if present) or cache-order. */
+    mbedtls_free(shard->buckets);
+    shard->buckets = buckets;
+    shard->bucket_count = bucket_count;
 
+    return 0;
+}
+
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_cache_pick_writing_slot(mbedtls_ssl_cache_context *cache,
+                                       mbedtls_ssl_cache_shard *shard,
+                                       uint32_t hash,
+                                       unsigned char const *session_id,
+                                       size_t session_id_len,
+                                       mbedtls_ssl_cache_entry **dst)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
 #if defined(MBEDTLS_HAVE_TIME)
-    if (old == NULL) {
+    mbedtls_time_t t = mbedtls_time(NULL);
+#endif /* MBEDTLS_HAVE_TIME */
+    int capacity = ssl_cache_shard_capacity(cache);
+    mbedtls_ssl_cache_entry **link;
+    mbedtls_ssl_cache_entry *cur;
+
+    if (capacity == 0) {
         /* This should only happen on an ill-configured cache
          * with max_entries == 0. */
         return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
     }
-#else /* MBEDTLS_HAVE_TIME */
-    /* Reuse first entry in chain, but move to last place. */
-    if (cache->chain == NULL) {
-        /* This should never happen */
-        return MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    /* Is there already an entry with the given session ID?
+     * If yes, overwrite it. */
+    link = ssl_cache_lookup(shard, hash, session_id, session_id_len);
+    if (link != NULL && *link != NULL) {
+        cur = *link;
+        ssl_cache_list_unlink(shard, cur);
+        goto found;
     }
 
-    old = cache->chain;
-    cache->chain = old->next;
-    old->next = NULL;
-    last->next = old;
+    /* Drop outdated entries. They are all at the old end of the list. */
+#if defined(MBEDTLS_HAVE_TIME)
+    while (shard->oldest != NULL &&
+           ssl_cache_entry_is_expired(cache, shard->oldest, t)) {
+        ssl_cache_evict_oldest(shard);
+    }
 #endif /* MBEDTLS_HAVE_TIME */
 
-    /* Now `old` points to the oldest entry to be overwritten. */
-    cur = old;
+    /* If the shard is full, evict the oldest entry. The limit may have
+     * been lowered since the entries were stored, hence the loop. */
+    while (shard->entries >= capacity) {
+        ssl_cache_evict_oldest(shard);
+    }
+
+    ret = ssl_cache_reserve(shard);
+    if (ret != 0) {
+        return ret;
+    }
+
+    cur = mbedtls_calloc(1, sizeof(mbedtls_ssl_cache_entry));
+    if (cur == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    link = &shard->buckets[ssl_cache_bucket(shard, hash)];
+    cur->next = *link;
+    *link = cur;
+    shard->entries++;
 
 found:
 
     /* If we're reusing an entry, free it first. */
     if (cur->session != NULL) {
-        /* `ssl_cache_entry_zeroize` would break the chain,
-         * so we reuse `old` to record `next` temporarily. */
-        old = cur->next;
+        /* `ssl_cache_entry_zeroize` would break the bucket chain,
+         * so we record `next` temporarily. */
+        mbedtls_ssl_cache_entry *next = cur->next;
         ssl_cache_entry_zeroize(cur);
-        cur->next = old;
+        cur->next = next;
     }
 
 #if defined(MBEDTLS_HAVE_TIME)
     cur->timestamp = t;
 #endif
 
+    ssl_cache_list_push(shard, cur);
+
     *dst = cur;
     return 0;
 }
@@ -250,35 +391,27 @@ int mbedtls_ssl_cache_set(void *data,
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     mbedtls_ssl_cache_context *cache = (mbedtls_ssl_cache_context *) data;
+    uint32_t hash;
+    mbedtls_ssl_cache_shard *shard;
     mbedtls_ssl_cache_entry *cur;
 
     size_t session_serialized_len = 0;
     unsigned char *session_serialized = NULL;
 
-#if defined(MBEDTLS_THREADING_C)
-    if ((ret = mbedtls_mutex_lock(&cache->mutex)) != 0) {
-        return ret;
-    }
-#endif
-
-    ret = ssl_cache_pick_writing_slot(cache,
-                                      session_id, session_id_len,
-                                      &cur);
-    if (ret != 0) {
-        goto exit;
+    if (session_id_len > sizeof(cur->session_id)) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
-    /* Check how much space we need to serialize the session
-     * and allocate a sufficiently large buffer. */
+    /* Serialize the session before taking the lock. First check how much
+     * space we need and allocate a sufficiently large buffer. */
     ret = mbedtls_ssl_session_save(session, NULL, 0, &session_serialized_len);
     if (ret != MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
-        goto exit;
+        return ret;
     }
 
     session_serialized = mbedtls_calloc(1, session_serialized_len);
     if (session_serialized == NULL) {
-        ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
-        goto exit;
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
     }
 
     /* Now serialize the session into the allocated buffer. */
@@ -287,13 +420,27 @@ int mbedtls_ssl_cache_set(void *data,
                                    session_serialized_len,
                                    &session_serialized_len);
     if (ret != 0) {
-        goto exit;
+        mbedtls_zeroize_and_free(session_serialized, session_serialized_len);
+        return ret;
     }
 
-    if (session_id_len > sizeof(cur->session_id)) {
-        ret = MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    hash = ssl_cache_hash(session_id, session_id_len);
+    shard = ssl_cache_get_shard(cache, hash);
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&shard->mutex)) != 0) {
+        mbedtls_zeroize_and_free(session_serialized, session_serialized_len);
+        return ret;
+    }
+#endif
+
+    ret = ssl_cache_pick_writing_slot(cache, shard, hash,
+                                      session_id, session_id_len,
+                                      &cur);
+    if (ret != 0) {
         goto exit;
     }
+
     cur->session_id_len = session_id_len;
     memcpy(cur->session_id, session_id, session_id_len);
 
@@ -305,7 +452,7 @@ int mbedtls_ssl_cache_set(void *data,
 
 exit:
 #if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_unlock(&cache->mutex) != 0) {
+    if (mbedtls_mutex_unlock(&shard->mutex) != 0) {
         ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
     }
 #endif
@@ -324,42 +471,30 @@ int mbedtls_ssl_cache_remove(void *data,
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     mbedtls_ssl_cache_context *cache = (mbedtls_ssl_cache_context *) data;
-    mbedtls_ssl_cache_entry *entry;
-    mbedtls_ssl_cache_entry *prev;
+    uint32_t hash = ssl_cache_hash(session_id, session_id_len);
+    mbedtls_ssl_cache_shard *shard = ssl_cache_get_shard(cache, hash);
+    mbedtls_ssl_cache_entry **entry;
 
 #if defined(MBEDTLS_THREADING_C)
-    if ((ret = mbedtls_mutex_lock(&cache->mutex)) != 0) {
+    if ((ret = mbedtls_mutex_lock(&shard->mutex)) != 0) {
         return ret;
     }
 #endif
 
-    ret = ssl_cache_find_entry(cache, session_id, session_id_len, &entry);
+    ret = ssl_cache_find_entry(cache, shard, hash,
+                               session_id, session_id_len, &entry);
     /* No valid entry found, exit with success */
     if (ret != 0) {
         ret = 0;
         goto exit;
     }
 
-    /* Now we remove the entry from the chain */
-    if (entry == cache->chain) {
-        cache->chain = entry->next;
-        goto free;
-    }
-    for (prev = cache->chain; prev->next != NULL; prev = prev->next) {
-        if (prev->next == entry) {
-            prev->next = entry->next;
-            break;
-        }
-    }
-
-free:
-    ssl_cache_entry_zeroize(entry);
-    mbedtls_free(entry);
+    ssl_cache_remove_entry(shard, entry);
     ret = 0;
 
 exit:
 #if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_unlock(&cache->mutex) != 0) {
+    if (mbedtls_mutex_unlock(&shard->mutex) != 0) {
         ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
     }
 #endif
@@ -389,22 +524,33 @@ void mbedtls_ssl_cache_set_max_entries(mbedtls_ssl_cache_context *cache, int max
 
 void mbedtls_ssl_cache_free(mbedtls_ssl_cache_context *cache)
 {
+    mbedtls_ssl_cache_shard *shard;
     mbedtls_ssl_cache_entry *cur, *prv;
+    size_t i;
 
-    cur = cache->chain;
+    for (i = 0; i < MBEDTLS_SSL_CACHE_SHARDS; i++) {
+        shard = &cache->shards[i];
+        cur = shard->newest;
 
-    while (cur != NULL) {
-        prv = cur;
-        cur = cur->next;
+        while (cur != NULL) {
+            prv = cur;
+            cur = cur->older;
 
-        ssl_cache_entry_zeroize(prv);
-        mbedtls_free(prv);
-    }
+            ssl_cache_entry_zeroize(prv);
+            mbedtls_free(prv);
+        }
+
+        mbedtls_free(shard->buckets);
 
 #if defined(MBEDTLS_THREADING_C)
-    mbedtls_mutex_free(&cache->mutex);
+        mbedtls_mutex_free(&shard->mutex);
 #endif
-    cache->chain = NULL;
+        shard->buckets = NULL;
+        shard->bucket_count = 0;
+        shard->entries = 0;
+        shard->newest = NULL;
+        shard->oldest = NULL;
+    }
 }
 
 #endif /* MBEDTLS_SSL_CACHE_C */
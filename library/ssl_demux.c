@@ -0,0 +1,498 @@
+/*
+ *  DTLS server demultiplexer
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+/*
+ * Every peer is in up to three hash tables: by address, by connection ID
+ * and by SSL context. Addresses are chosen by the network, so they are
+ * hashed with HalfSipHash-2-4 under a secret 64-bit key: without the key, an
+ * attacker cannot pick addresses that fall into the same bucket. Connection
+ * IDs are drawn at random by us and SSL contexts are pointers, but hashing
+ * them the same way costs little.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_SSL_DEMUX_C)
+
+#include "mbedtls/platform.h"
+#include "mbedtls/platform_util.h"
+
+#include "mbedtls/ssl_demux.h"
+#include "ssl_misc.h"
+#include "mbedtls/error.h"
+
+#include <string.h>
+
+/* Initial size of the hash tables. They are doubled whenever the number of
+ * peers exceeds the number of buckets. */
+#define SSL_DEMUX_MIN_BUCKETS   16
+
+/* DTLS 1.2 record header up to the CID: type, version, epoch, sequence */
+#define SSL_DEMUX_CID_OFFSET    11
+
+/* Number of attempts at drawing an unused CID. With at least 4 random
+ * bytes, failing them all means the RNG is broken. */
+#define SSL_DEMUX_CID_TRIES     8
+
+void mbedtls_ssl_demux_init(mbedtls_ssl_demux_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_ssl_demux_context));
+}
+
+int mbedtls_ssl_demux_setup(mbedtls_ssl_demux_context *ctx,
+                            size_t cid_len,
+                            mbedtls_f_rng_t *f_rng,
+                            void *p_rng)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    unsigned char key[8];
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    if (cid_len > MBEDTLS_SSL_CID_IN_LEN_MAX) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+#else
+    if (cid_len != 0) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+#endif
+
+    if ((ret = f_rng(p_rng, key, sizeof(key))) != 0) {
+        return ret;
+    }
+
+    ctx->key[0] = MBEDTLS_GET_UINT32_LE(key, 0);
+    ctx->key[1] = MBEDTLS_GET_UINT32_LE(key, 4);
+    mbedtls_platform_zeroize(key, sizeof(key));
+    ctx->cid_len = cid_len;
+    ctx->f_rng = f_rng;
+    ctx->p_rng = p_rng;
+
+    return 0;
+}
+
+#define SSL_DEMUX_ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define SSL_DEMUX_SIPROUND(v0, v1, v2, v3)                          \
+    do {                                                            \
+        (v0) += (v1); (v1) = SSL_DEMUX_ROTL(v1, 5);  (v1) ^= (v0);  \
+        (v0) = SSL_DEMUX_ROTL(v0, 16);                              \
+        (v2) += (v3); (v3) = SSL_DEMUX_ROTL(v3, 8);  (v3) ^= (v2);  \
+        (v0) += (v3); (v3) = SSL_DEMUX_ROTL(v3, 7);  (v3) ^= (v0);  \
+        (v2) += (v1); (v1) = SSL_DEMUX_ROTL(v1, 13); (v1) ^= (v2);  \
+        (v2) = SSL_DEMUX_ROTL(v2, 16);                              \
+    } while (0)
+
+/* HalfSipHash-2-4 with a 32-bit output, keyed with ctx->key */
+static uint32_t ssl_demux_hash(const mbedtls_ssl_demux_context *ctx,
+                               const unsigned char *buf, size_t len)
+{
+    uint32_t v0 = ctx->key[0];
+    uint32_t v1 = ctx->key[1];
+    uint32_t v2 = 0x6c796765 ^ ctx->key[0];
+    uint32_t v3 = 0x74656462 ^ ctx->key[1];
+    uint32_t m, b = (uint32_t) len << 24;
+
+    for (; len >= 4; buf += 4, len -= 4) {
+        m = MBEDTLS_GET_UINT32_LE(buf, 0);
+        v3 ^= m;
+        SSL_DEMUX_SIPROUND(v0, v1, v2, v3);
+        SSL_DEMUX_SIPROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    switch (len) {
+        case 3: b |= (uint32_t) buf[2] << 16; /* fall through */
+        case 2: b |= (uint32_t) buf[1] << 8;  /* fall through */
+        case 1: b |= (uint32_t) buf[0];
+            break;
+        default:
+            break;
+    }
+
+    v3 ^= b;
+    SSL_DEMUX_SIPROUND(v0, v1, v2, v3);
+    SSL_DEMUX_SIPROUND(v0, v1, v2, v3);
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    SSL_DEMUX_SIPROUND(v0, v1, v2, v3);
+    SSL_DEMUX_SIPROUND(v0, v1, v2, v3);
+    SSL_DEMUX_SIPROUND(v0, v1, v2, v3);
+    SSL_DEMUX_SIPROUND(v0, v1, v2, v3);
+
+    return v1 ^ v3;
+}
+
+static size_t ssl_demux_addr_bucket(const mbedtls_ssl_demux_context *ctx,
+                                    const unsigned char *addr, size_t addr_len,
+                                    size_t bucket_count)
+{
+    return (size_t) ssl_demux_hash(ctx, addr, addr_len) & (bucket_count - 1);
+}
+
+static size_t ssl_demux_ssl_bucket(const mbedtls_ssl_demux_context *ctx,
+                                   const mbedtls_ssl_context *ssl,
+                                   size_t bucket_count)
+{
+    return (size_t) ssl_demux_hash(ctx, (const unsigned char *) &ssl,
+                                   sizeof(ssl)) & (bucket_count - 1);
+}
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+static size_t ssl_demux_cid_bucket(const mbedtls_ssl_demux_context *ctx,
+                                   const unsigned char *cid,
+                                   size_t bucket_count)
+{
+    return (size_t) ssl_demux_hash(ctx, cid, ctx->cid_len) & (bucket_count - 1);
+}
+#endif /* MBEDTLS_SSL_DTLS_CONNECTION_ID */
+
+static mbedtls_ssl_demux_entry **ssl_demux_find_addr(mbedtls_ssl_demux_context *ctx,
+                                                     const unsigned char *addr,
+                                                     size_t addr_len)
+{
+    mbedtls_ssl_demux_entry **p;
+
+    if (ctx->bucket_count == 0 || addr_len == 0) {
+        return NULL;
+    }
+
+    for (p = &ctx->by_addr[ssl_demux_addr_bucket(ctx, addr, addr_len, ctx->bucket_count)];
+         *p != NULL; p = &(*p)->next_addr) {
+        if ((*p)->addr_len == addr_len && memcmp((*p)->addr, addr, addr_len) == 0) {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+static mbedtls_ssl_demux_entry **ssl_demux_find_cid(mbedtls_ssl_demux_context *ctx,
+                                                    const unsigned char *cid)
+{
+    mbedtls_ssl_demux_entry **p;
+
+    if (ctx->bucket_count == 0) {
+        return NULL;
+    }
+
+    for (p = &ctx->by_cid[ssl_demux_cid_bucket(ctx, cid, ctx->bucket_count)];
+         *p != NULL; p = &(*p)->next_cid) {
+        if (memcmp((*p)->cid, cid, ctx->cid_len) == 0) {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+#endif /* MBEDTLS_SSL_DTLS_CONNECTION_ID */
+
+static mbedtls_ssl_demux_entry **ssl_demux_find_ssl(mbedtls_ssl_demux_context *ctx,
+                                                    const mbedtls_ssl_context *ssl)
+{
+    mbedtls_ssl_demux_entry **p;
+
+    if (ctx->bucket_count == 0) {
+        return NULL;
+    }
+
+    for (p = &ctx->by_ssl[ssl_demux_ssl_bucket(ctx, ssl, ctx->bucket_count)];
+         *p != NULL; p = &(*p)->next_ssl) {
+        if ((*p)->ssl == ssl) {
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+/* Link an entry into the tables of the given size. */
+static void ssl_demux_link(const mbedtls_ssl_demux_context *ctx,
+                           mbedtls_ssl_demux_entry **by_addr,
+                           mbedtls_ssl_demux_entry **by_cid,
+                           mbedtls_ssl_demux_entry **by_ssl,
+                           size_t bucket_count,
+                           mbedtls_ssl_demux_entry *entry)
+{
+    size_t b;
+
+    if (entry->addr_len != 0) {
+        b = ssl_demux_addr_bucket(ctx, entry->addr, entry->addr_len, bucket_count);
+        entry->next_addr = by_addr[b];
+        by_addr[b] = entry;
+    }
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    if (ctx->cid_len != 0) {
+        b = ssl_demux_cid_bucket(ctx, entry->cid, bucket_count);
+        entry->next_cid = by_cid[b];
+        by_cid[b] = entry;
+    }
+#else
+    (void) by_cid;
+#endif
+
+    b = ssl_demux_ssl_bucket(ctx, entry->ssl, bucket_count);
+    entry->next_ssl = by_ssl[b];
+    by_ssl[b] = entry;
+}
+
+/* Make sure the hash tables have room for one more entry. As in the
+ * session cache, only fail if there is no table at all: tables that could
+ * not be grown still work, with longer chains. */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_demux_reserve(mbedtls_ssl_demux_context *ctx)
+{
+    mbedtls_ssl_demux_entry **tables, *cur, *next;
+    size_t bucket_count, i;
+
+    if (ctx->entries < ctx->bucket_count) {
+        return 0;
+    }
+
+    bucket_count = ctx->bucket_count == 0 ?
+                   SSL_DEMUX_MIN_BUCKETS : 2 * ctx->bucket_count;
+    tables = mbedtls_calloc(3 * bucket_count, sizeof(*tables));
+    if (tables == NULL) {
+        return ctx->bucket_count == 0 ? MBEDTLS_ERR_SSL_ALLOC_FAILED : 0;
+    }
+
+    /* Every entry is in the context table, so walking it visits them all */
+    for (i = 0; i < ctx->bucket_count; i++) {
+        for (cur = ctx->by_ssl[i]; cur != NULL; cur = next) {
+            next = cur->next_ssl;
+            ssl_demux_link(ctx, tables, tables + bucket_count, tables + 2 * bucket_count,
+                           bucket_count, cur);
+        }
+    }
+
+    /* The three tables share one allocation, starting at by_addr */
+    mbedtls_free(ctx->by_addr);
+    ctx->by_addr = tables;
+    ctx->by_cid = tables + bucket_count;
+    ctx->by_ssl = tables + 2 * bucket_count;
+    ctx->bucket_count = bucket_count;
+
+    return 0;
+}
+
+static void ssl_demux_unlink_addr(mbedtls_ssl_demux_context *ctx,
+                                  mbedtls_ssl_demux_entry *entry)
+{
+    mbedtls_ssl_demux_entry **p;
+
+    p = ssl_demux_find_addr(ctx, entry->addr, entry->addr_len);
+    if (p != NULL) {
+        *p = entry->next_addr;
+    }
+    entry->addr_len = 0;
+}
+
+int mbedtls_ssl_demux_add(mbedtls_ssl_demux_context *ctx,
+                          mbedtls_ssl_context *ssl,
+                          void *p_user,
+                          const unsigned char *addr, size_t addr_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_demux_entry *entry;
+
+    if (addr_len == 0 || addr_len > MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN ||
+        ssl_demux_find_addr(ctx, addr, addr_len) != NULL ||
+        ssl_demux_find_ssl(ctx, ssl) != NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    entry = mbedtls_calloc(1, sizeof(mbedtls_ssl_demux_entry));
+    if (entry == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    entry->ssl = ssl;
+    entry->p_user = p_user;
+    memcpy(entry->addr, addr, addr_len);
+    entry->addr_len = addr_len;
+
+    ret = ssl_demux_reserve(ctx);
+    if (ret != 0) {
+        goto exit;
+    }
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    if (ctx->cid_len != 0) {
+        int tries = 0;
+
+        do {
+            if (++tries > SSL_DEMUX_CID_TRIES) {
+                ret = MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+                goto exit;
+            }
+            ret = ctx->f_rng(ctx->p_rng, entry->cid, ctx->cid_len);
+            if (ret != 0) {
+                goto exit;
+            }
+        } while (ssl_demux_find_cid(ctx, entry->cid) != NULL);
+
+        ret = mbedtls_ssl_set_cid(ssl, MBEDTLS_SSL_CID_ENABLED, entry->cid, ctx->cid_len);
+        if (ret != 0) {
+            goto exit;
+        }
+    }
+#endif /* MBEDTLS_SSL_DTLS_CONNECTION_ID */
+
+    ssl_demux_link(ctx, ctx->by_addr, ctx->by_cid, ctx->by_ssl, ctx->bucket_count, entry);
+    ctx->entries++;
+    entry = NULL;
+    ret = 0;
+
+exit:
+    mbedtls_free(entry);
+    return ret;
+}
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+/*
+ * A record with our CID came from a new address. Move the peer there if
+ * the record is authentic and fresh.
+ */
+static int ssl_demux_rebind(mbedtls_ssl_demux_context *ctx,
+                            mbedtls_ssl_demux_entry *entry,
+                            const unsigned char *buf, size_t len,
+                            const unsigned char *addr, size_t addr_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_demux_entry **p;
+    unsigned char *copy;
+
+    if (addr_len == 0 || addr_len > MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    /* mbedtls_ssl_check_record() decrypts in place and wipes the buffer */
+    copy = mbedtls_calloc(1, len);
+    if (copy == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    memcpy(copy, buf, len);
+    ret = mbedtls_ssl_check_record(entry->ssl, copy, len);
+    mbedtls_free(copy);
+    if (ret != 0) {
+        return ret;
+    }
+
+    /* Whoever had this address before has moved on */
+    p = ssl_demux_find_addr(ctx, addr, addr_len);
+    if (p != NULL) {
+        ssl_demux_unlink_addr(ctx, *p);
+    }
+
+    ssl_demux_unlink_addr(ctx, entry);
+    memcpy(entry->addr, addr, addr_len);
+    entry->addr_len = addr_len;
+    p = &ctx->by_addr[ssl_demux_addr_bucket(ctx, addr, addr_len, ctx->bucket_count)];
+    entry->next_addr = *p;
+    *p = entry;
+
+    return 0;
+}
+#endif /* MBEDTLS_SSL_DTLS_CONNECTION_ID */
+
+int mbedtls_ssl_demux_lookup(mbedtls_ssl_demux_context *ctx,
+                             const unsigned char *buf, size_t len,
+                             const unsigned char *addr, size_t addr_len,
+                             void **p_user)
+{
+    mbedtls_ssl_demux_entry **p;
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    if (ctx->cid_len != 0 && len >= SSL_DEMUX_CID_OFFSET + ctx->cid_len + 2 &&
+        buf[0] == MBEDTLS_SSL_MSG_CID) {
+        int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+        p = ssl_demux_find_cid(ctx, buf + SSL_DEMUX_CID_OFFSET);
+        if (p == NULL) {
+            return MBEDTLS_ERR_SSL_DEMUX_ENTRY_NOT_FOUND;
+        }
+
+        if ((*p)->addr_len != addr_len || memcmp((*p)->addr, addr, addr_len) != 0) {
+            ret = ssl_demux_rebind(ctx, *p, buf, len, addr, addr_len);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+
+        *p_user = (*p)->p_user;
+        return 0;
+    }
+#else
+    (void) buf;
+    (void) len;
+#endif /* MBEDTLS_SSL_DTLS_CONNECTION_ID */
+
+    p = ssl_demux_find_addr(ctx, addr, addr_len);
+    if (p == NULL) {
+        return MBEDTLS_ERR_SSL_DEMUX_ENTRY_NOT_FOUND;
+    }
+
+    *p_user = (*p)->p_user;
+    return 0;
+}
+
+int mbedtls_ssl_demux_remove(mbedtls_ssl_demux_context *ctx,
+                             const mbedtls_ssl_context *ssl)
+{
+    mbedtls_ssl_demux_entry **p, *entry;
+
+    p = ssl_demux_find_ssl(ctx, ssl);
+    if (p == NULL) {
+        return MBEDTLS_ERR_SSL_DEMUX_ENTRY_NOT_FOUND;
+    }
+    entry = *p;
+    *p = entry->next_ssl;
+
+    if (entry->addr_len != 0) {
+        ssl_demux_unlink_addr(ctx, entry);
+    }
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    if (ctx->cid_len != 0) {
+        p = ssl_demux_find_cid(ctx, entry->cid);
+        if (p != NULL) {
+            *p = entry->next_cid;
+        }
+    }
+#endif
+
+    ctx->entries--;
+    mbedtls_platform_zeroize(entry, sizeof(mbedtls_ssl_demux_entry));
+    mbedtls_free(entry);
+
+    return 0;
+}
+
+void mbedtls_ssl_demux_free(mbedtls_ssl_demux_context *ctx)
+{
+    mbedtls_ssl_demux_entry *cur, *next;
+    size_t i;
+
+    if (ctx == NULL) {
+        return;
+    }
+
+    for (i = 0; i < ctx->bucket_count; i++) {
+        for (cur = ctx->by_ssl[i]; cur != NULL; cur = next) {
+            next = cur->next_ssl;
+            mbedtls_platform_zeroize(cur, sizeof(mbedtls_ssl_demux_entry));
+            mbedtls_free(cur);
+        }
+    }
+
+    mbedtls_free(ctx->by_addr);
+    mbedtls_platform_zeroize(ctx, sizeof(mbedtls_ssl_demux_context));
+}
+
+#endif /* MBEDTLS_SSL_DEMUX_C */
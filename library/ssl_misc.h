@@ -61,6 +61,15 @@
 #define MBEDTLS_SSL_ECP_RESTARTABLE_ENABLED
 #endif
 
+/* Shorthand for keeping pre-keyed AEAD contexts in the transform: the
+ * record layer then skips the PSA key lookup and key schedule per record.
+ * This needs the PSA core to be built into the library. */
+#if defined(MBEDTLS_USE_PSA_CRYPTO) && \
+    defined(MBEDTLS_PSA_CRYPTO_C) && \
+    defined(MBEDTLS_SSL_HAVE_AEAD)
+#define MBEDTLS_SSL_TRANSFORM_KEYED_AEAD
+#endif
+
 #define MBEDTLS_SSL_INITIAL_HANDSHAKE           0
 #define MBEDTLS_SSL_RENEGOTIATION_IN_PROGRESS   1   /* In progress */
 #define MBEDTLS_SSL_RENEGOTIATION_DONE          2   /* Done or aborted */
@@ -400,13 +409,21 @@ uint32_t mbedtls_ssl_get_extension_mask(unsigned int extension_type);
      + (MBEDTLS_SSL_CID_IN_LEN_MAX))
 #endif
 
+#if MBEDTLS_SSL_OUT_BUFFER_RECORDS < 1
+#error "Bad configuration - outgoing buffer must hold at least one record."
+#endif
+
+/* The outgoing buffer holds MBEDTLS_SSL_OUT_BUFFER_RECORDS records, each of
+   them with a full header (which leaves room for the 8 bytes of sequence
+   number in front of the first one). */
 #if !defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
 #define MBEDTLS_SSL_OUT_BUFFER_LEN  \
-    ((MBEDTLS_SSL_HEADER_LEN) + (MBEDTLS_SSL_OUT_PAYLOAD_LEN))
+    (((MBEDTLS_SSL_HEADER_LEN) + (MBEDTLS_SSL_OUT_PAYLOAD_LEN)) \
+     * (MBEDTLS_SSL_OUT_BUFFER_RECORDS))
 #else
 #define MBEDTLS_SSL_OUT_BUFFER_LEN                               \
-    ((MBEDTLS_SSL_HEADER_LEN) + (MBEDTLS_SSL_OUT_PAYLOAD_LEN)    \
-     + (MBEDTLS_SSL_CID_OUT_LEN_MAX))
+    (((MBEDTLS_SSL_HEADER_LEN) + (MBEDTLS_SSL_OUT_PAYLOAD_LEN)   \
+      + (MBEDTLS_SSL_CID_OUT_LEN_MAX)) * (MBEDTLS_SSL_OUT_BUFFER_RECORDS))
 #endif
 
 #define MBEDTLS_CLIENT_HELLO_RANDOM_LEN 32
@@ -462,12 +479,13 @@ size_t mbedtls_ssl_get_output_record_size_limit(const mbedtls_ssl_context *ssl);
 static inline size_t mbedtls_ssl_get_output_buflen(const mbedtls_ssl_context *ctx)
 {
 #if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
-    return mbedtls_ssl_get_output_max_frag_len(ctx)
-           + MBEDTLS_SSL_HEADER_LEN + MBEDTLS_SSL_PAYLOAD_OVERHEAD
-           + MBEDTLS_SSL_CID_OUT_LEN_MAX;
+    return (mbedtls_ssl_get_output_max_frag_len(ctx)
+            + MBEDTLS_SSL_HEADER_LEN + MBEDTLS_SSL_PAYLOAD_OVERHEAD
+            + MBEDTLS_SSL_CID_OUT_LEN_MAX) * MBEDTLS_SSL_OUT_BUFFER_RECORDS;
 #else
-    return mbedtls_ssl_get_output_max_frag_len(ctx)
-           + MBEDTLS_SSL_HEADER_LEN + MBEDTLS_SSL_PAYLOAD_OVERHEAD;
+    return (mbedtls_ssl_get_output_max_frag_len(ctx)
+            + MBEDTLS_SSL_HEADER_LEN + MBEDTLS_SSL_PAYLOAD_OVERHEAD)
+           * MBEDTLS_SSL_OUT_BUFFER_RECORDS;
 #endif
 }
 
@@ -1154,6 +1172,13 @@ struct mbedtls_ssl_transform {
     mbedtls_svc_key_id_t psa_key_enc;           /*!<  psa encryption key      */
     mbedtls_svc_key_id_t psa_key_dec;           /*!<  psa decryption key      */
     psa_algorithm_t psa_alg;                    /*!<  psa algorithm           */
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+    /* Contexts keyed with psa_key_enc/psa_key_dec, set up when the transform
+     * is populated. If setup was not possible (e.g. the key is handled by a
+     * driver), alg is 0 and the record layer uses the one-shot API. */
+    mbedtls_psa_aead_operation_t psa_aead_enc;  /*!<  keyed AEAD (encryption) */
+    mbedtls_psa_aead_operation_t psa_aead_dec;  /*!<  keyed AEAD (decryption) */
+#endif
 #else
     mbedtls_cipher_context_t cipher_ctx_enc;    /*!<  encryption context      */
     mbedtls_cipher_context_t cipher_ctx_dec;    /*!<  decryption context      */
@@ -1489,6 +1514,14 @@ int mbedtls_ssl_write_record(mbedtls_ssl_context *ssl, int force_flush);
 MBEDTLS_CHECK_RETURN_CRITICAL
 int mbedtls_ssl_flush_output(mbedtls_ssl_context *ssl);
 
+/*
+ * TLS: whether the handshake records written so far may stay in the output
+ * buffer while the next message of the flight is written, rather than being
+ * flushed first. The whole flight is then flushed at once, at the latest
+ * when the endpoint waits for the peer.
+ */
+int mbedtls_ssl_hs_can_defer_flush(const mbedtls_ssl_context *ssl);
+
 MBEDTLS_CHECK_RETURN_CRITICAL
 int mbedtls_ssl_parse_certificate(mbedtls_ssl_context *ssl);
 MBEDTLS_CHECK_RETURN_CRITICAL
@@ -1819,6 +1852,12 @@ int mbedtls_ssl_get_key_exchange_md_tls1_2(mbedtls_ssl_context *ssl,
 #endif
 
 void mbedtls_ssl_transform_init(mbedtls_ssl_transform *transform);
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+/* Set up transform->psa_aead_enc and psa_aead_dec from the transform's
+ * PSA keys. Must be called once the keys have been imported. Failure is not
+ * an error: the record layer then falls back to the one-shot PSA API. */
+void mbedtls_ssl_transform_setup_keyed_aead(mbedtls_ssl_transform *transform);
+#endif
 MBEDTLS_CHECK_RETURN_CRITICAL
 int mbedtls_ssl_encrypt_buf(mbedtls_ssl_context *ssl,
                             mbedtls_ssl_transform *transform,
@@ -1858,6 +1897,21 @@ void mbedtls_ssl_reset_out_pointers(mbedtls_ssl_context *ssl);
 void mbedtls_ssl_update_out_pointers(mbedtls_ssl_context *ssl,
                                      mbedtls_ssl_transform *transform);
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+/*
+ * Take the I/O buffers back from the configured buffer pool if the context
+ * released them while it was idle. Does nothing if it holds its buffers.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+int mbedtls_ssl_acquire_buffers(mbedtls_ssl_context *ssl);
+
+/*
+ * Hand the I/O buffers of a TLS context to the configured buffer pool if no
+ * record is partially received, pending or partially sent.
+ */
+void mbedtls_ssl_release_idle_buffers(mbedtls_ssl_context *ssl);
+#endif /* MBEDTLS_SSL_BUFFER_POOL */
+
 MBEDTLS_CHECK_RETURN_CRITICAL
 int mbedtls_ssl_session_reset_int(mbedtls_ssl_context *ssl, int partial);
 void mbedtls_ssl_session_reset_msg_layer(mbedtls_ssl_context *ssl,
@@ -1880,8 +1934,33 @@ void mbedtls_ssl_pend_fatal_alert(mbedtls_ssl_context *ssl,
 #define MBEDTLS_SSL_PEND_FATAL_ALERT(type, user_return_value)         \
     mbedtls_ssl_pend_fatal_alert(ssl, type, user_return_value)
 
+#if defined(MBEDTLS_USE_PSA_CRYPTO) || defined(MBEDTLS_SSL_PROTO_TLS1_3)
+/*
+ * Make handshake->xxdh_psa_privkey an ephemeral key pair of type
+ * handshake->xxdh_psa_type and size handshake->xxdh_psa_bits for alg, taken
+ * from the key share pool of the configuration if there is one with a key
+ * ready, generated otherwise, and write its public key to pub.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+psa_status_t mbedtls_ssl_generate_xxdh_psa_key(mbedtls_ssl_context *ssl,
+                                               psa_algorithm_t alg,
+                                               unsigned char *pub,
+                                               size_t pub_size,
+                                               size_t *pub_len);
+#endif
+
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
+/* Number of 64-bit words in the anti-replay ring: one more than the window
+ * needs, so that the word being filled never overlaps the oldest one. */
+#define MBEDTLS_SSL_DTLS_REPLAY_WORDS   (MBEDTLS_SSL_DTLS_REPLAY_WINDOW / 64 + 1)
+
 void mbedtls_ssl_dtls_replay_reset(mbedtls_ssl_context *ssl);
+
+/* The newest 64 bits of the window, as serialized: bit n is set iff record
+ * number in_window_top - n has been seen. */
+uint64_t mbedtls_ssl_dtls_replay_get_window(const mbedtls_ssl_context *ssl);
+void mbedtls_ssl_dtls_replay_set_window(mbedtls_ssl_context *ssl,
+                                        uint64_t top, uint64_t window);
 #endif
 
 void mbedtls_ssl_handshake_wrapup_free_hs_transform(mbedtls_ssl_context *ssl);
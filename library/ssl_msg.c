@@ -33,6 +33,10 @@
 #include "psa/crypto.h"
 #endif
 
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+#include "psa_crypto_core.h"
+#endif
+
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
 #include "mbedtls/oid.h"
 #endif
@@ -397,6 +401,10 @@ static size_t ssl_get_maximum_datagram_size(mbedtls_ssl_context const *ssl)
     size_t out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
 #endif
 
+    /* Datagrams are not allowed to grow with the room for several TLS
+     * records in the outgoing buffer. */
+    out_buf_len /= MBEDTLS_SSL_OUT_BUFFER_RECORDS;
+
     if (mtu != 0 && mtu < out_buf_len) {
         return mtu;
     }
@@ -1195,6 +1203,16 @@ hmac_failed_etm_disabled:
          * Encrypt and authenticate
          */
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+        if (transform->psa_aead_enc.alg != 0) {
+            status = mbedtls_psa_aead_keyed_encrypt(&transform->psa_aead_enc,
+                                                    iv, transform->ivlen,
+                                                    add_data, add_data_len,
+                                                    data, rec->data_len,
+                                                    data, rec->buf_len - (data - rec->buf),
+                                                    &rec->data_len);
+        } else
+#endif /* MBEDTLS_SSL_TRANSFORM_KEYED_AEAD */
         status = psa_aead_encrypt(transform->psa_key_enc,
                                   transform->psa_alg,
                                   iv, transform->ivlen,
@@ -1622,6 +1640,16 @@ int mbedtls_ssl_decrypt_buf(mbedtls_ssl_context const *ssl,
          * Decrypt and authenticate
          */
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+        if (transform->psa_aead_dec.alg != 0) {
+            status = mbedtls_psa_aead_keyed_decrypt(&transform->psa_aead_dec,
+                                                    iv, transform->ivlen,
+                                                    add_data, add_data_len,
+                                                    data, rec->data_len + transform->taglen,
+                                                    data, rec->buf_len - (data - rec->buf),
+                                                    &olen);
+        } else
+#endif /* MBEDTLS_SSL_TRANSFORM_KEYED_AEAD */
         status = psa_aead_decrypt(transform->psa_key_dec,
                                   transform->psa_alg,
                                   iv, transform->ivlen,
@@ -2297,6 +2325,19 @@ int mbedtls_ssl_fetch_input(mbedtls_ssl_context *ssl, size_t nb_want)
                                   ", nb_want: %" MBEDTLS_PRINTF_SIZET,
                                   ssl->in_left, nb_want));
 
+        /*
+         * Handshake records may have been kept back to send the whole
+         * flight at once, see mbedtls_ssl_hs_can_defer_flush(). Send them
+         * before waiting for the peer's answer.
+         */
+        if (ssl->in_left < nb_want && ssl->out_left != 0 &&
+            ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+            if ((ret = mbedtls_ssl_flush_output(ssl)) != 0) {
+                MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_flush_output", ret);
+                return ret;
+            }
+        }
+
         while (ssl->in_left < nb_want) {
             len = nb_want - ssl->in_left;
 
@@ -2343,6 +2384,44 @@ int mbedtls_ssl_fetch_input(mbedtls_ssl_context *ssl, size_t nb_want)
     return 0;
 }
 
+/*
+ * Handshake messages are written at ssl->out_msg with room for a full record
+ * assumed after it, see mbedtls_ssl_start_handshake_msg(). Records of the
+ * current flight can stay in the output buffer as long as that room is left
+ * behind them.
+ */
+int mbedtls_ssl_hs_can_defer_flush(const mbedtls_ssl_context *ssl)
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t out_buf_len = ssl->out_buf_len;
+#else
+    size_t out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
+    size_t used;
+
+    if (ssl->conf->transport != MBEDTLS_SSL_TRANSPORT_STREAM ||
+        ssl->handshake == NULL || ssl->out_buf == NULL) {
+        return 0;
+    }
+
+    switch (ssl->state) {
+        case MBEDTLS_SSL_HANDSHAKE_OVER:
+        case MBEDTLS_SSL_FLUSH_BUFFERS:
+        case MBEDTLS_SSL_HANDSHAKE_WRAPUP:
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+        case MBEDTLS_SSL_TLS1_3_NEW_SESSION_TICKET_FLUSH:
+#endif
+            return 0;
+        default:
+            break;
+    }
+
+    used = (size_t) (ssl->out_hdr - ssl->out_buf);
+
+    return out_buf_len - used >=
+           mbedtls_ssl_out_hdr_len(ssl) + MBEDTLS_SSL_OUT_PAYLOAD_LEN;
+}
+
 /*
  * Flush any data not yet written
  */
@@ -2896,6 +2975,10 @@ int mbedtls_ssl_write_handshake_msg_ext(mbedtls_ssl_context *ssl,
     } else
 #endif
     {
+        if (force_flush == SSL_FORCE_FLUSH && mbedtls_ssl_hs_can_defer_flush(ssl)) {
+            force_flush = SSL_DONT_FORCE_FLUSH;
+        }
+
         if ((ret = mbedtls_ssl_write_record(ssl, force_flush)) != 0) {
             MBEDTLS_SSL_DEBUG_RET(1, "ssl_write_record", ret);
             return ret;
@@ -3457,21 +3540,27 @@ int mbedtls_ssl_update_handshake_status(mbedtls_ssl_context *ssl)
 /*
  * DTLS anti-replay: RFC 6347 4.1.2.6
  *
- * in_window is a field of bits numbered from 0 (lsb) to 63 (msb).
- * Bit n is set iff record number in_window_top - n has been seen.
+ * in_window is a ring of 64-bit words. Record number n is tracked by bit
+ * n % 64 of word (n / 64) % MBEDTLS_SSL_DTLS_REPLAY_WORDS, and that bit is
+ * set iff record number n has been seen. Only the record numbers from
+ * in_window_top - MBEDTLS_SSL_DTLS_REPLAY_WINDOW + 1 to in_window_top are
+ * tracked: older ones are rejected, newer ones accepted.
  *
- * Usually, in_window_top is the last record number seen and the lsb of
- * in_window is set. The only exception is the initial state (record number 0
- * not seen yet).
+ * Usually, in_window_top is the last record number seen. The only exception
+ * is the initial state (record number 0 not seen yet).
+ *
+ * Moving in_window_top forward clears the words of the blocks of 64 record
+ * numbers it enters, so the cost of an update does not depend on the size
+ * of the window.
  */
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
 void mbedtls_ssl_dtls_replay_reset(mbedtls_ssl_context *ssl)
 {
     ssl->in_window_top = 0;
-    ssl->in_window = 0;
+    memset(ssl->in_window, 0, sizeof(ssl->in_window));
 }
 
-static inline uint64_t ssl_load_six_bytes(unsigned char *buf)
+static inline uint64_t ssl_load_six_bytes(const unsigned char *buf)
 {
     return ((uint64_t) buf[0] << 40) |
            ((uint64_t) buf[1] << 32) |
@@ -3481,34 +3570,23 @@ static inline uint64_t ssl_load_six_bytes(unsigned char *buf)
            ((uint64_t) buf[5]);
 }
 
-MBEDTLS_CHECK_RETURN_CRITICAL
-static int mbedtls_ssl_dtls_record_replay_check(mbedtls_ssl_context *ssl, uint8_t *record_in_ctr)
+/* Word of the ring holding the bit of a record number */
+static inline size_t ssl_replay_word(uint64_t seqnum)
 {
-    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
-    unsigned char *original_in_ctr;
-
-    // save original in_ctr
-    original_in_ctr = ssl->in_ctr;
-
-    // use counter from record
-    ssl->in_ctr = record_in_ctr;
-
-    ret = mbedtls_ssl_dtls_replay_check((mbedtls_ssl_context const *) ssl);
-
-    // restore the counter
-    ssl->in_ctr = original_in_ctr;
+    return (size_t) ((seqnum >> 6) % MBEDTLS_SSL_DTLS_REPLAY_WORDS);
+}
 
-    return ret;
+static inline uint64_t ssl_replay_bit(uint64_t seqnum)
+{
+    return (uint64_t) 1 << (seqnum & 63);
 }
 
 /*
  * Return 0 if sequence number is acceptable, -1 otherwise
  */
-int mbedtls_ssl_dtls_replay_check(mbedtls_ssl_context const *ssl)
+static int ssl_dtls_replay_check_seqnum(mbedtls_ssl_context const *ssl,
+                                        uint64_t rec_seqnum)
 {
-    uint64_t rec_seqnum = ssl_load_six_bytes(ssl->in_ctr + 2);
-    uint64_t bit;
-
     if (ssl->conf->anti_replay == MBEDTLS_SSL_ANTI_REPLAY_DISABLED) {
         return 0;
     }
@@ -3517,48 +3595,95 @@ int mbedtls_ssl_dtls_replay_check(mbedtls_ssl_context const *ssl)
         return 0;
     }
 
-    bit = ssl->in_window_top - rec_seqnum;
-
-    if (bit >= 64) {
+    if (ssl->in_window_top - rec_seqnum >= MBEDTLS_SSL_DTLS_REPLAY_WINDOW) {
         return -1;
     }
 
-    if ((ssl->in_window & ((uint64_t) 1 << bit)) != 0) {
+    if ((ssl->in_window[ssl_replay_word(rec_seqnum)] & ssl_replay_bit(rec_seqnum)) != 0) {
         return -1;
     }
 
     return 0;
 }
 
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int mbedtls_ssl_dtls_record_replay_check(mbedtls_ssl_context const *ssl,
+                                                const uint8_t *record_in_ctr)
+{
+    return ssl_dtls_replay_check_seqnum(ssl, ssl_load_six_bytes(record_in_ctr + 2));
+}
+
+int mbedtls_ssl_dtls_replay_check(mbedtls_ssl_context const *ssl)
+{
+    return ssl_dtls_replay_check_seqnum(ssl, ssl_load_six_bytes(ssl->in_ctr + 2));
+}
+
+/* Mark a record number as seen, moving the window forward if needed */
+static void ssl_dtls_replay_mark(mbedtls_ssl_context *ssl, uint64_t rec_seqnum)
+{
+    if (rec_seqnum > ssl->in_window_top) {
+        /* Clear the words of the blocks the window moves into */
+        uint64_t block = ssl->in_window_top >> 6;
+        uint64_t shift = (rec_seqnum >> 6) - block;
+
+        if (shift >= MBEDTLS_SSL_DTLS_REPLAY_WORDS) {
+            memset(ssl->in_window, 0, sizeof(ssl->in_window));
+        } else {
+            while (shift-- > 0) {
+                ssl->in_window[(size_t) (++block % MBEDTLS_SSL_DTLS_REPLAY_WORDS)] = 0;
+            }
+        }
+
+        ssl->in_window_top = rec_seqnum;
+    } else if (ssl->in_window_top - rec_seqnum >= MBEDTLS_SSL_DTLS_REPLAY_WINDOW) {
+        /* Out of the window: always false after a check, but be extra sure */
+        return;
+    }
+
+    ssl->in_window[ssl_replay_word(rec_seqnum)] |= ssl_replay_bit(rec_seqnum);
+}
+
 /*
  * Update replay window on new validated record
  */
 void mbedtls_ssl_dtls_replay_update(mbedtls_ssl_context *ssl)
 {
-    uint64_t rec_seqnum = ssl_load_six_bytes(ssl->in_ctr + 2);
-
     if (ssl->conf->anti_replay == MBEDTLS_SSL_ANTI_REPLAY_DISABLED) {
         return;
     }
 
-    if (rec_seqnum > ssl->in_window_top) {
-        /* Update window_top and the contents of the window */
-        uint64_t shift = rec_seqnum - ssl->in_window_top;
+    ssl_dtls_replay_mark(ssl, ssl_load_six_bytes(ssl->in_ctr + 2));
+}
 
-        if (shift >= 64) {
-            ssl->in_window = 1;
-        } else {
-            ssl->in_window <<= shift;
-            ssl->in_window |= 1;
+uint64_t mbedtls_ssl_dtls_replay_get_window(const mbedtls_ssl_context *ssl)
+{
+    uint64_t window = 0;
+    uint64_t n;
+
+    for (n = 0; n < 64 && n <= ssl->in_window_top; n++) {
+        uint64_t seqnum = ssl->in_window_top - n;
+
+        if ((ssl->in_window[ssl_replay_word(seqnum)] & ssl_replay_bit(seqnum)) != 0) {
+            window |= (uint64_t) 1 << n;
         }
+    }
 
-        ssl->in_window_top = rec_seqnum;
-    } else {
-        /* Mark that number as seen in the current window */
-        uint64_t bit = ssl->in_window_top - rec_seqnum;
+    return window;
+}
 
-        if (bit < 64) { /* Always true, but be extra sure */
-            ssl->in_window |= (uint64_t) 1 << bit;
+void mbedtls_ssl_dtls_replay_set_window(mbedtls_ssl_context *ssl,
+                                        uint64_t top, uint64_t window)
+{
+    uint64_t n;
+
+    mbedtls_ssl_dtls_replay_reset(ssl);
+    ssl->in_window_top = top;
+
+    for (n = 0; n < MBEDTLS_SSL_DTLS_REPLAY_WINDOW && n <= top; n++) {
+        /* Only the newest 64 bits are known. Treat older record numbers as
+         * seen, so that none can be replayed. */
+        if (n >= 64 || (window & ((uint64_t) 1 << n)) != 0) {
+            ssl_dtls_replay_mark(ssl, top - n);
         }
     }
 }
@@ -4022,8 +4147,7 @@ static int ssl_parse_record_header(mbedtls_ssl_context const *ssl,
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
         /* For records from the correct epoch, check whether their
          * sequence number has been seen before. */
-        else if (mbedtls_ssl_dtls_record_replay_check((mbedtls_ssl_context *) ssl,
-                                                      &rec->ctr[0]) != 0) {
+        else if (mbedtls_ssl_dtls_record_replay_check(ssl, &rec->ctr[0]) != 0) {
             MBEDTLS_SSL_DEBUG_MSG(1, ("replayed record"));
             return MBEDTLS_ERR_SSL_UNEXPECTED_RECORD;
         }
@@ -5288,6 +5412,12 @@ int mbedtls_ssl_send_alert_message(mbedtls_ssl_context *ssl,
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if ((ret = mbedtls_ssl_acquire_buffers(ssl)) != 0) {
+        return ret;
+    }
+#endif
+
     if (ssl->out_left != 0) {
         return mbedtls_ssl_flush_output(ssl);
     }
@@ -5889,15 +6019,9 @@ static int ssl_handle_hs_message_post_handshake(mbedtls_ssl_context *ssl)
  *
  * return         The number of bytes read.
  */
-static int ssl_read_application_data(
-    mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+static void ssl_consume_application_data(mbedtls_ssl_context *ssl, size_t n)
 {
-    size_t n = (len < ssl->in_msglen) ? len : ssl->in_msglen;
-
-    if (len != 0) {
-        memcpy(buf, ssl->in_offt, n);
-        ssl->in_msglen -= n;
-    }
+    ssl->in_msglen -= n;
 
     /* Zeroising the plaintext buffer to erase unused application data
        from the memory. */
@@ -5911,23 +6035,32 @@ static int ssl_read_application_data(
         /* more data available */
         ssl->in_offt += n;
     }
+}
+
+static int ssl_read_application_data(
+    mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+{
+    size_t n = (len < ssl->in_msglen) ? len : ssl->in_msglen;
+
+    if (n != 0) {
+        memcpy(buf, ssl->in_offt, n);
+    }
+    ssl_consume_application_data(ssl, n);
 
     return (int) n;
 }
 
 /*
- * Receive application data decrypted from the SSL layer
+ * Read records until decrypted application data is available at
+ * ssl->in_offt, handling handshake messages on the way.
+ *
+ * Returns MBEDTLS_ERR_SSL_CONN_EOF if the peer has closed the connection.
  */
-int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_read_wait_application_data(mbedtls_ssl_context *ssl)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
 
-    if (ssl == NULL || ssl->conf == NULL) {
-        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
-    }
-
-    MBEDTLS_SSL_DEBUG_MSG(2, ("=> read"));
-
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
         if ((ret = mbedtls_ssl_flush_output(ssl)) != 0) {
@@ -5982,11 +6115,9 @@ int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
         }
 
         if ((ret = mbedtls_ssl_read_record(ssl, 1)) != 0) {
-            if (ret == MBEDTLS_ERR_SSL_CONN_EOF) {
-                return 0;
+            if (ret != MBEDTLS_ERR_SSL_CONN_EOF) {
+                MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_read_record", ret);
             }
-
-            MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_read_record", ret);
             return ret;
         }
 
@@ -5996,11 +6127,9 @@ int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
              * OpenSSL sends empty messages to randomize the IV
              */
             if ((ret = mbedtls_ssl_read_record(ssl, 1)) != 0) {
-                if (ret == MBEDTLS_ERR_SSL_CONN_EOF) {
-                    return 0;
+                if (ret != MBEDTLS_ERR_SSL_CONN_EOF) {
+                    MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_read_record", ret);
                 }
-
-                MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_read_record", ret);
                 return ret;
             }
         }
@@ -6084,13 +6213,117 @@ int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
     }
 
-    ret = ssl_read_application_data(ssl, buf, len);
+    return 0;
+}
 
-    MBEDTLS_SSL_DEBUG_MSG(2, ("<= read"));
+/*
+ * Receive application data decrypted from the SSL layer
+ */
+int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (ssl == NULL || ssl->conf == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("=> read"));
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if ((ret = mbedtls_ssl_acquire_buffers(ssl)) != 0) {
+        return ret;
+    }
+#endif
+
+    ret = ssl_read_wait_application_data(ssl);
+    if (ret == 0) {
+        ret = ssl_read_application_data(ssl, buf, len);
+
+        MBEDTLS_SSL_DEBUG_MSG(2, ("<= read"));
+    } else if (ret == MBEDTLS_ERR_SSL_CONN_EOF) {
+        ret = 0;
+    }
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_release_idle_buffers(ssl);
+#endif
 
     return ret;
 }
 
+/*
+ * Lend the decrypted application data of the current record
+ */
+int mbedtls_ssl_read_peek(mbedtls_ssl_context *ssl,
+                          const unsigned char **buf, size_t *len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (ssl == NULL || ssl->conf == NULL || buf == NULL || len == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("=> read peek"));
+
+    *buf = NULL;
+    *len = 0;
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if ((ret = mbedtls_ssl_acquire_buffers(ssl)) != 0) {
+        return ret;
+    }
+#endif
+
+    ret = ssl_read_wait_application_data(ssl);
+    if (ret == 0) {
+        if (ssl->in_msglen == 0) {
+            /* An empty record: a zero length means end of connection here,
+             * so drop it and let the caller come back for the next one. */
+            ssl_consume_application_data(ssl, 0);
+            ret = MBEDTLS_ERR_SSL_WANT_READ;
+        } else {
+            *buf = ssl->in_offt;
+            *len = ssl->in_msglen;
+
+            MBEDTLS_SSL_DEBUG_MSG(2, ("<= read peek"));
+        }
+    } else if (ret == MBEDTLS_ERR_SSL_CONN_EOF) {
+        ret = 0;
+    }
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_release_idle_buffers(ssl);
+#endif
+
+    return ret;
+}
+
+/*
+ * Release application data lent by mbedtls_ssl_read_peek()
+ */
+int mbedtls_ssl_read_consume(mbedtls_ssl_context *ssl, size_t len)
+{
+    if (ssl == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (len == 0) {
+        return 0;
+    }
+
+    if (ssl->in_offt == NULL || len > ssl->in_msglen) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    ssl_consume_application_data(ssl, len);
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_release_idle_buffers(ssl);
+#endif
+
+    return 0;
+}
+
 #if defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_SSL_EARLY_DATA)
 int mbedtls_ssl_read_early_data(mbedtls_ssl_context *ssl,
                                 unsigned char *buf, size_t len)
@@ -6112,6 +6345,69 @@ int mbedtls_ssl_read_early_data(mbedtls_ssl_context *ssl,
 }
 #endif /* MBEDTLS_SSL_SRV_C && MBEDTLS_SSL_EARLY_DATA */
 
+/*
+ * Maximum payload of the next application data record. This is the
+ * negotiated maximum, unless the dynamic record sizing policy of the
+ * configuration asks for smaller records at this point of the connection.
+ */
+static int ssl_get_app_data_record_payload(const mbedtls_ssl_context *ssl)
+{
+    int ret = mbedtls_ssl_get_max_out_record_payload(ssl);
+
+    if (ret > 0 && ssl->conf->dyn_record_len != 0 &&
+        ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_STREAM &&
+        ssl->dyn_record_sent < ssl->conf->dyn_record_threshold &&
+        (size_t) ret > ssl->conf->dyn_record_len) {
+        ret = (int) ssl->conf->dyn_record_len;
+    }
+
+    return ret;
+}
+
+/*
+ * Go back to small records if the connection has not sent application data
+ * for longer than the configured idle timeout. This is only done before a
+ * new write, never when resuming one, so that a resumed write sees the same
+ * record size as the original call.
+ */
+static void ssl_dyn_record_check_idle(mbedtls_ssl_context *ssl)
+{
+#if defined(MBEDTLS_HAVE_TIME)
+    if (ssl->conf->dyn_record_len == 0 || ssl->conf->dyn_record_idle == 0 ||
+        ssl->out_left != 0 || ssl->dyn_record_sent == 0) {
+        return;
+    }
+
+    if (mbedtls_ms_time() - ssl->dyn_record_last >
+        (mbedtls_ms_time_t) ssl->conf->dyn_record_idle) {
+        MBEDTLS_SSL_DEBUG_MSG(3, ("connection idle, shrink records"));
+        ssl->dyn_record_sent = 0;
+    }
+#else
+    (void) ssl;
+#endif /* MBEDTLS_HAVE_TIME */
+}
+
+/*
+ * Account for application data that has been fully sent.
+ */
+static void ssl_dyn_record_update(mbedtls_ssl_context *ssl, size_t len)
+{
+    if (ssl->conf->dyn_record_len == 0) {
+        return;
+    }
+
+    if (ssl->dyn_record_sent < ssl->conf->dyn_record_threshold) {
+        ssl->dyn_record_sent += len;
+    }
+
+#if defined(MBEDTLS_HAVE_TIME)
+    if (ssl->conf->dyn_record_idle != 0) {
+        ssl->dyn_record_last = mbedtls_ms_time();
+    }
+#endif
+}
+
 /*
  * Send application data to be encrypted by the SSL layer, taking care of max
  * fragment length and buffer size.
@@ -6125,17 +6421,27 @@ int mbedtls_ssl_read_early_data(mbedtls_ssl_context *ssl,
  * corresponding return code is 0 on success.
  */
 MBEDTLS_CHECK_RETURN_CRITICAL
-static int ssl_write_real(mbedtls_ssl_context *ssl,
-                          const unsigned char *buf, size_t len)
+static int ssl_write_real_vec(mbedtls_ssl_context *ssl,
+                              const mbedtls_ssl_iovec *iov, size_t iovcnt,
+                              size_t max_records)
 {
-    int ret = mbedtls_ssl_get_max_out_record_payload(ssl);
+    int ret = ssl_get_app_data_record_payload(ssl);
     const size_t max_len = (size_t) ret;
+    size_t len = 0;
+    size_t i;
 
     if (ret < 0) {
         MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_get_max_out_record_payload", ret);
         return ret;
     }
 
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].len > SIZE_MAX - len) {
+            return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        }
+        len += iov[i].len;
+    }
+
     if (len > max_len) {
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
         if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
@@ -6146,7 +6452,9 @@ static int ssl_write_real(mbedtls_ssl_context *ssl,
             return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
         } else
 #endif
-        len = max_len;
+        if (len > max_len * max_records) {
+            len = max_len * max_records;
+        }
     }
 
     if (ssl->out_left != 0) {
@@ -6164,23 +6472,94 @@ static int ssl_write_real(mbedtls_ssl_context *ssl,
         /*
          * The user is trying to send a message the first time, so we need to
          * copy the data into the internal buffers and setup the data structure
-         * to keep track of partial writes
+         * to keep track of partial writes. The records are laid out one after
+         * the other in the output buffer and only the last one flushes them.
          */
-        ssl->out_msglen  = len;
-        ssl->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
-        if (len > 0) {
-            memcpy(ssl->out_msg, buf, len);
-        }
+        size_t written = 0, iov_offset = 0;
 
-        if ((ret = mbedtls_ssl_write_record(ssl, SSL_FORCE_FLUSH)) != 0) {
-            MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_write_record", ret);
-            return ret;
-        }
+        i = 0;
+        do {
+            size_t rec_len = len - written < max_len ? len - written : max_len;
+            size_t copied = 0;
+
+            ssl->out_msglen  = rec_len;
+            ssl->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
+            while (copied < rec_len) {
+                size_t chunk = iov[i].len - iov_offset;
+                if (chunk > rec_len - copied) {
+                    chunk = rec_len - copied;
+                }
+                if (chunk > 0) {
+                    memcpy(ssl->out_msg + copied, iov[i].buf + iov_offset, chunk);
+                }
+                copied += chunk;
+                iov_offset += chunk;
+                if (iov_offset == iov[i].len) {
+                    i++;
+                    iov_offset = 0;
+                }
+            }
+            written += rec_len;
+
+            ret = mbedtls_ssl_write_record(ssl, written == len ? SSL_FORCE_FLUSH :
+                                           SSL_DONT_FORCE_FLUSH);
+            if (ret != 0) {
+                MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_write_record", ret);
+                return ret;
+            }
+        } while (written < len);
     }
 
+    ssl_dyn_record_update(ssl, len);
+
     return (int) len;
 }
 
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_write_real(mbedtls_ssl_context *ssl,
+                          const unsigned char *buf, size_t len)
+{
+    mbedtls_ssl_iovec iov;
+
+    iov.buf = buf;
+    iov.len = len;
+
+    return ssl_write_real_vec(ssl, &iov, 1, 1);
+}
+
+/*
+ * The number of full-size application data records that fit in the output
+ * buffer. This only depends on the current transform and limits, so that it
+ * is the same when the write is resumed after MBEDTLS_ERR_SSL_WANT_WRITE.
+ */
+static size_t ssl_get_out_records_per_buffer(const mbedtls_ssl_context *ssl)
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t out_buf_len = ssl->out_buf_len;
+#else
+    size_t out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
+    int max_len = ssl_get_app_data_record_payload(ssl);
+    int expansion = mbedtls_ssl_get_record_expansion(ssl);
+    size_t records;
+
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+    if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
+        return 1;
+    }
+#endif
+
+    if (max_len <= 0 || expansion < 0) {
+        return 1;
+    }
+
+    /* TLS records start 8 bytes into the buffer, see
+     * mbedtls_ssl_flush_output(). */
+    records = (out_buf_len - 8) / ((size_t) max_len + (size_t) expansion);
+
+    return records > 0 ? records : 1;
+}
+
 /*
  * Write application data (public-facing wrapper)
  */
@@ -6194,6 +6573,12 @@ int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if ((ret = mbedtls_ssl_acquire_buffers(ssl)) != 0) {
+        return ret;
+    }
+#endif
+
 #if defined(MBEDTLS_SSL_RENEGOTIATION)
     if ((ret = ssl_check_ctr_renegotiate(ssl)) != 0) {
         MBEDTLS_SSL_DEBUG_RET(1, "ssl_check_ctr_renegotiate", ret);
@@ -6208,13 +6593,76 @@ int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t
         }
     }
 
-    ret = ssl_write_real(ssl, buf, len);
+    ssl_dyn_record_check_idle(ssl);
+
+    if (ssl->conf->write_batching == MBEDTLS_SSL_WRITE_BATCHING_ENABLED) {
+        mbedtls_ssl_iovec iov;
+
+        iov.buf = buf;
+        iov.len = len;
+        ret = ssl_write_real_vec(ssl, &iov, 1,
+                                 ssl_get_out_records_per_buffer(ssl));
+    } else {
+        ret = ssl_write_real(ssl, buf, len);
+    }
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_release_idle_buffers(ssl);
+#endif
 
     MBEDTLS_SSL_DEBUG_MSG(2, ("<= write"));
 
     return ret;
 }
 
+/*
+ * Write application data gathered from several buffers
+ */
+int mbedtls_ssl_writev(mbedtls_ssl_context *ssl,
+                       const mbedtls_ssl_iovec *iov, size_t iovcnt)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("=> writev"));
+
+    if (ssl == NULL || ssl->conf == NULL || (iov == NULL && iovcnt != 0)) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if ((ret = mbedtls_ssl_acquire_buffers(ssl)) != 0) {
+        return ret;
+    }
+#endif
+
+#if defined(MBEDTLS_SSL_RENEGOTIATION)
+    if ((ret = ssl_check_ctr_renegotiate(ssl)) != 0) {
+        MBEDTLS_SSL_DEBUG_RET(1, "ssl_check_ctr_renegotiate", ret);
+        return ret;
+    }
+#endif
+
+    if (ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        if ((ret = mbedtls_ssl_handshake(ssl)) != 0) {
+            MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_handshake", ret);
+            return ret;
+        }
+    }
+
+    ssl_dyn_record_check_idle(ssl);
+
+    ret = ssl_write_real_vec(ssl, iov, iovcnt,
+                             ssl_get_out_records_per_buffer(ssl));
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_release_idle_buffers(ssl);
+#endif
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("<= writev"));
+
+    return ret;
+}
+
 #if defined(MBEDTLS_SSL_EARLY_DATA) && defined(MBEDTLS_SSL_CLI_C)
 int mbedtls_ssl_write_early_data(mbedtls_ssl_context *ssl,
                                  const unsigned char *buf, size_t len)
@@ -6347,6 +6795,26 @@ int mbedtls_ssl_close_notify(mbedtls_ssl_context *ssl)
     return 0;
 }
 
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+void mbedtls_ssl_transform_setup_keyed_aead(mbedtls_ssl_transform *transform)
+{
+    if (!PSA_ALG_IS_AEAD(transform->psa_alg)) {
+        return;
+    }
+
+    /* On failure the context is left all-zero, which selects the
+     * psa_aead_encrypt()/psa_aead_decrypt() path in the record layer. */
+    (void) mbedtls_psa_aead_keyed_setup(&transform->psa_aead_enc,
+                                        transform->psa_key_enc,
+                                        PSA_KEY_USAGE_ENCRYPT,
+                                        transform->psa_alg);
+    (void) mbedtls_psa_aead_keyed_setup(&transform->psa_aead_dec,
+                                        transform->psa_key_dec,
+                                        PSA_KEY_USAGE_DECRYPT,
+                                        transform->psa_alg);
+}
+#endif /* MBEDTLS_SSL_TRANSFORM_KEYED_AEAD */
+
 void mbedtls_ssl_transform_free(mbedtls_ssl_transform *transform)
 {
     if (transform == NULL) {
@@ -6354,6 +6822,10 @@ void mbedtls_ssl_transform_free(mbedtls_ssl_transform *transform)
     }
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+    mbedtls_psa_aead_keyed_free(&transform->psa_aead_enc);
+    mbedtls_psa_aead_keyed_free(&transform->psa_aead_dec);
+#endif
     psa_destroy_key(transform->psa_key_enc);
     psa_destroy_key(transform->psa_key_dec);
 #else
@@ -40,7 +40,7 @@
 #include "mbedtls/oid.h"
 #endif
 
-#if defined(MBEDTLS_USE_PSA_CRYPTO)
+#if defined(MBEDTLS_USE_PSA_CRYPTO) || defined(MBEDTLS_SSL_KEY_SHARE_POOL)
 /* Define local translating functions to save code size by not using too many
  * arguments in each translating place. */
 static int local_err_translation(psa_status_t status)
@@ -1369,6 +1369,534 @@ static int ssl_conf_check(const mbedtls_ssl_context *ssl)
     return 0;
 }
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+void mbedtls_ssl_buffer_pool_init(mbedtls_ssl_buffer_pool *pool)
+{
+    memset(pool, 0, sizeof(mbedtls_ssl_buffer_pool));
+
+    pool->max_idle = SIZE_MAX;
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_init(&pool->mutex);
+#endif
+}
+
+void mbedtls_ssl_buffer_pool_set_max_idle(mbedtls_ssl_buffer_pool *pool,
+                                          size_t max_idle)
+{
+    pool->max_idle = max_idle;
+}
+
+void mbedtls_ssl_buffer_pool_free(mbedtls_ssl_buffer_pool *pool)
+{
+    void *buf, *next;
+
+    if (pool == NULL) {
+        return;
+    }
+
+    /* Idle buffers were zeroized when they entered the pool, apart from
+     * the link to the next one. */
+    for (buf = pool->in_free; buf != NULL; buf = next) {
+        memcpy(&next, buf, sizeof(next));
+        mbedtls_free(buf);
+    }
+    for (buf = pool->out_free; buf != NULL; buf = next) {
+        memcpy(&next, buf, sizeof(next));
+        mbedtls_free(buf);
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_free(&pool->mutex);
+#endif
+
+    mbedtls_platform_zeroize(pool, sizeof(mbedtls_ssl_buffer_pool));
+}
+
+/*
+ * Take a zero-filled I/O buffer of len bytes from the pool, or from the heap
+ * if there is no pool, the pool is empty or len is not the default buffer
+ * length (which can happen with MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH).
+ */
+static unsigned char *ssl_buffer_pool_get(mbedtls_ssl_buffer_pool *pool,
+                                          int out, size_t len)
+{
+    unsigned char *buf = NULL;
+    void **list;
+    size_t *count;
+
+    if (pool == NULL ||
+        len != (out ? MBEDTLS_SSL_OUT_BUFFER_LEN : MBEDTLS_SSL_IN_BUFFER_LEN)) {
+        return mbedtls_calloc(1, len);
+    }
+
+    list = out ? &pool->out_free : &pool->in_free;
+    count = out ? &pool->out_count : &pool->in_count;
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_lock(&pool->mutex) != 0) {
+        return mbedtls_calloc(1, len);
+    }
+#endif
+
+    if (*list != NULL) {
+        buf = *list;
+        memcpy(list, buf, sizeof(*list));
+        (*count)--;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock(&pool->mutex);
+#endif
+
+    if (buf == NULL) {
+        return mbedtls_calloc(1, len);
+    }
+
+    memset(buf, 0, sizeof(void *));
+    return buf;
+}
+
+/*
+ * Zeroize an I/O buffer and hand it to the pool, or to the heap if the pool
+ * is full or cannot take it.
+ */
+static void ssl_buffer_pool_put(mbedtls_ssl_buffer_pool *pool,
+                                int out, unsigned char *buf, size_t len)
+{
+    void **list;
+    size_t *count;
+
+    if (pool == NULL ||
+        len != (out ? MBEDTLS_SSL_OUT_BUFFER_LEN : MBEDTLS_SSL_IN_BUFFER_LEN)) {
+        mbedtls_zeroize_and_free(buf, len);
+        return;
+    }
+
+    list = out ? &pool->out_free : &pool->in_free;
+    count = out ? &pool->out_count : &pool->in_count;
+
+    mbedtls_platform_zeroize(buf, len);
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_lock(&pool->mutex) != 0) {
+        mbedtls_free(buf);
+        return;
+    }
+#endif
+
+    if (*count < pool->max_idle) {
+        memcpy(buf, list, sizeof(*list));
+        *list = buf;
+        (*count)++;
+        buf = NULL;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock(&pool->mutex);
+#endif
+
+    mbedtls_free(buf);
+}
+
+int mbedtls_ssl_acquire_buffers(mbedtls_ssl_context *ssl)
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t in_buf_len = ssl->in_buf_len;
+    size_t out_buf_len = ssl->out_buf_len;
+#else
+    size_t in_buf_len = MBEDTLS_SSL_IN_BUFFER_LEN;
+    size_t out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
+
+    if (ssl->in_buf != NULL) {
+        return 0;
+    }
+
+    ssl->in_buf = ssl_buffer_pool_get(ssl->conf->buffer_pool, 0, in_buf_len);
+    ssl->out_buf = ssl_buffer_pool_get(ssl->conf->buffer_pool, 1, out_buf_len);
+    if (ssl->in_buf == NULL || ssl->out_buf == NULL) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("failed to take I/O buffers from the pool"));
+        mbedtls_free(ssl->in_buf);
+        mbedtls_free(ssl->out_buf);
+        ssl->in_buf = NULL;
+        ssl->out_buf = NULL;
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    /* Only TLS contexts release their buffers, and TLS keeps the incoming
+     * sequence number in front of the input buffer. */
+    memcpy(ssl->in_buf, ssl->idle_in_ctr, MBEDTLS_SSL_SEQUENCE_NUMBER_LEN);
+    mbedtls_platform_zeroize(ssl->idle_in_ctr, sizeof(ssl->idle_in_ctr));
+
+    mbedtls_ssl_reset_in_pointers(ssl);
+    mbedtls_ssl_reset_out_pointers(ssl);
+    mbedtls_ssl_update_out_pointers(ssl, ssl->transform_out);
+
+    return 0;
+}
+
+void mbedtls_ssl_release_idle_buffers(mbedtls_ssl_context *ssl)
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t in_buf_len = ssl->in_buf_len;
+    size_t out_buf_len = ssl->out_buf_len;
+#else
+    size_t in_buf_len = MBEDTLS_SSL_IN_BUFFER_LEN;
+    size_t out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
+
+    if (ssl->conf->buffer_pool == NULL || ssl->in_buf == NULL ||
+        ssl->conf->transport != MBEDTLS_SSL_TRANSPORT_STREAM ||
+        ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        return;
+    }
+
+    /* Nothing may be partially received, held back or partially sent. */
+    if (ssl->in_left != 0 || ssl->in_offt != NULL ||
+        ssl->keep_current_message != 0 ||
+        ssl->badmac_seen_or_in_hsfraglen != 0 ||
+        ssl->out_left != 0 || ssl->send_alert != 0) {
+        return;
+    }
+
+    /* The last message must have been processed completely, so that the
+     * next call to mbedtls_ssl_read_record() would consume all of it. */
+    if (ssl->in_hslen != 0 && ssl->in_hslen < ssl->in_msglen) {
+        return;
+    }
+    ssl->in_hslen = 0;
+    ssl->in_msglen = 0;
+
+    MBEDTLS_SSL_DEBUG_MSG(3, ("releasing idle I/O buffers to the pool"));
+
+    memcpy(ssl->idle_in_ctr, ssl->in_ctr, MBEDTLS_SSL_SEQUENCE_NUMBER_LEN);
+
+    ssl_buffer_pool_put(ssl->conf->buffer_pool, 0, ssl->in_buf, in_buf_len);
+    ssl_buffer_pool_put(ssl->conf->buffer_pool, 1, ssl->out_buf, out_buf_len);
+
+    ssl->in_buf = NULL;
+    ssl->in_ctr = NULL;
+    ssl->in_hdr = NULL;
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    ssl->in_cid = NULL;
+#endif
+    ssl->in_len = NULL;
+    ssl->in_iv = NULL;
+    ssl->in_msg = NULL;
+
+    ssl->out_buf = NULL;
+    ssl->out_ctr = NULL;
+    ssl->out_hdr = NULL;
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    ssl->out_cid = NULL;
+#endif
+    ssl->out_len = NULL;
+    ssl->out_iv = NULL;
+    ssl->out_msg = NULL;
+}
+#endif /* MBEDTLS_SSL_BUFFER_POOL */
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+/* A key pair ready for use, with its public key already exported */
+typedef struct {
+    mbedtls_svc_key_id_t key;
+    size_t pub_len;
+    unsigned char pub[PSA_EXPORT_PUBLIC_KEY_MAX_SIZE];
+} ssl_key_share_entry;
+
+/* The ready key pairs of one group, as a ring of pool->depth entries,
+ * oldest first */
+struct mbedtls_ssl_key_share_group {
+    uint16_t tls_id;
+    psa_key_type_t type;
+    size_t bits;
+    ssl_key_share_entry *entries;
+    size_t head;
+    size_t count;
+};
+
+void mbedtls_ssl_key_share_pool_init(mbedtls_ssl_key_share_pool *pool)
+{
+    memset(pool, 0, sizeof(mbedtls_ssl_key_share_pool));
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_init(&pool->mutex);
+#endif
+}
+
+/* Destroy the keys and free the queues, without taking the lock */
+static void ssl_key_share_pool_clear(mbedtls_ssl_key_share_pool *pool)
+{
+    struct mbedtls_ssl_key_share_group *group;
+    size_t i;
+
+    for (i = 0; i < pool->group_count; i++) {
+        group = &pool->groups[i];
+        if (group->entries == NULL) {
+            continue;
+        }
+        for (; group->count > 0; group->count--) {
+            (void) psa_destroy_key(group->entries[group->head].key);
+            group->head = (group->head + 1) % pool->depth;
+        }
+        mbedtls_free(group->entries);
+    }
+
+    mbedtls_free(pool->groups);
+    pool->groups = NULL;
+    pool->group_count = 0;
+    pool->depth = 0;
+}
+
+int mbedtls_ssl_key_share_pool_setup(mbedtls_ssl_key_share_pool *pool,
+                                     const uint16_t *groups,
+                                     size_t depth)
+{
+    size_t count, i;
+
+    for (count = 0; groups[count] != 0; count++) {
+        if (mbedtls_ssl_get_psa_curve_info_from_tls_id(groups[count], NULL, NULL)
+            != PSA_SUCCESS) {
+            return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        }
+    }
+
+    if (count == 0 || depth == 0) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    pool->groups = mbedtls_calloc(count, sizeof(*pool->groups));
+    if (pool->groups == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    pool->group_count = count;
+    pool->depth = depth;
+
+    for (i = 0; i < count; i++) {
+        pool->groups[i].tls_id = groups[i];
+        (void) mbedtls_ssl_get_psa_curve_info_from_tls_id(groups[i],
+                                                          &pool->groups[i].type,
+                                                          &pool->groups[i].bits);
+        pool->groups[i].entries = mbedtls_calloc(depth, sizeof(ssl_key_share_entry));
+        if (pool->groups[i].entries == NULL) {
+            ssl_key_share_pool_clear(pool);
+            return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        }
+    }
+
+    return 0;
+}
+
+int mbedtls_ssl_key_share_pool_refill(mbedtls_ssl_key_share_pool *pool,
+                                      size_t max_keys)
+{
+    psa_key_attributes_t key_attributes = psa_key_attributes_init();
+    psa_status_t status = PSA_ERROR_GENERIC_ERROR;
+    struct mbedtls_ssl_key_share_group *group;
+    ssl_key_share_entry entry;
+    int generated = 0;
+    size_t i;
+
+    psa_set_key_usage_flags(&key_attributes, PSA_KEY_USAGE_DERIVE);
+    psa_set_key_algorithm(&key_attributes, PSA_ALG_ECDH);
+
+    while (max_keys == 0 || (size_t) generated < max_keys) {
+        /* Serve the emptiest group first */
+#if defined(MBEDTLS_THREADING_C)
+        if (mbedtls_mutex_lock(&pool->mutex) != 0) {
+            return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+        }
+#endif
+        group = NULL;
+        for (i = 0; i < pool->group_count; i++) {
+            if (pool->groups[i].count < pool->depth &&
+                (group == NULL || pool->groups[i].count < group->count)) {
+                group = &pool->groups[i];
+            }
+        }
+#if defined(MBEDTLS_THREADING_C)
+        (void) mbedtls_mutex_unlock(&pool->mutex);
+#endif
+
+        if (group == NULL) {
+            break;
+        }
+
+        /* The expensive part, done without the lock */
+        psa_set_key_type(&key_attributes, group->type);
+        psa_set_key_bits(&key_attributes, group->bits);
+        status = psa_generate_key(&key_attributes, &entry.key);
+        if (status != PSA_SUCCESS) {
+            return PSA_TO_MBEDTLS_ERR(status);
+        }
+        status = psa_export_public_key(entry.key, entry.pub, sizeof(entry.pub),
+                                       &entry.pub_len);
+        if (status != PSA_SUCCESS) {
+            (void) psa_destroy_key(entry.key);
+            return PSA_TO_MBEDTLS_ERR(status);
+        }
+
+#if defined(MBEDTLS_THREADING_C)
+        if (mbedtls_mutex_lock(&pool->mutex) != 0) {
+            (void) psa_destroy_key(entry.key);
+            return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+        }
+#endif
+        if (group->count < pool->depth) {
+            group->entries[(group->head + group->count) % pool->depth] = entry;
+            group->count++;
+            generated++;
+        } else {
+            /* Another thread filled the group meanwhile */
+            status = PSA_ERROR_ALREADY_EXISTS;
+        }
+#if defined(MBEDTLS_THREADING_C)
+        (void) mbedtls_mutex_unlock(&pool->mutex);
+#endif
+
+        if (status != PSA_SUCCESS) {
+            (void) psa_destroy_key(entry.key);
+        }
+    }
+
+    return generated;
+}
+
+size_t mbedtls_ssl_key_share_pool_count(mbedtls_ssl_key_share_pool *pool,
+                                        uint16_t group)
+{
+    size_t count = 0, i;
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_lock(&pool->mutex) != 0) {
+        return 0;
+    }
+#endif
+
+    for (i = 0; i < pool->group_count; i++) {
+        if (pool->groups[i].tls_id == group) {
+            count = pool->groups[i].count;
+            break;
+        }
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock(&pool->mutex);
+#endif
+
+    return count;
+}
+
+void mbedtls_ssl_key_share_pool_free(mbedtls_ssl_key_share_pool *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    ssl_key_share_pool_clear(pool);
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_free(&pool->mutex);
+#endif
+
+    mbedtls_platform_zeroize(pool, sizeof(mbedtls_ssl_key_share_pool));
+}
+
+/*
+ * Take a ready key pair of the given type from the pool, and copy its public
+ * key to pub. Return 0 on success, non-zero if the pool has none.
+ */
+static int ssl_key_share_pool_take(mbedtls_ssl_key_share_pool *pool,
+                                   psa_key_type_t type, size_t bits,
+                                   mbedtls_svc_key_id_t *key,
+                                   unsigned char *pub, size_t pub_size,
+                                   size_t *pub_len)
+{
+    struct mbedtls_ssl_key_share_group *group;
+    ssl_key_share_entry *entry;
+    int ret = -1;
+    size_t i;
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_lock(&pool->mutex) != 0) {
+        return -1;
+    }
+#endif
+
+    for (i = 0; i < pool->group_count; i++) {
+        group = &pool->groups[i];
+        if (group->type != type || group->bits != bits || group->count == 0) {
+            continue;
+        }
+
+        entry = &group->entries[group->head];
+        if (entry->pub_len > pub_size) {
+            break;
+        }
+
+        *key = entry->key;
+        memcpy(pub, entry->pub, entry->pub_len);
+        *pub_len = entry->pub_len;
+        memset(entry, 0, sizeof(*entry));
+        group->head = (group->head + 1) % pool->depth;
+        group->count--;
+        ret = 0;
+        break;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock(&pool->mutex);
+#endif
+
+    return ret;
+}
+#endif /* MBEDTLS_SSL_KEY_SHARE_POOL */
+
+#if defined(MBEDTLS_USE_PSA_CRYPTO) || defined(MBEDTLS_SSL_PROTO_TLS1_3)
+psa_status_t mbedtls_ssl_generate_xxdh_psa_key(mbedtls_ssl_context *ssl,
+                                               psa_algorithm_t alg,
+                                               unsigned char *pub,
+                                               size_t pub_size,
+                                               size_t *pub_len)
+{
+    mbedtls_ssl_handshake_params *handshake = ssl->handshake;
+    psa_key_attributes_t key_attributes;
+    psa_status_t status = PSA_ERROR_GENERIC_ERROR;
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+    if (alg == PSA_ALG_ECDH && ssl->conf->key_share_pool != NULL &&
+        ssl_key_share_pool_take(ssl->conf->key_share_pool,
+                                handshake->xxdh_psa_type, handshake->xxdh_psa_bits,
+                                &handshake->xxdh_psa_privkey,
+                                pub, pub_size, pub_len) == 0) {
+        MBEDTLS_SSL_DEBUG_MSG(3, ("ephemeral key taken from the pool"));
+        return PSA_SUCCESS;
+    }
+#endif
+
+    key_attributes = psa_key_attributes_init();
+    psa_set_key_usage_flags(&key_attributes, PSA_KEY_USAGE_DERIVE);
+    psa_set_key_algorithm(&key_attributes, alg);
+    psa_set_key_type(&key_attributes, handshake->xxdh_psa_type);
+    psa_set_key_bits(&key_attributes, handshake->xxdh_psa_bits);
+
+    status = psa_generate_key(&key_attributes, &handshake->xxdh_psa_privkey);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    status = psa_export_public_key(handshake->xxdh_psa_privkey,
+                                   pub, pub_size, pub_len);
+    if (status != PSA_SUCCESS) {
+        (void) psa_destroy_key(handshake->xxdh_psa_privkey);
+        handshake->xxdh_psa_privkey = MBEDTLS_SVC_KEY_ID_INIT;
+    }
+
+    return status;
+}
+#endif /* MBEDTLS_USE_PSA_CRYPTO || MBEDTLS_SSL_PROTO_TLS1_3 */
+
 /*
  * Setup an SSL context
  */
@@ -1397,7 +1925,11 @@ int mbedtls_ssl_setup(mbedtls_ssl_context *ssl,
 #if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
     ssl->in_buf_len = in_buf_len;
 #endif
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    ssl->in_buf = ssl_buffer_pool_get(conf->buffer_pool, 0, in_buf_len);
+#else
     ssl->in_buf = mbedtls_calloc(1, in_buf_len);
+#endif
     if (ssl->in_buf == NULL) {
         MBEDTLS_SSL_DEBUG_MSG(1, ("alloc(%" MBEDTLS_PRINTF_SIZET " bytes) failed", in_buf_len));
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
@@ -1407,7 +1939,11 @@ int mbedtls_ssl_setup(mbedtls_ssl_context *ssl,
 #if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
     ssl->out_buf_len = out_buf_len;
 #endif
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    ssl->out_buf = ssl_buffer_pool_get(conf->buffer_pool, 1, out_buf_len);
+#else
     ssl->out_buf = mbedtls_calloc(1, out_buf_len);
+#endif
     if (ssl->out_buf == NULL) {
         MBEDTLS_SSL_DEBUG_MSG(1, ("alloc(%" MBEDTLS_PRINTF_SIZET " bytes) failed", out_buf_len));
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
@@ -1518,6 +2054,7 @@ void mbedtls_ssl_session_reset_msg_layer(mbedtls_ssl_context *ssl,
     memset(ssl->out_buf, 0, out_buf_len);
     memset(ssl->cur_out_ctr, 0, sizeof(ssl->cur_out_ctr));
     ssl->transform_out = NULL;
+    ssl->dyn_record_sent = 0;
 
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
     mbedtls_ssl_dtls_replay_reset(ssl);
@@ -1555,6 +2092,12 @@ int mbedtls_ssl_session_reset_int(mbedtls_ssl_context *ssl, int partial)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if ((ret = mbedtls_ssl_acquire_buffers(ssl)) != 0) {
+        return ret;
+    }
+#endif
+
     mbedtls_ssl_handshake_set_state(ssl, MBEDTLS_SSL_HELLO_REQUEST);
     ssl->tls_version = ssl->conf->max_tls_version;
 
@@ -1732,6 +2275,22 @@ void mbedtls_ssl_conf_session_cache(mbedtls_ssl_config *conf,
 }
 #endif /* MBEDTLS_SSL_SRV_C */
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+void mbedtls_ssl_conf_buffer_pool(mbedtls_ssl_config *conf,
+                                  mbedtls_ssl_buffer_pool *pool)
+{
+    conf->buffer_pool = pool;
+}
+#endif /* MBEDTLS_SSL_BUFFER_POOL */
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+void mbedtls_ssl_conf_key_share_pool(mbedtls_ssl_config *conf,
+                                     mbedtls_ssl_key_share_pool *pool)
+{
+    conf->key_share_pool = pool;
+}
+#endif /* MBEDTLS_SSL_KEY_SHARE_POOL */
+
 #if defined(MBEDTLS_SSL_CLI_C)
 int mbedtls_ssl_set_session(mbedtls_ssl_context *ssl, const mbedtls_ssl_session *session)
 {
@@ -3008,6 +3567,21 @@ void mbedtls_ssl_conf_extended_master_secret(mbedtls_ssl_config *conf, char ems)
 }
 #endif
 
+void mbedtls_ssl_conf_write_batching(mbedtls_ssl_config *conf, char batching)
+{
+    conf->write_batching = batching;
+}
+
+void mbedtls_ssl_conf_dynamic_record_sizing(mbedtls_ssl_config *conf,
+                                            size_t initial_len,
+                                            size_t threshold,
+                                            uint32_t idle_timeout)
+{
+    conf->dyn_record_len       = initial_len;
+    conf->dyn_record_threshold = threshold;
+    conf->dyn_record_idle      = idle_timeout;
+}
+
 #if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
 int mbedtls_ssl_conf_max_frag_len(mbedtls_ssl_config *conf, unsigned char mfl_code)
 {
@@ -4523,7 +5097,7 @@ int mbedtls_ssl_session_load(mbedtls_ssl_session *session,
 MBEDTLS_CHECK_RETURN_CRITICAL
 static int ssl_prepare_handshake_step(mbedtls_ssl_context *ssl)
 {
-    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    int ret = 0;
 
     /*
      * We may have not been able to send to the peer all the handshake data
@@ -4539,8 +5113,13 @@ static int ssl_prepare_handshake_step(mbedtls_ssl_context *ssl)
      * peer. Data are only sent here and through
      * `mbedtls_ssl_handle_pending_alert` in case an error that triggered an
      * alert occurred.
+     * With TLS, the records of the current flight are only flushed here if
+     * the output buffer cannot take another one; otherwise they are all sent
+     * together before reading the peer's answer or at the end of the
+     * handshake.
      */
-    if ((ret = mbedtls_ssl_flush_output(ssl)) != 0) {
+    if (!mbedtls_ssl_hs_can_defer_flush(ssl) &&
+        (ret = mbedtls_ssl_flush_output(ssl)) != 0) {
         return ret;
     }
 
@@ -4764,6 +5343,13 @@ int mbedtls_ssl_renegotiate(mbedtls_ssl_context *ssl)
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if ((ret = mbedtls_ssl_acquire_buffers(ssl)) != 0) {
+        return ret;
+    }
+    ret = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+#endif
+
 #if defined(MBEDTLS_SSL_SRV_C)
     /* On server, just send the request */
     if (ssl->conf->endpoint == MBEDTLS_SSL_IS_SERVER) {
@@ -5077,7 +5663,7 @@ static const unsigned char ssl_serialized_context_header[] = {
  *  // fields from ssl_context
  *  uint32 badmac_seen_or_in_hsfraglen;         // DTLS: number of records with failing MAC
  *  uint64 in_window_top;       // DTLS: last validated record seq_num
- *  uint64 in_window;           // DTLS: bitmask for replay protection
+ *  uint64 in_window;           // DTLS: newest 64 bits of the replay window
  *  uint8 disable_datagram_packing; // DTLS: only one record per datagram
  *  uint64 cur_out_ctr;         // Record layer: outgoing sequence number
  *  uint16 mtu;                 // DTLS: path mtu (max outgoing fragment size)
@@ -5227,7 +5813,7 @@ int mbedtls_ssl_context_save(mbedtls_ssl_context *ssl,
         MBEDTLS_PUT_UINT64_BE(ssl->in_window_top, p, 0);
         p += 8;
 
-        MBEDTLS_PUT_UINT64_BE(ssl->in_window, p, 0);
+        MBEDTLS_PUT_UINT64_BE(mbedtls_ssl_dtls_replay_get_window(ssl), p, 0);
         p += 8;
     }
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
@@ -5455,11 +6041,9 @@ static int ssl_context_load(mbedtls_ssl_context *ssl,
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
-    ssl->in_window_top = MBEDTLS_GET_UINT64_BE(p, 0);
-    p += 8;
-
-    ssl->in_window = MBEDTLS_GET_UINT64_BE(p, 0);
-    p += 8;
+    mbedtls_ssl_dtls_replay_set_window(ssl, MBEDTLS_GET_UINT64_BE(p, 0),
+                                       MBEDTLS_GET_UINT64_BE(p, 8));
+    p += 16;
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
 
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
@@ -5588,7 +6172,11 @@ void mbedtls_ssl_free(mbedtls_ssl_context *ssl)
         size_t out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
 #endif
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+        ssl_buffer_pool_put(ssl->conf->buffer_pool, 1, ssl->out_buf, out_buf_len);
+#else
         mbedtls_zeroize_and_free(ssl->out_buf, out_buf_len);
+#endif
         ssl->out_buf = NULL;
     }
 
@@ -5599,7 +6187,11 @@ void mbedtls_ssl_free(mbedtls_ssl_context *ssl)
         size_t in_buf_len = MBEDTLS_SSL_IN_BUFFER_LEN;
 #endif
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+        ssl_buffer_pool_put(ssl->conf->buffer_pool, 0, ssl->in_buf, in_buf_len);
+#else
         mbedtls_zeroize_and_free(ssl->in_buf, in_buf_len);
+#endif
         ssl->in_buf = NULL;
     }
 
@@ -8969,6 +9561,10 @@ static int ssl_tls12_populate_transform(mbedtls_ssl_transform *transform,
             MBEDTLS_SSL_DEBUG_RET(1, "psa_import_key", ret);
             goto end;
         }
+
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+        mbedtls_ssl_transform_setup_keyed_aead(transform);
+#endif
     }
 #else
     if ((ret = mbedtls_cipher_setup(&transform->cipher_ctx_enc,
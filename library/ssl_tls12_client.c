@@ -2758,7 +2758,6 @@ static int ssl_write_client_key_exchange(mbedtls_ssl_context *ssl)
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
         psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
         psa_status_t destruction_status = PSA_ERROR_CORRUPTION_DETECTED;
-        psa_key_attributes_t key_attributes;
 
         mbedtls_ssl_handshake_params *handshake = ssl->handshake;
 
@@ -2776,34 +2775,21 @@ static int ssl_write_client_key_exchange(mbedtls_ssl_context *ssl)
          * such as ECDH with fixed KDFs such as TLS 1.2 PRF, it does not
          * yet support the provisioning of salt + label to the KDF.
          * For the time being, we therefore need to split the computation
-         * of the ECDH secret and the application of the TLS 1.2 PRF. */
-        key_attributes = psa_key_attributes_init();
-        psa_set_key_usage_flags(&key_attributes, PSA_KEY_USAGE_DERIVE);
-        psa_set_key_algorithm(&key_attributes, PSA_ALG_ECDH);
-        psa_set_key_type(&key_attributes, handshake->xxdh_psa_type);
-        psa_set_key_bits(&key_attributes, handshake->xxdh_psa_bits);
-
-        /* Generate ECDH private key. */
-        status = psa_generate_key(&key_attributes,
-                                  &handshake->xxdh_psa_privkey);
-        if (status != PSA_SUCCESS) {
-            return MBEDTLS_ERR_SSL_HW_ACCEL_FAILED;
-        }
-
-        /* Export the public part of the ECDH private key from PSA.
-         * The export format is an ECPoint structure as expected by TLS,
-         * but we just need to add a length byte before that. */
+         * of the ECDH secret and the application of the TLS 1.2 PRF.
+         *
+         * The key pair may also come ready from the key share pool.
+         * The export format of the public key is an ECPoint structure as
+         * expected by TLS, but we just need to add a length byte before
+         * that. */
         unsigned char *own_pubkey = ssl->out_msg + header_len + 1;
         unsigned char *end = ssl->out_msg + MBEDTLS_SSL_OUT_CONTENT_LEN;
         size_t own_pubkey_max_len = (size_t) (end - own_pubkey);
         size_t own_pubkey_len;
 
-        status = psa_export_public_key(handshake->xxdh_psa_privkey,
-                                       own_pubkey, own_pubkey_max_len,
-                                       &own_pubkey_len);
+        status = mbedtls_ssl_generate_xxdh_psa_key(ssl, PSA_ALG_ECDH,
+                                                   own_pubkey, own_pubkey_max_len,
+                                                   &own_pubkey_len);
         if (status != PSA_SUCCESS) {
-            psa_destroy_key(handshake->xxdh_psa_privkey);
-            handshake->xxdh_psa_privkey = MBEDTLS_SVC_KEY_ID_INIT;
             return MBEDTLS_ERR_SSL_HW_ACCEL_FAILED;
         }
 
@@ -2898,7 +2884,6 @@ ecdh_calc_secret:
     if (ciphersuite_info->key_exchange == MBEDTLS_KEY_EXCHANGE_ECDHE_PSK) {
         psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
         psa_status_t destruction_status = PSA_ERROR_CORRUPTION_DETECTED;
-        psa_key_attributes_t key_attributes;
 
         mbedtls_ssl_handshake_params *handshake = ssl->handshake;
 
@@ -2948,34 +2933,21 @@ ecdh_calc_secret:
          * such as ECDH with fixed KDFs such as TLS 1.2 PRF, it does not
          * yet support the provisioning of salt + label to the KDF.
          * For the time being, we therefore need to split the computation
-         * of the ECDH secret and the application of the TLS 1.2 PRF. */
-        key_attributes = psa_key_attributes_init();
-        psa_set_key_usage_flags(&key_attributes, PSA_KEY_USAGE_DERIVE);
-        psa_set_key_algorithm(&key_attributes, PSA_ALG_ECDH);
-        psa_set_key_type(&key_attributes, handshake->xxdh_psa_type);
-        psa_set_key_bits(&key_attributes, handshake->xxdh_psa_bits);
-
-        /* Generate ECDH private key. */
-        status = psa_generate_key(&key_attributes,
-                                  &handshake->xxdh_psa_privkey);
-        if (status != PSA_SUCCESS) {
-            return PSA_TO_MBEDTLS_ERR(status);
-        }
-
-        /* Export the public part of the ECDH private key from PSA.
-         * The export format is an ECPoint structure as expected by TLS,
-         * but we just need to add a length byte before that. */
+         * of the ECDH secret and the application of the TLS 1.2 PRF.
+         *
+         * The key pair may also come ready from the key share pool.
+         * The export format of the public key is an ECPoint structure as
+         * expected by TLS, but we just need to add a length byte before
+         * that. */
         unsigned char *own_pubkey = p + 1;
         unsigned char *end = ssl->out_msg + MBEDTLS_SSL_OUT_CONTENT_LEN;
         size_t own_pubkey_max_len = (size_t) (end - own_pubkey);
         size_t own_pubkey_len = 0;
 
-        status = psa_export_public_key(handshake->xxdh_psa_privkey,
-                                       own_pubkey, own_pubkey_max_len,
-                                       &own_pubkey_len);
+        status = mbedtls_ssl_generate_xxdh_psa_key(ssl, PSA_ALG_ECDH,
+                                                   own_pubkey, own_pubkey_max_len,
+                                                   &own_pubkey_len);
         if (status != PSA_SUCCESS) {
-            psa_destroy_key(handshake->xxdh_psa_privkey);
-            handshake->xxdh_psa_privkey = MBEDTLS_SVC_KEY_ID_INIT;
             return PSA_TO_MBEDTLS_ERR(status);
         }
 
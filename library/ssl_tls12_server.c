@@ -2753,7 +2753,7 @@ static int ssl_resume_server_key_exchange(mbedtls_ssl_context *ssl,
      * ssl_write_server_key_exchange also takes care of incrementing
      * ssl->out_msglen. */
     unsigned char *sig_start = ssl->out_msg + ssl->out_msglen + 2;
-    size_t sig_max_len = (ssl->out_buf + MBEDTLS_SSL_OUT_CONTENT_LEN
+    size_t sig_max_len = (ssl->out_msg + MBEDTLS_SSL_OUT_CONTENT_LEN
                           - sig_start);
     int ret = ssl->conf->f_async_resume(ssl,
                                         sig_start, signature_len, sig_max_len);
@@ -2973,7 +2973,6 @@ curve_matching_done:
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
         psa_status_t status = PSA_ERROR_GENERIC_ERROR;
-        psa_key_attributes_t key_attributes;
         mbedtls_ssl_handshake_params *handshake = ssl->handshake;
         uint8_t *p = ssl->out_msg + ssl->out_msglen;
         const size_t header_size = 4; // curve_type(1), namedcurve(2),
@@ -2994,12 +2993,6 @@ curve_matching_done:
         handshake->xxdh_psa_type = key_type;
         handshake->xxdh_psa_bits = ec_bits;
 
-        key_attributes = psa_key_attributes_init();
-        psa_set_key_usage_flags(&key_attributes, PSA_KEY_USAGE_DERIVE);
-        psa_set_key_algorithm(&key_attributes, PSA_ALG_ECDH);
-        psa_set_key_type(&key_attributes, handshake->xxdh_psa_type);
-        psa_set_key_bits(&key_attributes, handshake->xxdh_psa_bits);
-
         /*
          * ECParameters curve_params
          *
@@ -3013,15 +3006,6 @@ curve_matching_done:
         MBEDTLS_PUT_UINT16_BE(*curr_tls_id, p, 0);
         p += 2;
 
-        /* Generate ECDH private key. */
-        status = psa_generate_key(&key_attributes,
-                                  &handshake->xxdh_psa_privkey);
-        if (status != PSA_SUCCESS) {
-            ret = PSA_TO_MBEDTLS_ERR(status);
-            MBEDTLS_SSL_DEBUG_RET(1, "psa_generate_key", ret);
-            return ret;
-        }
-
         /*
          * ECPoint  public
          *
@@ -3029,22 +3013,21 @@ curve_matching_done:
          * It will be filled later. p holds now the data length location.
          */
 
-        /* Export the public part of the ECDH private key from PSA.
-         * Make one byte space for the length.
+        /* Generate the ECDH private key, or take one from the key share
+         * pool, and export its public part. Make one byte space for the
+         * length.
          */
         unsigned char *own_pubkey = p + data_length_size;
 
         size_t own_pubkey_max_len = (size_t) (MBEDTLS_SSL_OUT_CONTENT_LEN
                                               - (own_pubkey - ssl->out_msg));
 
-        status = psa_export_public_key(handshake->xxdh_psa_privkey,
-                                       own_pubkey, own_pubkey_max_len,
-                                       &len);
+        status = mbedtls_ssl_generate_xxdh_psa_key(ssl, PSA_ALG_ECDH,
+                                                   own_pubkey, own_pubkey_max_len,
+                                                   &len);
         if (status != PSA_SUCCESS) {
             ret = PSA_TO_MBEDTLS_ERR(status);
-            MBEDTLS_SSL_DEBUG_RET(1, "psa_export_public_key", ret);
-            (void) psa_destroy_key(handshake->xxdh_psa_privkey);
-            handshake->xxdh_psa_privkey = MBEDTLS_SVC_KEY_ID_INIT;
+            MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_generate_xxdh_psa_key", ret);
             return ret;
         }
 
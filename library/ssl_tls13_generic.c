@@ -1541,7 +1541,6 @@ int mbedtls_ssl_tls13_generate_and_write_xxdh_key_exchange(
 {
     psa_status_t status = PSA_ERROR_GENERIC_ERROR;
     int ret = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
-    psa_key_attributes_t key_attributes;
     size_t own_pubkey_len;
     mbedtls_ssl_handshake_params *handshake = ssl->handshake;
     size_t bits = 0;
@@ -1576,30 +1575,13 @@ int mbedtls_ssl_tls13_generate_and_write_xxdh_key_exchange(
     handshake->xxdh_psa_type = key_type;
     ssl->handshake->xxdh_psa_bits = bits;
 
-    key_attributes = psa_key_attributes_init();
-    psa_set_key_usage_flags(&key_attributes, PSA_KEY_USAGE_DERIVE);
-    psa_set_key_algorithm(&key_attributes, alg);
-    psa_set_key_type(&key_attributes, handshake->xxdh_psa_type);
-    psa_set_key_bits(&key_attributes, handshake->xxdh_psa_bits);
-
-    /* Generate ECDH/FFDH private key. */
-    status = psa_generate_key(&key_attributes,
-                              &handshake->xxdh_psa_privkey);
-    if (status != PSA_SUCCESS) {
-        ret = PSA_TO_MBEDTLS_ERR(status);
-        MBEDTLS_SSL_DEBUG_RET(1, "psa_generate_key", ret);
-        return ret;
-
-    }
-
-    /* Export the public part of the ECDH/FFDH private key from PSA. */
-    status = psa_export_public_key(handshake->xxdh_psa_privkey,
-                                   buf, buf_size,
-                                   &own_pubkey_len);
-
+    /* Generate ECDH/FFDH private key, or take an ECDH one from the key
+     * share pool, and export its public part. */
+    status = mbedtls_ssl_generate_xxdh_psa_key(ssl, alg, buf, buf_size,
+                                               &own_pubkey_len);
     if (status != PSA_SUCCESS) {
         ret = PSA_TO_MBEDTLS_ERR(status);
-        MBEDTLS_SSL_DEBUG_RET(1, "psa_export_public_key", ret);
+        MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_generate_xxdh_psa_key", ret);
         return ret;
     }
 
@@ -1083,6 +1083,10 @@ int mbedtls_ssl_tls13_populate_transform(
                 1, "psa_import_key", PSA_TO_MBEDTLS_ERR(status));
             return PSA_TO_MBEDTLS_ERR(status);
         }
+
+#if defined(MBEDTLS_SSL_TRANSFORM_KEYED_AEAD)
+        mbedtls_ssl_transform_setup_keyed_aead(transform);
+#endif
     }
 #endif /* MBEDTLS_USE_PSA_CRYPTO */
 
@@ -153,6 +153,12 @@ void mbedtls_threading_set_alt(void (*mutex_init)(mbedtls_threading_mutex_t *),
     mbedtls_mutex_init(&mbedtls_threading_psa_globaldata_mutex);
     mbedtls_mutex_init(&mbedtls_threading_psa_rngdata_mutex);
 #endif
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    mbedtls_mutex_init(&mbedtls_threading_ecp_group_cache_mutex);
+#endif
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+    mbedtls_mutex_init(&mbedtls_threading_ecp_pubkey_cache_mutex);
+#endif
 }
 
 /*
@@ -171,6 +177,12 @@ void mbedtls_threading_free_alt(void)
     mbedtls_mutex_free(&mbedtls_threading_psa_globaldata_mutex);
     mbedtls_mutex_free(&mbedtls_threading_psa_rngdata_mutex);
 #endif
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    mbedtls_mutex_free(&mbedtls_threading_ecp_group_cache_mutex);
+#endif
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+    mbedtls_mutex_free(&mbedtls_threading_ecp_pubkey_cache_mutex);
+#endif
 }
 #endif /* MBEDTLS_THREADING_ALT */
 
@@ -191,5 +203,11 @@ mbedtls_threading_mutex_t mbedtls_threading_key_slot_mutex MUTEX_INIT;
 mbedtls_threading_mutex_t mbedtls_threading_psa_globaldata_mutex MUTEX_INIT;
 mbedtls_threading_mutex_t mbedtls_threading_psa_rngdata_mutex MUTEX_INIT;
 #endif
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+mbedtls_threading_mutex_t mbedtls_threading_ecp_group_cache_mutex MUTEX_INIT;
+#endif
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+mbedtls_threading_mutex_t mbedtls_threading_ecp_pubkey_cache_mutex MUTEX_INIT;
+#endif
 
 #endif /* MBEDTLS_THREADING_C */
@@ -327,6 +327,12 @@ static const char * const features[] = {
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     "ECP_RESTARTABLE", //no-check-names
 #endif /* MBEDTLS_ECP_RESTARTABLE */
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    "ECP_GROUP_CACHE", //no-check-names
+#endif /* MBEDTLS_ECP_GROUP_CACHE */
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+    "ECP_PUBKEY_CACHE", //no-check-names
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE */
 #if defined(MBEDTLS_ECP_WITH_MPI_UINT)
     "ECP_WITH_MPI_UINT", //no-check-names
 #endif /* MBEDTLS_ECP_WITH_MPI_UINT */
@@ -459,6 +465,12 @@ static const char * const features[] = {
 #if defined(MBEDTLS_SSL_ASYNC_PRIVATE)
     "SSL_ASYNC_PRIVATE", //no-check-names
 #endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    "SSL_BUFFER_POOL", //no-check-names
+#endif /* MBEDTLS_SSL_BUFFER_POOL */
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+    "SSL_KEY_SHARE_POOL", //no-check-names
+#endif /* MBEDTLS_SSL_KEY_SHARE_POOL */
 #if defined(MBEDTLS_SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME)
     "SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME", //no-check-names
 #endif /* MBEDTLS_SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME */
@@ -561,6 +573,9 @@ static const char * const features[] = {
 #if defined(MBEDTLS_VERSION_FEATURES)
     "VERSION_FEATURES", //no-check-names
 #endif /* MBEDTLS_VERSION_FEATURES */
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    "X509_TRUSTED_CA_INDEX", //no-check-names
+#endif /* MBEDTLS_X509_TRUSTED_CA_INDEX */
 #if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
     "X509_TRUSTED_CERTIFICATE_CALLBACK", //no-check-names
 #endif /* MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK */
@@ -738,6 +753,9 @@ static const char * const features[] = {
 #if defined(MBEDTLS_SHA1_C)
     "SHA1_C", //no-check-names
 #endif /* MBEDTLS_SHA1_C */
+#if defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+    "SHA1_USE_X86_SHA_NI_IF_PRESENT", //no-check-names
+#endif /* MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT */
 #if defined(MBEDTLS_SHA224_C)
     "SHA224_C", //no-check-names
 #endif /* MBEDTLS_SHA224_C */
@@ -756,6 +774,9 @@ static const char * const features[] = {
 #if defined(MBEDTLS_SHA256_USE_A64_CRYPTO_ONLY)
     "SHA256_USE_A64_CRYPTO_ONLY", //no-check-names
 #endif /* MBEDTLS_SHA256_USE_A64_CRYPTO_ONLY */
+#if defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
+    "SHA256_USE_X86_SHA_NI_IF_PRESENT", //no-check-names
+#endif /* MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT */
 #if defined(MBEDTLS_SHA384_C)
     "SHA384_C", //no-check-names
 #endif /* MBEDTLS_SHA384_C */
@@ -777,6 +798,9 @@ static const char * const features[] = {
 #if defined(MBEDTLS_SSL_COOKIE_C)
     "SSL_COOKIE_C", //no-check-names
 #endif /* MBEDTLS_SSL_COOKIE_C */
+#if defined(MBEDTLS_SSL_DEMUX_C)
+    "SSL_DEMUX_C", //no-check-names
+#endif /* MBEDTLS_SSL_DEMUX_C */
 #if defined(MBEDTLS_SSL_TICKET_C)
     "SSL_TICKET_C", //no-check-names
 #endif /* MBEDTLS_SSL_TICKET_C */
@@ -369,6 +369,138 @@ static int x509_name_cmp(const mbedtls_x509_name *a, const mbedtls_x509_name *b)
     return 0;
 }
 
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+/*
+ * FNV-1a over a byte buffer, continuing from hash h.
+ */
+static uint32_t x509_hash_update(uint32_t h, const unsigned char *p, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x01000193;
+    }
+
+    return h;
+}
+
+/*
+ * Hash an X.509 Name so that names that x509_name_cmp() considers equal
+ * have the same hash: UTF8String and PrintableString values are hashed
+ * without their tag and with ASCII letters folded to lower case.
+ */
+static uint32_t x509_name_hash(const mbedtls_x509_name *name)
+{
+    uint32_t h = 0x811c9dc5;
+    unsigned char tmp[4];
+    unsigned char c;
+    size_t i;
+
+    for (; name != NULL; name = name->next) {
+        tmp[0] = (unsigned char) name->oid.tag;
+        tmp[1] = (unsigned char) name->next_merged;
+        h = x509_hash_update(h, tmp, 2);
+        h = x509_hash_update(h, name->oid.p, name->oid.len);
+
+        if (name->val.tag == MBEDTLS_ASN1_UTF8_STRING ||
+            name->val.tag == MBEDTLS_ASN1_PRINTABLE_STRING) {
+            for (i = 0; i < name->val.len; i++) {
+                c = name->val.p[i];
+                if (c >= 'A' && c <= 'Z') {
+                    c |= 0x20;
+                }
+                h = x509_hash_update(h, &c, 1);
+            }
+        } else {
+            tmp[0] = (unsigned char) name->val.tag;
+            h = x509_hash_update(h, tmp, 1);
+            h = x509_hash_update(h, name->val.p, name->val.len);
+        }
+
+        MBEDTLS_PUT_UINT32_BE(name->val.len, tmp, 0);
+        h = x509_hash_update(h, tmp, 4);
+    }
+
+    return h;
+}
+
+/*
+ * Release the index of a chain, if any.
+ */
+static void x509_crt_ca_index_free(mbedtls_x509_crt *chain)
+{
+    mbedtls_x509_crt *cur;
+
+    if (chain->ca_index == NULL) {
+        return;
+    }
+
+    mbedtls_free(chain->ca_index);
+    chain->ca_index = NULL;
+    chain->ca_index_size = 0;
+
+    for (cur = chain; cur != NULL; cur = cur->next) {
+        cur->ca_index_next = NULL;
+    }
+}
+
+int mbedtls_x509_crt_build_ca_index(mbedtls_x509_crt *chain)
+{
+    mbedtls_x509_crt *cur, **link;
+    size_t count = 0, size = 1;
+
+    x509_crt_ca_index_free(chain);
+
+    for (cur = chain; cur != NULL && cur->version != 0; cur = cur->next) {
+        count++;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    /* Keep the load factor at most 1/2 */
+    while (size < 2 * count) {
+        size *= 2;
+    }
+
+    chain->ca_index = mbedtls_calloc(size, sizeof(mbedtls_x509_crt *));
+    if (chain->ca_index == NULL) {
+        return MBEDTLS_ERR_X509_ALLOC_FAILED;
+    }
+    chain->ca_index_size = size;
+
+    /* Append each certificate to its bucket, so that the buckets list the
+     * certificates in the same order as the chain. */
+    for (cur = chain; cur != NULL && cur->version != 0; cur = cur->next) {
+        cur->subject_hash = x509_name_hash(&cur->subject);
+        cur->ca_index_next = NULL;
+
+        link = &chain->ca_index[cur->subject_hash & (size - 1)];
+        while (*link != NULL) {
+            link = &(*link)->ca_index_next;
+        }
+        *link = cur;
+    }
+
+    return 0;
+}
+
+/*
+ * Skip the certificates of an index bucket whose subject hash differs.
+ */
+static mbedtls_x509_crt *x509_crt_ca_index_skip(mbedtls_x509_crt *cur,
+                                                uint32_t name_hash)
+{
+    while (cur != NULL && cur->subject_hash != name_hash) {
+        cur = cur->ca_index_next;
+    }
+
+    return cur;
+}
+#endif /* MBEDTLS_X509_TRUSTED_CA_INDEX */
+
 /*
  * Reset (init or clear) a verify_chain
  */
@@ -1327,6 +1459,11 @@ static int mbedtls_x509_crt_parse_der_internal(mbedtls_x509_crt *chain,
         return MBEDTLS_ERR_X509_BAD_INPUT_DATA;
     }
 
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    /* The index would not cover the new certificate */
+    x509_crt_ca_index_free(chain);
+#endif
+
     while (crt->version != 0 && crt->next != NULL) {
         prev = crt;
         crt = crt->next;
@@ -2208,6 +2345,63 @@ static int x509_crt_check_parent(const mbedtls_x509_crt *child,
     return 0;
 }
 
+/*
+ * First and next candidates for find_parent_in(). If candidates is an
+ * indexed chain, only visit the certificates filed under the issuer name
+ * (whose hash is name_hash), otherwise visit the whole list. Either way,
+ * the certificates are visited in chain order.
+ */
+static mbedtls_x509_crt *x509_crt_first_candidate(mbedtls_x509_crt *candidates,
+                                                  uint32_t name_hash)
+{
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    if (candidates != NULL && candidates->ca_index != NULL) {
+        return x509_crt_ca_index_skip(
+            candidates->ca_index[name_hash & (candidates->ca_index_size - 1)],
+            name_hash);
+    }
+#else
+    (void) name_hash;
+#endif
+
+    return candidates;
+}
+
+static mbedtls_x509_crt *x509_crt_next_candidate(const mbedtls_x509_crt *candidates,
+                                                 const mbedtls_x509_crt *cur,
+                                                 uint32_t name_hash)
+{
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    if (candidates->ca_index != NULL) {
+        return x509_crt_ca_index_skip(cur->ca_index_next, name_hash);
+    }
+#else
+    (void) candidates;
+    (void) name_hash;
+#endif
+
+    return cur->next;
+}
+
+/*
+ * Hash of the issuer name of child, if it is needed to look up candidates
+ * in an indexed chain, or 0 otherwise.
+ */
+static uint32_t x509_crt_issuer_hash(const mbedtls_x509_crt *child,
+                                     const mbedtls_x509_crt *candidates)
+{
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    if (candidates != NULL && candidates->ca_index != NULL) {
+        return x509_name_hash(&child->issuer);
+    }
+#else
+    (void) child;
+    (void) candidates;
+#endif
+
+    return 0;
+}
+
 /*
  * Find a suitable parent for child in candidates, or return NULL.
  *
@@ -2265,6 +2459,7 @@ static int x509_crt_find_parent_in(
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     mbedtls_x509_crt *parent, *fallback_parent;
     int signature_is_good = 0, fallback_signature_is_good;
+    uint32_t issuer_hash = x509_crt_issuer_hash(child, candidates);
 
 #if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_RESTARTABLE)
     /* did we have something in progress? */
@@ -2287,7 +2482,9 @@ static int x509_crt_find_parent_in(
     fallback_parent = NULL;
     fallback_signature_is_good = 0;
 
-    for (parent = candidates; parent != NULL; parent = parent->next) {
+    for (parent = x509_crt_first_candidate(candidates, issuer_hash);
+         parent != NULL;
+         parent = x509_crt_next_candidate(candidates, parent, issuer_hash)) {
         /* basic parenting skills (name, CA bit, key usage) */
         if (x509_crt_check_parent(child, parent, top) != 0) {
             continue;
@@ -2445,14 +2642,19 @@ static int x509_crt_check_ee_locally_trusted(
     mbedtls_x509_crt *trust_ca)
 {
     mbedtls_x509_crt *cur;
+    uint32_t name_hash;
 
     /* must be self-issued */
     if (x509_name_cmp(&crt->issuer, &crt->subject) != 0) {
         return -1;
     }
 
-    /* look for an exact match with trusted cert */
-    for (cur = trust_ca; cur != NULL; cur = cur->next) {
+    /* look for an exact match with trusted cert (which then has the same
+     * subject, so only certificates filed under that name need checking) */
+    name_hash = x509_crt_issuer_hash(crt, trust_ca);
+    for (cur = x509_crt_first_candidate(trust_ca, name_hash);
+         cur != NULL;
+         cur = x509_crt_next_candidate(trust_ca, cur, name_hash)) {
         if (crt->raw.len == cur->raw.len &&
             memcmp(crt->raw.p, cur->raw.p, crt->raw.len) == 0) {
             return 0;
@@ -3231,6 +3433,12 @@ void mbedtls_x509_crt_free(mbedtls_x509_crt *crt)
     mbedtls_x509_crt *cert_cur = crt;
     mbedtls_x509_crt *cert_prv;
 
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    if (crt != NULL) {
+        mbedtls_free(crt->ca_index);
+    }
+#endif
+
     while (cert_cur != NULL) {
         mbedtls_pk_free(&cert_cur->pk);
 
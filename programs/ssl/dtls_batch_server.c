@@ -0,0 +1,750 @@
+/*
+ *  DTLS server demonstration program serving many clients from a single
+ *  UDP socket, with batched datagram I/O
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/platform.h"
+
+#if !defined(MBEDTLS_ENTROPY_C) || !defined(MBEDTLS_CTR_DRBG_C) ||      \
+    !defined(MBEDTLS_NET_C) || !defined(MBEDTLS_SSL_SRV_C) ||           \
+    !defined(MBEDTLS_TIMING_C) || !defined(MBEDTLS_SSL_PROTO_DTLS) ||   \
+    !defined(MBEDTLS_SSL_COOKIE_C) || !defined(MBEDTLS_SSL_DEMUX_C) ||  \
+    !defined(MBEDTLS_PEM_PARSE_C) || !defined(MBEDTLS_X509_CRT_PARSE_C)
+int main(void)
+{
+    mbedtls_printf("MBEDTLS_ENTROPY_C and/or MBEDTLS_CTR_DRBG_C and/or "
+                   "MBEDTLS_NET_C and/or MBEDTLS_SSL_SRV_C and/or "
+                   "MBEDTLS_TIMING_C and/or MBEDTLS_SSL_PROTO_DTLS and/or "
+                   "MBEDTLS_SSL_COOKIE_C and/or MBEDTLS_SSL_DEMUX_C and/or "
+                   "MBEDTLS_PEM_PARSE_C and/or MBEDTLS_X509_CRT_PARSE_C "
+                   "not defined.\n");
+    mbedtls_exit(0);
+}
+#else
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <signal.h>
+
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cookie.h"
+#include "mbedtls/ssl_demux.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/error.h"
+#include "mbedtls/debug.h"
+#include "mbedtls/timing.h"
+
+#include "test/certs.h"
+
+#define DFL_SERVER_ADDR         NULL
+#define DFL_SERVER_PORT         "4433"
+#define DFL_DEBUG_LEVEL         0
+#define DFL_BATCH               32
+#define DFL_MAX_CONNECTIONS     1000
+#define DFL_IDLE_TIMEOUT        30
+#define DFL_REPORT_INTERVAL     1
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+#define DFL_CID_LEN             4
+#else
+#define DFL_CID_LEN             0
+#endif
+
+#define POLL_TIMEOUT_MS         50      /* also the retransmission timer tick */
+#define DGRAM_BUF_LEN           (MBEDTLS_SSL_IN_CONTENT_LEN + 512)
+#define OUT_ARENA_LEN           (64 * 1024)
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+#define USAGE_CID \
+    "    cid_len=%%d          default: 4 (length of the connection IDs\n"    \
+    "                        given to clients, 0: route by address only)\n"
+#else
+#define USAGE_CID ""
+#endif
+
+#define USAGE \
+    "\n usage: dtls_batch_server param=<>...\n"                               \
+    "\n acceptable parameters:\n"                                             \
+    "    server_addr=%%s      default: (all interfaces)\n"                    \
+    "    server_port=%%d      default: " DFL_SERVER_PORT "\n"                 \
+    "    debug_level=%%d      default: 0 (disabled)\n"                        \
+    "    batch=%%d            default: 32 (datagrams per system call,\n"      \
+    "                        1 to 64)\n"                                      \
+    "    max_connections=%%d  default: 1000\n"                                \
+    "    idle_timeout=%%d     default: 30 (seconds before an idle client\n"   \
+    "                        is forgotten)\n"                                 \
+    "    report_interval=%%d  default: 1 (seconds between reports, 0: none)\n" \
+    USAGE_CID                                                                 \
+    "\n"
+
+/*
+ * global options
+ */
+struct options {
+    const char *server_addr;    /* address on which the ssl service runs    */
+    const char *server_port;    /* port on which the ssl service runs       */
+    int debug_level;            /* level of debugging                       */
+    int batch;                  /* datagrams per recv/send system call      */
+    int max_connections;        /* maximum number of known clients          */
+    int idle_timeout;           /* seconds before an idle client is dropped */
+    int report_interval;        /* seconds between two statistics reports   */
+    int cid_len;                /* length of our connection IDs, or 0       */
+} opt;
+
+typedef struct dtls_server dtls_server;
+
+/*
+ * One client, found by the demultiplexer from its connection ID or address
+ */
+typedef struct dtls_conn {
+    mbedtls_ssl_context ssl;
+    mbedtls_timing_delay_context timer;
+    dtls_server *server;
+    struct dtls_conn *prev, *next;      /* list of all the clients          */
+    const mbedtls_net_datagram *in;     /* datagram being fed, or NULL      */
+    unsigned long last_active;          /* ms timestamp of the last input   */
+    int handshake_done;
+    unsigned char addr[MBEDTLS_NET_ADDR_MAX_LEN]; /* current address     */
+    size_t addr_len;
+} dtls_conn;
+
+struct dtls_server {
+    mbedtls_net_context sock;
+    mbedtls_ssl_config *conf;
+    struct mbedtls_timing_hr_time clock;
+
+    mbedtls_ssl_demux_context demux;
+    dtls_conn *conns;
+    size_t conn_count;
+
+    /* Datagrams written by the connections, sent in one batch */
+    mbedtls_net_datagram out[MBEDTLS_NET_BATCH_MAX];
+    size_t out_count;
+    unsigned char out_arena[OUT_ARENA_LEN];
+    size_t out_used;
+
+    /* Statistics since the last report */
+    unsigned long dgrams_in, dgrams_out;
+    unsigned long recv_calls, send_calls;
+    unsigned long handshakes, messages, errors;
+};
+
+static volatile sig_atomic_t received_sigint = 0;
+
+static void handle_sigint(int sig)
+{
+    ((void) sig);
+    received_sigint = 1;
+}
+
+static void my_debug(void *ctx, int level,
+                     const char *file, int line,
+                     const char *str)
+{
+    ((void) level);
+
+    mbedtls_fprintf((FILE *) ctx, "%s:%04d: %s", file, line, str);
+    fflush((FILE *) ctx);
+}
+
+static unsigned long now_ms(dtls_server *srv)
+{
+    return mbedtls_timing_get_timer(&srv->clock, 0);
+}
+
+static void conn_remove(dtls_server *srv, dtls_conn *conn)
+{
+    (void) mbedtls_ssl_demux_remove(&srv->demux, &conn->ssl);
+
+    if (conn->prev != NULL) {
+        conn->prev->next = conn->next;
+    } else {
+        srv->conns = conn->next;
+    }
+    if (conn->next != NULL) {
+        conn->next->prev = conn->prev;
+    }
+    srv->conn_count--;
+
+    mbedtls_ssl_free(&conn->ssl);
+    mbedtls_free(conn);
+}
+
+/*
+ * Send all the queued datagrams. UDP is lossy anyway, so datagrams that
+ * cannot be sent are dropped rather than queued further.
+ */
+static void flush_out(dtls_server *srv)
+{
+    size_t sent = 0;
+    int ret;
+
+    while (sent < srv->out_count) {
+        ret = mbedtls_net_send_batch(&srv->sock, srv->out + sent, srv->out_count - sent);
+        srv->send_calls++;
+        if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            if (mbedtls_net_poll(&srv->sock, MBEDTLS_NET_POLL_WRITE, POLL_TIMEOUT_MS) > 0) {
+                continue;
+            }
+        }
+        if (ret < 0) {
+            /* Skip the datagram that failed, e.g. with an unreachable peer */
+            srv->errors++;
+            ret = 1;
+        }
+        sent += (size_t) ret;
+    }
+
+    srv->dgrams_out += srv->out_count;
+    srv->out_count = 0;
+    srv->out_used = 0;
+}
+
+/*
+ * BIO callbacks: input comes from the datagram being dispatched, output
+ * is queued for the next batch
+ */
+static int conn_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    dtls_conn *conn = (dtls_conn *) ctx;
+    dtls_server *srv = conn->server;
+    mbedtls_net_datagram *d;
+
+    if (len > OUT_ARENA_LEN) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (srv->out_count == (size_t) opt.batch || len > OUT_ARENA_LEN - srv->out_used) {
+        flush_out(srv);
+    }
+
+    d = &srv->out[srv->out_count++];
+    d->buf = srv->out_arena + srv->out_used;
+    d->len = len;
+    memcpy(d->buf, buf, len);
+    memcpy(d->addr, conn->addr, conn->addr_len);
+    d->addr_len = conn->addr_len;
+    srv->out_used += len;
+
+    return (int) len;
+}
+
+static int conn_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    dtls_conn *conn = (dtls_conn *) ctx;
+    const mbedtls_net_datagram *d = conn->in;
+
+    if (d == NULL) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    conn->in = NULL;
+    if (d->len > len) {
+        /* Truncated: DTLS drops the partial record */
+        memcpy(buf, d->buf, len);
+        return (int) len;
+    }
+
+    memcpy(buf, d->buf, d->len);
+    return (int) d->len;
+}
+
+static dtls_conn *conn_new(dtls_server *srv, const mbedtls_net_datagram *d)
+{
+    dtls_conn *conn;
+
+    /* Only a ClientHello can start a connection. Anything else is a stray
+     * record from a forgotten client, or noise. */
+    if (d->len < 13 || d->buf[0] != MBEDTLS_SSL_MSG_HANDSHAKE ||
+        srv->conn_count >= (size_t) opt.max_connections) {
+        return NULL;
+    }
+
+    conn = mbedtls_calloc(1, sizeof(*conn));
+    if (conn == NULL) {
+        return NULL;
+    }
+
+    mbedtls_ssl_init(&conn->ssl);
+    conn->server = srv;
+    memcpy(conn->addr, d->addr, d->addr_len);
+    conn->addr_len = d->addr_len;
+
+    if (mbedtls_ssl_setup(&conn->ssl, srv->conf) != 0 ||
+        /* For HelloVerifyRequest cookies */
+        mbedtls_ssl_set_client_transport_id(&conn->ssl, conn->addr, conn->addr_len) != 0 ||
+        /* Also gives the client its connection ID */
+        mbedtls_ssl_demux_add(&srv->demux, &conn->ssl, conn, conn->addr, conn->addr_len) != 0) {
+        mbedtls_ssl_free(&conn->ssl);
+        mbedtls_free(conn);
+        return NULL;
+    }
+
+    mbedtls_ssl_set_bio(&conn->ssl, conn, conn_send, conn_recv, NULL);
+    mbedtls_ssl_set_timer_cb(&conn->ssl, &conn->timer, mbedtls_timing_set_delay,
+                             mbedtls_timing_get_delay);
+
+    conn->next = srv->conns;
+    if (srv->conns != NULL) {
+        srv->conns->prev = conn;
+    }
+    srv->conns = conn;
+    srv->conn_count++;
+
+    return conn;
+}
+
+/*
+ * Let a connection make progress: handshake, then echo every message.
+ * Returns MBEDTLS_ERR_SSL_WANT_READ while the connection is alive.
+ */
+static int conn_step(dtls_conn *conn)
+{
+    unsigned char buf[1024];
+    int ret;
+
+    while (1) {
+        if (!conn->handshake_done) {
+            ret = mbedtls_ssl_handshake(&conn->ssl);
+            if (ret != 0) {
+                return ret;
+            }
+            conn->handshake_done = 1;
+            conn->server->handshakes++;
+        }
+
+        ret = mbedtls_ssl_read(&conn->ssl, buf, sizeof(buf));
+        if (ret == MBEDTLS_ERR_SSL_CLIENT_RECONNECT) {
+            /* The context was reset for a new handshake with the same
+             * client, starting from the ClientHello just received */
+            conn->handshake_done = 0;
+            continue;
+        }
+        if (ret <= 0) {
+            return ret == 0 ? MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY : ret;
+        }
+
+        conn->server->messages++;
+        ret = mbedtls_ssl_write(&conn->ssl, buf, (size_t) ret);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+}
+
+static void conn_handle_result(dtls_server *srv, dtls_conn *conn, int ret)
+{
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return;
+    }
+
+    if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+        mbedtls_ssl_close_notify(&conn->ssl);
+    } else if (ret != MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
+        /* A client that did not verify its address is simply forgotten,
+         * the cookie makes it come back with a new context */
+        if (opt.debug_level > 0) {
+            mbedtls_printf("  ! connection failed: -0x%04x\n", (unsigned int) -ret);
+        }
+        srv->errors++;
+    }
+
+    conn_remove(srv, conn);
+}
+
+/*
+ * Feed one received datagram to its connection
+ */
+static void dispatch(dtls_server *srv, const mbedtls_net_datagram *d)
+{
+    dtls_conn *conn;
+    void *p_user = NULL;
+    int ret;
+
+    ret = mbedtls_ssl_demux_lookup(&srv->demux, d->buf, d->len, d->addr, d->addr_len,
+                                   &p_user);
+    conn = (dtls_conn *) p_user;
+    if (ret == MBEDTLS_ERR_SSL_DEMUX_ENTRY_NOT_FOUND) {
+        if ((conn = conn_new(srv, d)) == NULL) {
+            return;
+        }
+    } else if (ret != 0) {
+        /* Not authentic: someone else's record, or a forgery */
+        srv->errors++;
+        return;
+    } else if (conn->addr_len != d->addr_len ||
+               memcmp(conn->addr, d->addr, d->addr_len) != 0) {
+        /* The client moved, e.g. after a NAT rebinding: answer there */
+        memcpy(conn->addr, d->addr, d->addr_len);
+        conn->addr_len = d->addr_len;
+    }
+
+    conn->in = d;
+    conn->last_active = now_ms(srv);
+    conn_handle_result(srv, conn, conn_step(conn));
+}
+
+/*
+ * Retransmit the flights whose timer expired and forget idle clients
+ */
+static void check_timers(dtls_server *srv)
+{
+    unsigned long now = now_ms(srv);
+    dtls_conn *conn, *next;
+
+    for (conn = srv->conns; conn != NULL; conn = next) {
+        next = conn->next;
+
+        if (now - conn->last_active > (unsigned long) opt.idle_timeout * 1000) {
+            conn_remove(srv, conn);
+        } else if (!conn->handshake_done &&
+                   mbedtls_timing_get_delay(&conn->timer) == 2) {
+            conn_handle_result(srv, conn, conn_step(conn));
+        }
+    }
+}
+
+static void report(dtls_server *srv, unsigned long elapsed_ms)
+{
+    double seconds = elapsed_ms / 1000.0;
+
+    mbedtls_printf("  . %8.0f dgram/s in (%5.1f per call) %8.0f dgram/s out "
+                   "(%5.1f per call) %6.0f hs/s %8.0f msg/s %6lu clients %lu errors\n",
+                   srv->dgrams_in / seconds,
+                   srv->recv_calls ? (double) srv->dgrams_in / srv->recv_calls : 0.0,
+                   srv->dgrams_out / seconds,
+                   srv->send_calls ? (double) srv->dgrams_out / srv->send_calls : 0.0,
+                   srv->handshakes / seconds, srv->messages / seconds,
+                   (unsigned long) srv->conn_count, srv->errors);
+    fflush(stdout);
+
+    srv->dgrams_in = srv->dgrams_out = 0;
+    srv->recv_calls = srv->send_calls = 0;
+    srv->handshakes = srv->messages = srv->errors = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int ret = 1, i, n;
+    int exit_code = MBEDTLS_EXIT_FAILURE;
+    const char *pers = "dtls_batch_server";
+    char *p, *q;
+    unsigned long last_report, now;
+    dtls_server *srv = NULL;
+    mbedtls_net_datagram in[MBEDTLS_NET_BATCH_MAX];
+    unsigned char *in_bufs = NULL;
+    mbedtls_ssl_cookie_ctx cookie_ctx;
+
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt srvcert;
+    mbedtls_pk_context pkey;
+
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ssl_cookie_init(&cookie_ctx);
+    mbedtls_x509_crt_init(&srvcert);
+    mbedtls_pk_init(&pkey);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+
+#if defined(MBEDTLS_USE_PSA_CRYPTO)
+    psa_status_t status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        mbedtls_fprintf(stderr, "Failed to initialize PSA Crypto implementation: %d\n",
+                        (int) status);
+        goto exit;
+    }
+#endif /* MBEDTLS_USE_PSA_CRYPTO */
+
+    opt.server_addr         = DFL_SERVER_ADDR;
+    opt.server_port         = DFL_SERVER_PORT;
+    opt.debug_level         = DFL_DEBUG_LEVEL;
+    opt.batch               = DFL_BATCH;
+    opt.max_connections     = DFL_MAX_CONNECTIONS;
+    opt.idle_timeout        = DFL_IDLE_TIMEOUT;
+    opt.report_interval     = DFL_REPORT_INTERVAL;
+    opt.cid_len             = DFL_CID_LEN;
+
+    for (i = 1; i < argc; i++) {
+        p = argv[i];
+        if ((q = strchr(p, '=')) == NULL) {
+            goto usage;
+        }
+        *q++ = '\0';
+
+        if (strcmp(p, "server_addr") == 0) {
+            opt.server_addr = q;
+        } else if (strcmp(p, "server_port") == 0) {
+            opt.server_port = q;
+        } else if (strcmp(p, "debug_level") == 0) {
+            opt.debug_level = atoi(q);
+            if (opt.debug_level < 0 || opt.debug_level > 65535) {
+                goto usage;
+            }
+        } else if (strcmp(p, "batch") == 0) {
+            opt.batch = atoi(q);
+            if (opt.batch < 1 || opt.batch > MBEDTLS_NET_BATCH_MAX) {
+                goto usage;
+            }
+        } else if (strcmp(p, "max_connections") == 0) {
+            opt.max_connections = atoi(q);
+            if (opt.max_connections < 1) {
+                goto usage;
+            }
+        } else if (strcmp(p, "idle_timeout") == 0) {
+            opt.idle_timeout = atoi(q);
+            if (opt.idle_timeout < 1) {
+                goto usage;
+            }
+        } else if (strcmp(p, "report_interval") == 0) {
+            opt.report_interval = atoi(q);
+            if (opt.report_interval < 0) {
+                goto usage;
+            }
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+        } else if (strcmp(p, "cid_len") == 0) {
+            opt.cid_len = atoi(q);
+            if (opt.cid_len < 0 || opt.cid_len > MBEDTLS_SSL_CID_IN_LEN_MAX) {
+                goto usage;
+            }
+#endif
+        } else {
+usage:
+            mbedtls_printf(USAGE);
+            goto exit;
+        }
+    }
+
+#if defined(MBEDTLS_DEBUG_C)
+    mbedtls_debug_set_threshold(opt.debug_level);
+#endif
+
+    srv = mbedtls_calloc(1, sizeof(*srv));
+    in_bufs = mbedtls_calloc((size_t) opt.batch, DGRAM_BUF_LEN);
+    if (srv == NULL || in_bufs == NULL) {
+        mbedtls_printf(" failed!  out of memory\n\n");
+        goto exit;
+    }
+    mbedtls_net_init(&srv->sock);
+    mbedtls_ssl_demux_init(&srv->demux);
+    srv->conf = &conf;
+
+    signal(SIGINT, handle_sigint);
+
+    /*
+     * 1. Seed the RNG
+     */
+    mbedtls_printf("  . Seeding the random number generator...");
+    fflush(stdout);
+
+    if ((ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
+                                     (const unsigned char *) pers,
+                                     strlen(pers))) != 0) {
+        mbedtls_printf(" failed\n  ! mbedtls_ctr_drbg_seed returned %d\n", ret);
+        goto exit;
+    }
+
+    mbedtls_printf(" ok\n");
+
+    /*
+     * 2. Load the certificates and private key
+     */
+    mbedtls_printf("  . Loading the server cert. and key...");
+    fflush(stdout);
+
+    /*
+     * This demonstration program uses embedded test certificates.
+     * Instead, you may want to use mbedtls_x509_crt_parse_file() to read the
+     * server and CA certificates, as well as mbedtls_pk_parse_keyfile().
+     */
+    ret = mbedtls_x509_crt_parse(&srvcert, (const unsigned char *) mbedtls_test_srv_crt,
+                                 mbedtls_test_srv_crt_len);
+    if (ret != 0) {
+        mbedtls_printf(" failed\n  !  mbedtls_x509_crt_parse returned %d\n\n", ret);
+        goto exit;
+    }
+
+    ret = mbedtls_x509_crt_parse(&srvcert, (const unsigned char *) mbedtls_test_cas_pem,
+                                 mbedtls_test_cas_pem_len);
+    if (ret != 0) {
+        mbedtls_printf(" failed\n  !  mbedtls_x509_crt_parse returned %d\n\n", ret);
+        goto exit;
+    }
+
+    ret =  mbedtls_pk_parse_key(&pkey, (const unsigned char *) mbedtls_test_srv_key,
+                                mbedtls_test_srv_key_len, NULL, 0,
+                                mbedtls_ctr_drbg_random, &ctr_drbg);
+    if (ret != 0) {
+        mbedtls_printf(" failed\n  !  mbedtls_pk_parse_key returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_printf(" ok\n");
+
+    /*
+     * 3. Setup the UDP socket shared by all clients
+     */
+    mbedtls_printf("  . Bind on udp/%s/%s ...",
+                   opt.server_addr != NULL ? opt.server_addr : "*", opt.server_port);
+    fflush(stdout);
+
+    if ((ret = mbedtls_net_bind(&srv->sock, opt.server_addr, opt.server_port,
+                                MBEDTLS_NET_PROTO_UDP)) != 0) {
+        mbedtls_printf(" failed\n  ! mbedtls_net_bind returned %d\n\n", ret);
+        goto exit;
+    }
+
+    if ((ret = mbedtls_net_set_nonblock(&srv->sock)) != 0) {
+        mbedtls_printf(" failed\n  ! mbedtls_net_set_nonblock returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_printf(" ok\n");
+
+    /*
+     * 4. Setup stuff
+     */
+    mbedtls_printf("  . Setting up the DTLS data...");
+    fflush(stdout);
+
+    if ((ret = mbedtls_ssl_config_defaults(&conf,
+                                           MBEDTLS_SSL_IS_SERVER,
+                                           MBEDTLS_SSL_TRANSPORT_DATAGRAM,
+                                           MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+        mbedtls_printf(" failed\n  ! mbedtls_ssl_config_defaults returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+    mbedtls_ssl_conf_dbg(&conf, my_debug, stdout);
+
+    mbedtls_ssl_conf_ca_chain(&conf, srvcert.next, NULL);
+    if ((ret = mbedtls_ssl_conf_own_cert(&conf, &srvcert, &pkey)) != 0) {
+        mbedtls_printf(" failed\n  ! mbedtls_ssl_conf_own_cert returned %d\n\n", ret);
+        goto exit;
+    }
+
+    if ((ret = mbedtls_ssl_cookie_setup(&cookie_ctx,
+                                        mbedtls_ctr_drbg_random, &ctr_drbg)) != 0) {
+        mbedtls_printf(" failed\n  ! mbedtls_ssl_cookie_setup returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_ssl_conf_dtls_cookies(&conf, mbedtls_ssl_cookie_write, mbedtls_ssl_cookie_check,
+                                  &cookie_ctx);
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+    if ((ret = mbedtls_ssl_conf_cid(&conf, (size_t) opt.cid_len,
+                                    MBEDTLS_SSL_UNEXPECTED_CID_IGNORE)) != 0) {
+        mbedtls_printf(" failed\n  ! mbedtls_ssl_conf_cid returned %d\n\n", ret);
+        goto exit;
+    }
+#endif
+
+    if ((ret = mbedtls_ssl_demux_setup(&srv->demux, (size_t) opt.cid_len,
+                                       mbedtls_ctr_drbg_random, &ctr_drbg)) != 0) {
+        mbedtls_printf(" failed\n  ! mbedtls_ssl_demux_setup returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_printf(" ok\n");
+
+    /*
+     * 5. Event loop: receive a batch, feed each datagram to its client,
+     *    then send everything the clients wrote in one batch
+     */
+    mbedtls_printf("  . Serving clients, press Ctrl-C to stop\n");
+    fflush(stdout);
+
+    for (i = 0; i < opt.batch; i++) {
+        in[i].buf = in_bufs + (size_t) i * DGRAM_BUF_LEN;
+        in[i].size = DGRAM_BUF_LEN;
+    }
+
+    (void) mbedtls_timing_get_timer(&srv->clock, 1);
+    last_report = 0;
+
+    while (!received_sigint) {
+        ret = mbedtls_net_poll(&srv->sock, MBEDTLS_NET_POLL_READ, POLL_TIMEOUT_MS);
+
+        while (ret > 0) {
+            n = mbedtls_net_recv_batch(&srv->sock, in, (size_t) opt.batch);
+            if (n < 0) {
+                if (n != MBEDTLS_ERR_SSL_WANT_READ && n != MBEDTLS_ERR_NET_CONN_RESET) {
+                    srv->errors++;
+                }
+                break;
+            }
+            srv->recv_calls++;
+            srv->dgrams_in += (unsigned long) n;
+
+            for (i = 0; i < n; i++) {
+                dispatch(srv, &in[i]);
+            }
+
+            /* Stop draining when the socket queue looks empty */
+            if (n < opt.batch) {
+                break;
+            }
+        }
+
+        check_timers(srv);
+        if (srv->out_count > 0) {
+            flush_out(srv);
+        }
+
+        now = now_ms(srv);
+        if (opt.report_interval > 0 &&
+            now - last_report >= (unsigned long) opt.report_interval * 1000) {
+            report(srv, now - last_report);
+            last_report = now;
+        }
+    }
+
+    exit_code = MBEDTLS_EXIT_SUCCESS;
+
+exit:
+
+#ifdef MBEDTLS_ERROR_C
+    if (ret < 0) {
+        char error_buf[100];
+        mbedtls_strerror(ret, error_buf, 100);
+        mbedtls_printf("Last error was: %d - %s\n\n", ret, error_buf);
+    }
+#endif
+
+    if (srv != NULL) {
+        while (srv->conns != NULL) {
+            conn_remove(srv, srv->conns);
+        }
+        mbedtls_ssl_demux_free(&srv->demux);
+        mbedtls_net_free(&srv->sock);
+        mbedtls_free(srv);
+    }
+    mbedtls_free(in_bufs);
+
+    mbedtls_x509_crt_free(&srvcert);
+    mbedtls_pk_free(&pkey);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_ssl_cookie_free(&cookie_ctx);
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+#if defined(MBEDTLS_USE_PSA_CRYPTO)
+    mbedtls_psa_crypto_free();
+#endif /* MBEDTLS_USE_PSA_CRYPTO */
+
+    mbedtls_exit(exit_code);
+}
+#endif /* MBEDTLS_ENTROPY_C && MBEDTLS_CTR_DRBG_C && MBEDTLS_NET_C &&
+          MBEDTLS_SSL_SRV_C && MBEDTLS_TIMING_C && MBEDTLS_SSL_PROTO_DTLS &&
+          MBEDTLS_SSL_COOKIE_C && MBEDTLS_SSL_DEMUX_C && MBEDTLS_PEM_PARSE_C &&
+          MBEDTLS_X509_CRT_PARSE_C */
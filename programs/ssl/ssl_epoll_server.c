@@ -0,0 +1,771 @@
+/*
+ *  SSL server demonstration program using epoll() to serve many clients
+ *  from a single thread with non-blocking I/O
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/platform.h"
+
+#if !defined(MBEDTLS_ENTROPY_C) || !defined(MBEDTLS_CTR_DRBG_C) ||      \
+    !defined(MBEDTLS_NET_C) || !defined(MBEDTLS_SSL_SRV_C) ||           \
+    !defined(MBEDTLS_PEM_PARSE_C) || !defined(MBEDTLS_X509_CRT_PARSE_C)
+int main(void)
+{
+    mbedtls_printf("MBEDTLS_ENTROPY_C and/or MBEDTLS_CTR_DRBG_C and/or "
+                   "MBEDTLS_NET_C and/or MBEDTLS_SSL_SRV_C and/or "
+                   "MBEDTLS_PEM_PARSE_C and/or MBEDTLS_X509_CRT_PARSE_C "
+                   "not defined.\n");
+    mbedtls_exit(0);
+}
+#elif !defined(__linux__)
+int main(void)
+{
+    mbedtls_printf("__linux__ not defined. This application requires epoll().\n");
+    mbedtls_exit(0);
+}
+#else
+
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "test/certs.h"
+#include "mbedtls/x509.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/error.h"
+#include "mbedtls/debug.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#define DFL_SERVER_ADDR         NULL
+#define DFL_SERVER_PORT         "4433"
+#define DFL_DEBUG_LEVEL         0
+#define DFL_MAX_CONNECTIONS     10000
+#define DFL_KEEP_ALIVE          0
+#define DFL_REPORT_INTERVAL     1
+#define DFL_DURATION            0
+#define DFL_BUFFER_POOL         0
+
+#define MAX_EVENTS              256
+#define MAX_LATENCY_SAMPLES     65536
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+#define USAGE_BUFFER_POOL \
+    "    buffer_pool=%%d      default: 0 (each connection keeps its buffers)\n" \
+    "                        1: share the I/O buffers of idle connections\n"
+#else
+#define USAGE_BUFFER_POOL ""
+#endif
+
+#define USAGE \
+    "\n usage: ssl_epoll_server param=<>...\n"                                \
+    "\n acceptable parameters:\n"                                             \
+    "    server_addr=%%s      default: (all interfaces)\n"                    \
+    "    server_port=%%d      default: " DFL_SERVER_PORT "\n"                 \
+    "    debug_level=%%d      default: 0 (disabled)\n"                        \
+    "    max_connections=%%d  default: 10000\n"                               \
+    "                        clients beyond this are disconnected at once\n"  \
+    "    keep_alive=%%d       default: 0 (one request per connection)\n"      \
+    "                        1: serve requests until the client closes\n"     \
+    "    report_interval=%%d  default: 1 (seconds between reports, 0: none)\n" \
+    "    duration=%%d         default: 0 (run until interrupted)\n"           \
+    USAGE_BUFFER_POOL                                                         \
+    "\n"
+
+#define HTTP_BODY \
+    "<h2>Mbed TLS Test Server</h2>\r\n" \
+    "<p>Successful connection</p>\r\n"
+
+/*
+ * global options
+ */
+struct options {
+    const char *server_addr;    /* address on which the ssl service runs    */
+    const char *server_port;    /* port on which the ssl service runs       */
+    int debug_level;            /* level of debugging                       */
+    int max_connections;        /* maximum number of open connections       */
+    int keep_alive;             /* serve several requests per connection    */
+    int report_interval;        /* seconds between two statistics reports   */
+    int duration;               /* seconds to run before exiting            */
+    int buffer_pool;            /* share the buffers of idle connections    */
+} opt;
+
+enum {
+    CONN_HANDSHAKE,             /* TLS handshake in progress                */
+    CONN_READ,                  /* reading a request                        */
+    CONN_WRITE,                 /* writing the response                     */
+    CONN_CLOSE_NOTIFY,          /* sending close_notify                     */
+};
+
+/* The connection was shut down cleanly and can be freed */
+#define CONN_DONE 1
+
+typedef struct connection {
+    mbedtls_net_context fd;
+    mbedtls_ssl_context ssl;
+    struct connection *prev, *next;     /* list of all the connections      */
+    int state;
+    uint32_t events;            /* events currently watched by epoll        */
+    uint64_t start_us;          /* accept time for the first request, then
+                                   arrival of the request, 0 if none yet    */
+    size_t written;             /* bytes of the response already written    */
+    unsigned char eoh;          /* bytes of "\r\n\r\n" matched so far       */
+} connection;
+
+/*
+ * Statistics, reset after each report except for the totals
+ */
+typedef struct {
+    unsigned long handshakes;
+    unsigned long requests;
+    unsigned long errors;
+    unsigned long rejected;
+    unsigned long total_handshakes;
+    unsigned long total_requests;
+    unsigned long active;
+    uint32_t *latency_us;
+    size_t latency_count;
+} server_stats;
+
+static unsigned char response[256];
+static size_t response_len;
+
+/* Live connections, freed on exit */
+static connection *connections = NULL;
+
+static volatile sig_atomic_t received_sigint = 0;
+
+static void handle_sigint(int sig)
+{
+    ((void) sig);
+    received_sigint = 1;
+}
+
+static void my_debug(void *ctx, int level,
+                     const char *file, int line,
+                     const char *str)
+{
+    ((void) level);
+
+    mbedtls_fprintf((FILE *) ctx, "%s:%04d: %s", file, line, str);
+    fflush((FILE *) ctx);
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of the sorted samples, in milliseconds */
+static double percentile_ms(const uint32_t *sorted, size_t n, unsigned pct)
+{
+    size_t rank;
+
+    if (n == 0) {
+        return 0.0;
+    }
+
+    rank = (n * pct + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0] / 1000.0;
+}
+
+static void report(server_stats *stats, double seconds, double elapsed)
+{
+    qsort(stats->latency_us, stats->latency_count, sizeof(uint32_t), cmp_u32);
+
+    mbedtls_printf("  . %8.1fs: %8.0f conn/s %8.0f req/s %7lu active, "
+                   "latency p50 %7.2f ms p99 %7.2f ms, %lu errors, %lu rejected\n",
+                   elapsed, stats->handshakes / seconds, stats->requests / seconds,
+                   stats->active,
+                   percentile_ms(stats->latency_us, stats->latency_count, 50),
+                   percentile_ms(stats->latency_us, stats->latency_count, 99),
+                   stats->errors, stats->rejected);
+    fflush(stdout);
+
+    stats->handshakes = 0;
+    stats->requests = 0;
+    stats->errors = 0;
+    stats->rejected = 0;
+    stats->latency_count = 0;
+}
+
+/*
+ * Look for the end of the request headers in the decrypted data, in place.
+ * Only the bytes up to the end of the request are consumed, so that the
+ * beginning of a pipelined request stays in the SSL context.
+ */
+static int conn_read_request(connection *conn)
+{
+    const unsigned char *p;
+    size_t len, i;
+    int ret;
+
+    do {
+        ret = mbedtls_ssl_read_peek(&conn->ssl, &p, &len);
+        if (ret != 0) {
+            return ret;
+        }
+        if (len == 0) {
+            return MBEDTLS_ERR_SSL_CONN_EOF;
+        }
+
+        if (conn->start_us == 0) {
+            conn->start_us = now_us();
+        }
+
+        for (i = 0; i < len && conn->eoh < 4; i++) {
+            if (p[i] == "\r\n\r\n"[conn->eoh]) {
+                conn->eoh++;
+            } else {
+                conn->eoh = (p[i] == '\r');
+            }
+        }
+
+        ret = mbedtls_ssl_read_consume(&conn->ssl, i);
+        if (ret != 0) {
+            return ret;
+        }
+    } while (conn->eoh < 4);
+
+    conn->eoh = 0;
+    return 0;
+}
+
+/*
+ * Make as much progress as possible on a connection. Returns CONN_DONE once
+ * the connection has been shut down, MBEDTLS_ERR_SSL_WANT_READ or
+ * MBEDTLS_ERR_SSL_WANT_WRITE when it has to wait for the socket, or
+ * another error.
+ */
+static int conn_process(connection *conn, server_stats *stats)
+{
+    int ret;
+
+    while (1) {
+        switch (conn->state) {
+            case CONN_HANDSHAKE:
+                ret = mbedtls_ssl_handshake(&conn->ssl);
+                if (ret != 0) {
+                    return ret;
+                }
+                stats->handshakes++;
+                stats->total_handshakes++;
+                conn->state = CONN_READ;
+                break;
+
+            case CONN_READ:
+                ret = conn_read_request(conn);
+                if (ret != 0) {
+                    return ret;
+                }
+                conn->written = 0;
+                conn->state = CONN_WRITE;
+                break;
+
+            case CONN_WRITE:
+                ret = mbedtls_ssl_write(&conn->ssl, response + conn->written,
+                                        response_len - conn->written);
+                if (ret < 0) {
+                    return ret;
+                }
+                conn->written += (size_t) ret;
+                if (conn->written < response_len) {
+                    break;
+                }
+
+                stats->requests++;
+                stats->total_requests++;
+                if (stats->latency_count < MAX_LATENCY_SAMPLES) {
+                    stats->latency_us[stats->latency_count++] =
+                        (uint32_t) (now_us() - conn->start_us);
+                }
+                conn->start_us = 0;
+
+                if (!opt.keep_alive) {
+                    conn->state = CONN_CLOSE_NOTIFY;
+                    break;
+                }
+
+                conn->state = CONN_READ;
+
+                /* epoll only reports data still in the socket. If the next
+                 * request has already been read into the SSL context, carry
+                 * on without waiting for the socket. */
+                if (mbedtls_ssl_get_bytes_avail(&conn->ssl) == 0 &&
+                    !mbedtls_ssl_check_pending(&conn->ssl)) {
+                    return MBEDTLS_ERR_SSL_WANT_READ;
+                }
+                break;
+
+            case CONN_CLOSE_NOTIFY:
+                ret = mbedtls_ssl_close_notify(&conn->ssl);
+                if (ret != 0) {
+                    return ret;
+                }
+                return CONN_DONE;
+
+            default:
+                return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+        }
+    }
+}
+
+static int conn_watch(int epfd, connection *conn, uint32_t events)
+{
+    struct epoll_event ev;
+
+    if (conn->events == events) {
+        return 0;
+    }
+
+    ev.events = events;
+    ev.data.ptr = conn;
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, conn->fd.fd, &ev) != 0) {
+        return -1;
+    }
+
+    conn->events = events;
+    return 0;
+}
+
+static void conn_free(connection *conn, server_stats *stats)
+{
+    if (conn->prev != NULL) {
+        conn->prev->next = conn->next;
+    } else {
+        connections = conn->next;
+    }
+    if (conn->next != NULL) {
+        conn->next->prev = conn->prev;
+    }
+
+    /* Closing the socket also removes it from the epoll set */
+    mbedtls_net_free(&conn->fd);
+    mbedtls_ssl_free(&conn->ssl);
+    mbedtls_free(conn);
+    stats->active--;
+}
+
+static void accept_connections(int epfd, mbedtls_net_context *listen_fd,
+                               mbedtls_ssl_config *conf, server_stats *stats)
+{
+    mbedtls_net_context client_fd;
+    connection *conn;
+    struct epoll_event ev;
+    int ret;
+
+    while (1) {
+        mbedtls_net_init(&client_fd);
+
+        ret = mbedtls_net_accept_nonblock(listen_fd, &client_fd, NULL, 0, NULL);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
+            return;
+        }
+        if (ret != 0) {
+            /* Most likely out of file descriptors: try again later */
+            stats->errors++;
+            return;
+        }
+
+        if (stats->active >= (unsigned long) opt.max_connections ||
+            (conn = mbedtls_calloc(1, sizeof(*conn))) == NULL) {
+            mbedtls_net_free(&client_fd);
+            stats->rejected++;
+            continue;
+        }
+
+        conn->fd = client_fd;
+        mbedtls_ssl_init(&conn->ssl);
+        conn->state = CONN_HANDSHAKE;
+        conn->start_us = now_us();
+
+        if (mbedtls_ssl_setup(&conn->ssl, conf) != 0) {
+            goto fail;
+        }
+
+        mbedtls_ssl_set_bio(&conn->ssl, &conn->fd, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+        /* The client speaks first */
+        ev.events = EPOLLIN;
+        ev.data.ptr = conn;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, conn->fd.fd, &ev) != 0) {
+            goto fail;
+        }
+        conn->events = EPOLLIN;
+
+        conn->next = connections;
+        if (connections != NULL) {
+            connections->prev = conn;
+        }
+        connections = conn;
+        stats->active++;
+        continue;
+
+fail:
+        stats->errors++;
+        mbedtls_net_free(&conn->fd);
+        mbedtls_ssl_free(&conn->ssl);
+        mbedtls_free(conn);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int ret = 1, i, n, epfd = -1;
+    int exit_code = MBEDTLS_EXIT_FAILURE;
+    mbedtls_net_context listen_fd;
+    const char *pers = "ssl_epoll_server";
+    char *p, *q;
+    struct epoll_event ev, events[MAX_EVENTS];
+    uint64_t start, now, last_report;
+    server_stats stats;
+
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt srvcert;
+    mbedtls_pk_context pkey;
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_buffer_pool pool;
+#endif
+
+    /*
+     * Make sure memory references are valid in case we exit early.
+     */
+    mbedtls_net_init(&listen_fd);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_pk_init(&pkey);
+    mbedtls_x509_crt_init(&srvcert);
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_buffer_pool_init(&pool);
+#endif
+    memset(&stats, 0, sizeof(stats));
+
+#if defined(MBEDTLS_USE_PSA_CRYPTO)
+    psa_status_t status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        mbedtls_fprintf(stderr, "Failed to initialize PSA Crypto implementation: %d\n",
+                        (int) status);
+        goto exit;
+    }
+#endif /* MBEDTLS_USE_PSA_CRYPTO */
+
+    opt.server_addr         = DFL_SERVER_ADDR;
+    opt.server_port         = DFL_SERVER_PORT;
+    opt.debug_level         = DFL_DEBUG_LEVEL;
+    opt.max_connections     = DFL_MAX_CONNECTIONS;
+    opt.keep_alive          = DFL_KEEP_ALIVE;
+    opt.report_interval     = DFL_REPORT_INTERVAL;
+    opt.duration            = DFL_DURATION;
+    opt.buffer_pool         = DFL_BUFFER_POOL;
+
+    for (i = 1; i < argc; i++) {
+        p = argv[i];
+        if ((q = strchr(p, '=')) == NULL) {
+            goto usage;
+        }
+        *q++ = '\0';
+
+        if (strcmp(p, "server_addr") == 0) {
+            opt.server_addr = q;
+        } else if (strcmp(p, "server_port") == 0) {
+            opt.server_port = q;
+        } else if (strcmp(p, "debug_level") == 0) {
+            opt.debug_level = atoi(q);
+            if (opt.debug_level < 0 || opt.debug_level > 65535) {
+                goto usage;
+            }
+        } else if (strcmp(p, "max_connections") == 0) {
+            opt.max_connections = atoi(q);
+            if (opt.max_connections < 1) {
+                goto usage;
+            }
+        } else if (strcmp(p, "keep_alive") == 0) {
+            opt.keep_alive = atoi(q);
+            if (opt.keep_alive < 0 || opt.keep_alive > 1) {
+                goto usage;
+            }
+        } else if (strcmp(p, "report_interval") == 0) {
+            opt.report_interval = atoi(q);
+            if (opt.report_interval < 0) {
+                goto usage;
+            }
+        } else if (strcmp(p, "duration") == 0) {
+            opt.duration = atoi(q);
+            if (opt.duration < 0) {
+                goto usage;
+            }
+        }
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+        else if (strcmp(p, "buffer_pool") == 0) {
+            opt.buffer_pool = atoi(q);
+            if (opt.buffer_pool < 0 || opt.buffer_pool > 1) {
+                goto usage;
+            }
+        }
+#endif
+        else {
+usage:
+            mbedtls_printf(USAGE);
+            goto exit;
+        }
+    }
+
+#if defined(MBEDTLS_DEBUG_C)
+    mbedtls_debug_set_threshold(opt.debug_level);
+#endif
+
+    stats.latency_us = mbedtls_calloc(MAX_LATENCY_SAMPLES, sizeof(uint32_t));
+    if (stats.latency_us == NULL) {
+        mbedtls_printf(" failed!  out of memory\n\n");
+        goto exit;
+    }
+
+    response_len = (size_t) mbedtls_snprintf((char *) response, sizeof(response),
+                                             "HTTP/1.1 200 OK\r\n"
+                                             "Content-Type: text/html\r\n"
+                                             "Content-Length: %d\r\n"
+                                             "Connection: %s\r\n\r\n%s",
+                                             (int) strlen(HTTP_BODY),
+                                             opt.keep_alive ? "keep-alive" : "close",
+                                             HTTP_BODY);
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, handle_sigint);
+
+    /*
+     * 0. Initial seeding of the RNG
+     */
+    mbedtls_printf("\n  . Initial seeding of the random generator...");
+    fflush(stdout);
+
+    if ((ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
+                                     (const unsigned char *) pers,
+                                     strlen(pers))) != 0) {
+        mbedtls_printf(" failed!  mbedtls_ctr_drbg_seed returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_printf(" ok\n");
+
+    /*
+     * 1. Load the certificates and private key
+     */
+    mbedtls_printf("  . Loading the server cert. and key...");
+    fflush(stdout);
+
+    /*
+     * This demonstration program uses embedded test certificates.
+     * Instead, you may want to use mbedtls_x509_crt_parse_file() to read the
+     * server and CA certificates, as well as mbedtls_pk_parse_keyfile().
+     */
+    ret = mbedtls_x509_crt_parse(&srvcert, (const unsigned char *) mbedtls_test_srv_crt,
+                                 mbedtls_test_srv_crt_len);
+    if (ret != 0) {
+        mbedtls_printf(" failed!  mbedtls_x509_crt_parse returned %d\n\n", ret);
+        goto exit;
+    }
+
+    ret = mbedtls_x509_crt_parse(&srvcert, (const unsigned char *) mbedtls_test_cas_pem,
+                                 mbedtls_test_cas_pem_len);
+    if (ret != 0) {
+        mbedtls_printf(" failed!  mbedtls_x509_crt_parse returned %d\n\n", ret);
+        goto exit;
+    }
+
+    ret =  mbedtls_pk_parse_key(&pkey, (const unsigned char *) mbedtls_test_srv_key,
+                                mbedtls_test_srv_key_len, NULL, 0,
+                                mbedtls_ctr_drbg_random, &ctr_drbg);
+    if (ret != 0) {
+        mbedtls_printf(" failed!  mbedtls_pk_parse_key returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_printf(" ok\n");
+
+    /*
+     * 2. Prepare SSL configuration
+     */
+    mbedtls_printf("  . Configuring SSL...");
+    fflush(stdout);
+
+    if ((ret = mbedtls_ssl_config_defaults(&conf,
+                                           MBEDTLS_SSL_IS_SERVER,
+                                           MBEDTLS_SSL_TRANSPORT_STREAM,
+                                           MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+        mbedtls_printf(" failed!  mbedtls_ssl_config_defaults returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+    mbedtls_ssl_conf_dbg(&conf, my_debug, stdout);
+
+    mbedtls_ssl_conf_ca_chain(&conf, srvcert.next, NULL);
+    if ((ret = mbedtls_ssl_conf_own_cert(&conf, &srvcert, &pkey)) != 0) {
+        mbedtls_printf(" failed!  mbedtls_ssl_conf_own_cert returned %d\n\n", ret);
+        goto exit;
+    }
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if (opt.buffer_pool) {
+        mbedtls_ssl_conf_buffer_pool(&conf, &pool);
+    }
+#endif
+
+    mbedtls_printf(" ok\n");
+
+    /*
+     * 3. Setup the listening TCP socket and the epoll set
+     */
+    mbedtls_printf("  . Bind on https://%s:%s/ ...",
+                   opt.server_addr != NULL ? opt.server_addr : "localhost",
+                   opt.server_port);
+    fflush(stdout);
+
+    if ((ret = mbedtls_net_bind(&listen_fd, opt.server_addr, opt.server_port,
+                                MBEDTLS_NET_PROTO_TCP)) != 0) {
+        mbedtls_printf(" failed!  mbedtls_net_bind returned %d\n\n", ret);
+        goto exit;
+    }
+
+    if ((ret = mbedtls_net_set_nonblock(&listen_fd)) != 0) {
+        mbedtls_printf(" failed!  mbedtls_net_set_nonblock returned %d\n\n", ret);
+        goto exit;
+    }
+
+    if ((epfd = epoll_create1(0)) < 0) {
+        mbedtls_printf(" failed!  epoll_create1 returned %d\n\n", errno);
+        goto exit;
+    }
+
+    /* Listening socket is the only one registered with a NULL pointer */
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd.fd, &ev) != 0) {
+        mbedtls_printf(" failed!  epoll_ctl returned %d\n\n", errno);
+        goto exit;
+    }
+
+    mbedtls_printf(" ok\n");
+
+    /*
+     * 4. Event loop
+     */
+    mbedtls_printf("  . Serving connections, press Ctrl-C to stop\n");
+    fflush(stdout);
+
+    start = last_report = now_us();
+
+    while (!received_sigint) {
+        int timeout = -1;
+
+        if (opt.report_interval > 0 || opt.duration > 0) {
+            timeout = 100;
+        }
+
+        n = epoll_wait(epfd, events, MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            mbedtls_printf("  ! epoll_wait returned %d\n\n", errno);
+            goto exit;
+        }
+
+        for (i = 0; i < n; i++) {
+            connection *conn = events[i].data.ptr;
+
+            if (conn == NULL) {
+                accept_connections(epfd, &listen_fd, &conf, &stats);
+                continue;
+            }
+
+            ret = conn_process(conn, &stats);
+            if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
+                ret = conn_watch(epfd, conn, EPOLLIN);
+            } else if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                ret = conn_watch(epfd, conn, EPOLLOUT);
+            } else if (ret != CONN_DONE &&
+                       ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY &&
+                       ret != MBEDTLS_ERR_SSL_CONN_EOF &&
+                       ret != MBEDTLS_ERR_NET_CONN_RESET) {
+                if (opt.debug_level > 0) {
+                    mbedtls_printf("  ! connection failed: -0x%04x\n", (unsigned int) -ret);
+                }
+                stats.errors++;
+            }
+
+            if (ret != 0) {
+                conn_free(conn, &stats);
+            }
+        }
+
+        now = now_us();
+        if (opt.report_interval > 0 &&
+            now - last_report >= (uint64_t) opt.report_interval * 1000000) {
+            report(&stats, (now - last_report) / 1e6, (now - start) / 1e6);
+            last_report = now;
+        }
+        if (opt.duration > 0 && now - start >= (uint64_t) opt.duration * 1000000) {
+            break;
+        }
+    }
+
+    now = now_us();
+    mbedtls_printf("\n  . Served %lu connections and %lu requests in %.1fs "
+                   "(%.0f conn/s)\n",
+                   stats.total_handshakes, stats.total_requests, (now - start) / 1e6,
+                   stats.total_handshakes / ((now - start) / 1e6));
+
+    exit_code = MBEDTLS_EXIT_SUCCESS;
+
+exit:
+    while (connections != NULL) {
+        conn_free(connections, &stats);
+    }
+    if (epfd >= 0) {
+        close(epfd);
+    }
+    mbedtls_net_free(&listen_fd);
+    mbedtls_free(stats.latency_us);
+    mbedtls_x509_crt_free(&srvcert);
+    mbedtls_pk_free(&pkey);
+    mbedtls_ssl_config_free(&conf);
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    mbedtls_ssl_buffer_pool_free(&pool);
+#endif
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+#if defined(MBEDTLS_USE_PSA_CRYPTO)
+    mbedtls_psa_crypto_free();
+#endif /* MBEDTLS_USE_PSA_CRYPTO */
+
+    mbedtls_exit(exit_code);
+}
+#endif /* MBEDTLS_ENTROPY_C && MBEDTLS_CTR_DRBG_C && MBEDTLS_NET_C &&
+          MBEDTLS_SSL_SRV_C && MBEDTLS_PEM_PARSE_C && MBEDTLS_X509_CRT_PARSE_C &&
+          __linux__ */
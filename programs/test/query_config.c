@@ -68,6 +68,7 @@
 #include "mbedtls/ssl_cache.h"
 #include "mbedtls/ssl_ciphersuites.h"
 #include "mbedtls/ssl_cookie.h"
+#include "mbedtls/ssl_demux.h"
 #include "mbedtls/ssl_ticket.h"
 #include "mbedtls/threading.h"
 #include "mbedtls/timing.h"
@@ -948,6 +949,22 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_ECP_RESTARTABLE */
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    if( strcmp( "MBEDTLS_ECP_GROUP_CACHE", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_ECP_GROUP_CACHE );
+        return( 0 );
+    }
+#endif /* MBEDTLS_ECP_GROUP_CACHE */
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+    if( strcmp( "MBEDTLS_ECP_PUBKEY_CACHE", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_ECP_PUBKEY_CACHE );
+        return( 0 );
+    }
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE */
+
 #if defined(MBEDTLS_ECP_WITH_MPI_UINT)
     if( strcmp( "MBEDTLS_ECP_WITH_MPI_UINT", config ) == 0 )
     {
@@ -1300,6 +1317,22 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    if( strcmp( "MBEDTLS_SSL_BUFFER_POOL", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SSL_BUFFER_POOL );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SSL_BUFFER_POOL */
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+    if( strcmp( "MBEDTLS_SSL_KEY_SHARE_POOL", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SSL_KEY_SHARE_POOL );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SSL_KEY_SHARE_POOL */
+
 #if defined(MBEDTLS_SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME)
     if( strcmp( "MBEDTLS_SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME", config ) == 0 )
     {
@@ -1572,6 +1605,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_VERSION_FEATURES */
 
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    if( strcmp( "MBEDTLS_X509_TRUSTED_CA_INDEX", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_X509_TRUSTED_CA_INDEX );
+        return( 0 );
+    }
+#endif /* MBEDTLS_X509_TRUSTED_CA_INDEX */
+
 #if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
     if( strcmp( "MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK", config ) == 0 )
     {
@@ -2044,6 +2085,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_SHA1_C */
 
+#if defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+    if( strcmp( "MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT */
+
 #if defined(MBEDTLS_SHA224_C)
     if( strcmp( "MBEDTLS_SHA224_C", config ) == 0 )
     {
@@ -2092,6 +2141,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_SHA256_USE_A64_CRYPTO_ONLY */
 
+#if defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
+    if( strcmp( "MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT */
+
 #if defined(MBEDTLS_SHA384_C)
     if( strcmp( "MBEDTLS_SHA384_C", config ) == 0 )
     {
@@ -2148,6 +2205,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_SSL_COOKIE_C */
 
+#if defined(MBEDTLS_SSL_DEMUX_C)
+    if( strcmp( "MBEDTLS_SSL_DEMUX_C", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SSL_DEMUX_C );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SSL_DEMUX_C */
+
 #if defined(MBEDTLS_SSL_TICKET_C)
     if( strcmp( "MBEDTLS_SSL_TICKET_C", config ) == 0 )
     {
@@ -2412,6 +2477,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_ECP_FIXED_POINT_OPTIM */
 
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE_SIZE)
+    if( strcmp( "MBEDTLS_ECP_PUBKEY_CACHE_SIZE", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_ECP_PUBKEY_CACHE_SIZE );
+        return( 0 );
+    }
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE_SIZE */
+
 #if defined(MBEDTLS_ENTROPY_MAX_SOURCES)
     if( strcmp( "MBEDTLS_ENTROPY_MAX_SOURCES", config ) == 0 )
     {
@@ -2732,6 +2805,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES */
 
+#if defined(MBEDTLS_SSL_CACHE_SHARDS)
+    if( strcmp( "MBEDTLS_SSL_CACHE_SHARDS", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SSL_CACHE_SHARDS );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SSL_CACHE_SHARDS */
+
 #if defined(MBEDTLS_SSL_IN_CONTENT_LEN)
     if( strcmp( "MBEDTLS_SSL_IN_CONTENT_LEN", config ) == 0 )
     {
@@ -2772,6 +2853,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_SSL_OUT_CONTENT_LEN */
 
+#if defined(MBEDTLS_SSL_OUT_BUFFER_RECORDS)
+    if( strcmp( "MBEDTLS_SSL_OUT_BUFFER_RECORDS", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SSL_OUT_BUFFER_RECORDS );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SSL_OUT_BUFFER_RECORDS */
+
 #if defined(MBEDTLS_SSL_DTLS_MAX_BUFFERING)
     if( strcmp( "MBEDTLS_SSL_DTLS_MAX_BUFFERING", config ) == 0 )
     {
@@ -2780,6 +2869,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_SSL_DTLS_MAX_BUFFERING */
 
+#if defined(MBEDTLS_SSL_DTLS_REPLAY_WINDOW)
+    if( strcmp( "MBEDTLS_SSL_DTLS_REPLAY_WINDOW", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SSL_DTLS_REPLAY_WINDOW );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SSL_DTLS_REPLAY_WINDOW */
+
 #if defined(MBEDTLS_PSK_MAX_LEN)
     if( strcmp( "MBEDTLS_PSK_MAX_LEN", config ) == 0 )
     {
@@ -2796,6 +2893,14 @@ int query_config(const char *config)
     }
 #endif /* MBEDTLS_SSL_COOKIE_TIMEOUT */
 
+#if defined(MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN)
+    if( strcmp( "MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN", config ) == 0 )
+    {
+        MACRO_EXPANSION_TO_STR( MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN );
+        return( 0 );
+    }
+#endif /* MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN */
+
 #if defined(MBEDTLS_SSL_MAX_EARLY_DATA_SIZE)
     if( strcmp( "MBEDTLS_SSL_MAX_EARLY_DATA_SIZE", config ) == 0 )
     {
@@ -3974,6 +4079,14 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_ECP_RESTARTABLE);
 #endif /* MBEDTLS_ECP_RESTARTABLE */
 
+#if defined(MBEDTLS_ECP_GROUP_CACHE)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_ECP_GROUP_CACHE);
+#endif /* MBEDTLS_ECP_GROUP_CACHE */
+
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_ECP_PUBKEY_CACHE);
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE */
+
 #if defined(MBEDTLS_ECP_WITH_MPI_UINT)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_ECP_WITH_MPI_UINT);
 #endif /* MBEDTLS_ECP_WITH_MPI_UINT */
@@ -4150,6 +4263,14 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_ASYNC_PRIVATE);
 #endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_BUFFER_POOL);
+#endif /* MBEDTLS_SSL_BUFFER_POOL */
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_POOL)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_KEY_SHARE_POOL);
+#endif /* MBEDTLS_SSL_KEY_SHARE_POOL */
+
 #if defined(MBEDTLS_SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME);
 #endif /* MBEDTLS_SSL_CLI_ALLOW_WEAK_CERTIFICATE_VERIFICATION_WITHOUT_HOSTNAME */
@@ -4286,6 +4407,10 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_VERSION_FEATURES);
 #endif /* MBEDTLS_VERSION_FEATURES */
 
+#if defined(MBEDTLS_X509_TRUSTED_CA_INDEX)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_X509_TRUSTED_CA_INDEX);
+#endif /* MBEDTLS_X509_TRUSTED_CA_INDEX */
+
 #if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK);
 #endif /* MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK */
@@ -4522,6 +4647,10 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SHA1_C);
 #endif /* MBEDTLS_SHA1_C */
 
+#if defined(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT);
+#endif /* MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT */
+
 #if defined(MBEDTLS_SHA224_C)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SHA224_C);
 #endif /* MBEDTLS_SHA224_C */
@@ -4546,6 +4675,10 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SHA256_USE_A64_CRYPTO_ONLY);
 #endif /* MBEDTLS_SHA256_USE_A64_CRYPTO_ONLY */
 
+#if defined(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT);
+#endif /* MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT */
+
 #if defined(MBEDTLS_SHA384_C)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SHA384_C);
 #endif /* MBEDTLS_SHA384_C */
@@ -4574,6 +4707,10 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_COOKIE_C);
 #endif /* MBEDTLS_SSL_COOKIE_C */
 
+#if defined(MBEDTLS_SSL_DEMUX_C)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_DEMUX_C);
+#endif /* MBEDTLS_SSL_DEMUX_C */
+
 #if defined(MBEDTLS_SSL_TICKET_C)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_TICKET_C);
 #endif /* MBEDTLS_SSL_TICKET_C */
@@ -4706,6 +4843,10 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_ECP_FIXED_POINT_OPTIM);
 #endif /* MBEDTLS_ECP_FIXED_POINT_OPTIM */
 
+#if defined(MBEDTLS_ECP_PUBKEY_CACHE_SIZE)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_ECP_PUBKEY_CACHE_SIZE);
+#endif /* MBEDTLS_ECP_PUBKEY_CACHE_SIZE */
+
 #if defined(MBEDTLS_ENTROPY_MAX_SOURCES)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_ENTROPY_MAX_SOURCES);
 #endif /* MBEDTLS_ENTROPY_MAX_SOURCES */
@@ -4866,6 +5007,10 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES);
 #endif /* MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES */
 
+#if defined(MBEDTLS_SSL_CACHE_SHARDS)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_CACHE_SHARDS);
+#endif /* MBEDTLS_SSL_CACHE_SHARDS */
+
 #if defined(MBEDTLS_SSL_IN_CONTENT_LEN)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_IN_CONTENT_LEN);
 #endif /* MBEDTLS_SSL_IN_CONTENT_LEN */
@@ -4886,10 +5031,18 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_OUT_CONTENT_LEN);
 #endif /* MBEDTLS_SSL_OUT_CONTENT_LEN */
 
+#if defined(MBEDTLS_SSL_OUT_BUFFER_RECORDS)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_OUT_BUFFER_RECORDS);
+#endif /* MBEDTLS_SSL_OUT_BUFFER_RECORDS */
+
 #if defined(MBEDTLS_SSL_DTLS_MAX_BUFFERING)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_DTLS_MAX_BUFFERING);
 #endif /* MBEDTLS_SSL_DTLS_MAX_BUFFERING */
 
+#if defined(MBEDTLS_SSL_DTLS_REPLAY_WINDOW)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_DTLS_REPLAY_WINDOW);
+#endif /* MBEDTLS_SSL_DTLS_REPLAY_WINDOW */
+
 #if defined(MBEDTLS_PSK_MAX_LEN)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_PSK_MAX_LEN);
 #endif /* MBEDTLS_PSK_MAX_LEN */
@@ -4898,6 +5051,10 @@ void list_config(void)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_COOKIE_TIMEOUT);
 #endif /* MBEDTLS_SSL_COOKIE_TIMEOUT */
 
+#if defined(MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN)
+    OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN);
+#endif /* MBEDTLS_SSL_DEMUX_ADDR_MAX_LEN */
+
 #if defined(MBEDTLS_SSL_MAX_EARLY_DATA_SIZE)
     OUTPUT_MACRO_NAME_VALUE(MBEDTLS_SSL_MAX_EARLY_DATA_SIZE);
 #endif /* MBEDTLS_SSL_MAX_EARLY_DATA_SIZE */
@@ -819,6 +819,19 @@ component_test_everest_curve25519_only () {
     make test
 }
 
+component_test_ecp_group_cache_no_fixed_point_optim () {
+    msg "build: full + ECP caches, MBEDTLS_ECP_FIXED_POINT_OPTIM=0 (ASan build)"
+    scripts/config.py full
+    scripts/config.py set MBEDTLS_ECP_FIXED_POINT_OPTIM 0
+    scripts/config.py set MBEDTLS_ECP_GROUP_CACHE
+    scripts/config.py set MBEDTLS_ECP_PUBKEY_CACHE
+    CC=$ASAN_CC cmake -D CMAKE_BUILD_TYPE:String=Asan .
+    make
+
+    msg "test: full + ECP caches, MBEDTLS_ECP_FIXED_POINT_OPTIM=0 (ASan build)"
+    make test
+}
+
 component_test_psa_collect_statuses () {
   msg "build+test: psa_collect_statuses" # ~30s
   scripts/config.py full
@@ -1003,6 +1016,9 @@ component_build_module_alt () {
     # MBEDTLS_SHA256_*ALT can't be used with MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_*
     scripts/config.py unset MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT
     scripts/config.py unset MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_ONLY
+    # MBEDTLS_SHA1/256_*ALT can't be used with MBEDTLS_SHA1/256_USE_X86_SHA_NI_*
+    scripts/config.py unset MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT
+    scripts/config.py unset MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT
     # MBEDTLS_SHA512_*ALT can't be used with MBEDTLS_SHA512_USE_A64_CRYPTO_*
     scripts/config.py unset MBEDTLS_SHA512_USE_A64_CRYPTO_IF_PRESENT
     scripts/config.py unset MBEDTLS_SHA512_USE_A64_CRYPTO_ONLY
@@ -2353,9 +2369,11 @@ config_psa_crypto_hash_use_psa () {
         scripts/config.py unset MBEDTLS_MD5_C
         scripts/config.py unset MBEDTLS_RIPEMD160_C
         scripts/config.py unset MBEDTLS_SHA1_C
+        scripts/config.py unset MBEDTLS_SHA1_USE_X86_SHA_NI_IF_PRESENT
         scripts/config.py unset MBEDTLS_SHA224_C
         scripts/config.py unset MBEDTLS_SHA256_C # see external RNG below
         scripts/config.py unset MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT
+        scripts/config.py unset MBEDTLS_SHA256_USE_X86_SHA_NI_IF_PRESENT
         scripts/config.py unset MBEDTLS_SHA384_C
         scripts/config.py unset MBEDTLS_SHA512_C
         scripts/config.py unset MBEDTLS_SHA512_USE_A64_CRYPTO_IF_PRESENT
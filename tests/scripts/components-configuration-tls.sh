@@ -470,6 +470,21 @@ component_test_small_ssl_in_content_len () {
     tests/ssl-opt.sh -f "Max fragment"
 }
 
+component_test_ssl_larger_tunables () {
+    msg "build: several records per output buffer, sharded session cache, wide DTLS replay window (ASan build)"
+    scripts/config.py set MBEDTLS_SSL_OUT_BUFFER_RECORDS 4
+    scripts/config.py set MBEDTLS_SSL_CACHE_SHARDS 4
+    scripts/config.py set MBEDTLS_SSL_DTLS_REPLAY_WINDOW 1024
+    CC=$ASAN_CC cmake -D CMAKE_BUILD_TYPE:String=Asan .
+    make
+
+    msg "test: MBEDTLS_SSL_OUT_BUFFER_RECORDS=4, MBEDTLS_SSL_CACHE_SHARDS=4, MBEDTLS_SSL_DTLS_REPLAY_WINDOW=1024"
+    make test
+
+    msg "test: ssl-opt.sh, MBEDTLS_SSL_OUT_BUFFER_RECORDS=4, MBEDTLS_SSL_CACHE_SHARDS=4, MBEDTLS_SSL_DTLS_REPLAY_WINDOW=1024"
+    tests/ssl-opt.sh -f "Large packet\|Session resume\|DTLS"
+}
+
 component_test_small_ssl_dtls_max_buffering () {
     msg "build: small MBEDTLS_SSL_DTLS_MAX_BUFFERING #0"
     scripts/config.py set MBEDTLS_SSL_DTLS_MAX_BUFFERING 1000
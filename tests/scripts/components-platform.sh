@@ -198,6 +198,48 @@ component_build_aes_armce () {
     not grep -E 'aes[0-9a-z]+.[0-9]\s*[qv]' library/aesce.s
 }
 
+support_build_armce_kernels () {
+    # clang >= 11 is required to build with AES extensions
+    [[ $(clang_version) -ge 11 ]]
+}
+
+component_build_armce_kernels () {
+    # Build the multi-block AES, stitched AES-GCM, Neon ChaCha20 and radix
+    # 2^44 Poly1305 code for Arm. There is no arm64 CI node to run them, but
+    # this catches code that does not compile or has warnings.
+    scripts/config.py set MBEDTLS_AESCE_C
+    scripts/config.py set MBEDTLS_GCM_C
+    scripts/config.py set MBEDTLS_CHACHA20_C
+    scripts/config.py set MBEDTLS_POLY1305_C
+
+    msg "AESCE kernels, clang, aarch64"
+    make -B library/aes.o library/gcm.o library/aesce.o library/aesce.s CC=clang CFLAGS="--target=aarch64-linux-gnu -march=armv8-a+crypto -Werror"
+    msg "clang, test aarch64 multi-block and stitched kernels built"
+    grep -q mbedtls_aesce_crypt_ecb_blocks library/aesce.s
+    grep -q mbedtls_aesce_gcm_crypt_blocks library/aesce.s
+
+    msg "AESCE kernels, clang, arm"
+    make -B library/aes.o library/gcm.o library/aesce.o library/aesce.s CC=clang CFLAGS="--target=arm-linux-gnueabihf -mcpu=cortex-a72+crypto -marm -Werror"
+    msg "clang, test A32 multi-block and stitched kernels built"
+    grep -q mbedtls_aesce_crypt_ecb_blocks library/aesce.s
+    grep -q mbedtls_aesce_gcm_crypt_blocks library/aesce.s
+
+    msg "Neon ChaCha20, clang, aarch64"
+    make -B library/chacha20.o library/chacha20.s CC=clang CFLAGS="--target=aarch64-linux-gnu -march=armv8-a -Werror"
+    msg "clang, test aarch64 Neon ChaCha20 built"
+    grep -E 'add\s+v[0-9]+\.4s' library/chacha20.s
+
+    msg "Neon ChaCha20, clang, arm"
+    make -B library/chacha20.o library/chacha20.s CC=clang CFLAGS="--target=arm-linux-gnueabihf -mcpu=cortex-a72 -mfpu=neon -marm -Werror"
+    msg "clang, test A32 Neon ChaCha20 built"
+    grep -E 'vadd\.i32\s+q' library/chacha20.s
+
+    msg "Radix 2^44 Poly1305, clang, aarch64"
+    make -B library/poly1305.o library/poly1305.s CC=clang CFLAGS="--target=aarch64-linux-gnu -march=armv8-a -Werror"
+    msg "clang, test aarch64 64x64-bit Poly1305 multiplications built"
+    grep -E 'umulh\s+x' library/poly1305.s
+}
+
 support_build_sha_armce () {
     # clang >= 4 is required to build with SHA extensions
     [[ $(clang_version) -ge 4 ]]